@@ -14,12 +14,15 @@ CompositionRoot::CompositionRoot() {
     oauthClient_ = std::make_unique<auth::OAuthClient>(*tokenStore_, nam_.get(), nullptr);
     apiClient_ = std::make_unique<auth::YandexDiskApiClient>(*tokenStore_, nam_.get(), nullptr);
     treeRepo_ = std::make_unique<disk_tree::ApiTreeRepository>(*apiClient_);
+    treeCacheStore_ = std::make_unique<disk_tree::TreeCacheStore>();
+    treeCacheStore_->open(disk_tree::TreeCacheStore::pathNextTo(JsonConfig::syncIndexDbPath()));
+    cachedTreeRepo_ = std::make_unique<disk_tree::CachingTreeRepository>(*treeRepo_, treeCacheStore_.get());
     quotaService_ = std::make_unique<disk_tree::ApiQuotaService>(*apiClient_);
     settingsStore_ = std::make_unique<settings::MockSettingsStore>();
     selectedStore_ = std::make_unique<settings::MockSelectedNodesStore>();
     diskResourceClient_ = std::make_unique<sync::DiskResourceClient>(*apiClient_);
 
-    loadTree_ = std::make_unique<disk_tree::LoadTreeUseCase>(*treeRepo_);
+    loadTree_ = std::make_unique<disk_tree::LoadTreeUseCase>(*cachedTreeRepo_);
     getQuota_ = std::make_unique<disk_tree::GetQuotaUseCase>(*quotaService_);
     getSettings_ = std::make_unique<settings::GetSettingsUseCase>(*settingsStore_);
     saveSettings_ = std::make_unique<settings::SaveSettingsUseCase>(*settingsStore_);
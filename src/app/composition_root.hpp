@@ -9,6 +9,8 @@
 #include <disk_tree/application/load_tree_use_case.hpp>
 #include <disk_tree/infrastructure/api_quota_service.hpp>
 #include <disk_tree/infrastructure/api_tree_repository.hpp>
+#include <disk_tree/infrastructure/caching_tree_repository.hpp>
+#include <disk_tree/infrastructure/tree_cache_store.hpp>
 #include <settings/application/get_settings_use_case.hpp>
 #include <settings/application/save_settings_use_case.hpp>
 #include <settings/application/toggle_node_selection_use_case.hpp>
@@ -34,7 +36,8 @@ struct CompositionRoot {
     auth::TokenStore& tokenStore() { return *tokenStore_; }
     auth::OAuthClient& oauthClient() { return *oauthClient_; }
     disk_tree::LoadTreeUseCase& loadTreeUseCase() { return *loadTree_; }
-    disk_tree::ITreeRepository& treeRepository() { return *treeRepo_; }
+    disk_tree::ITreeRepository& treeRepository() { return *cachedTreeRepo_; }
+    disk_tree::CachingTreeRepository& treeCache() { return *cachedTreeRepo_; }
     disk_tree::GetQuotaUseCase& getQuotaUseCase() { return *getQuota_; }
     settings::GetSettingsUseCase& getSettingsUseCase() { return *getSettings_; }
     settings::SaveSettingsUseCase& saveSettingsUseCase() { return *saveSettings_; }
@@ -55,6 +58,8 @@ private:
     std::unique_ptr<auth::OAuthClient> oauthClient_;
     std::unique_ptr<auth::YandexDiskApiClient> apiClient_;
     std::unique_ptr<disk_tree::ApiTreeRepository> treeRepo_;
+    std::unique_ptr<disk_tree::TreeCacheStore> treeCacheStore_;
+    std::unique_ptr<disk_tree::CachingTreeRepository> cachedTreeRepo_;
     std::unique_ptr<disk_tree::ApiQuotaService> quotaService_;
     std::unique_ptr<settings::MockSettingsStore> settingsStore_;
     std::unique_ptr<settings::MockSelectedNodesStore> selectedStore_;
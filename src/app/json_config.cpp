@@ -52,6 +52,15 @@ static JsonConfig loadFromFile(const QString& path) {
     c.syncFolder = o.value(QStringLiteral("sync_folder")).toString();
     int mr = o.value(QStringLiteral("sync_max_retries")).toInt(3);
     c.maxRetries = (mr > 0 && mr <= 100) ? mr : 3;
+    int pd = o.value(QStringLiteral("sync_max_parallel_downloads")).toInt(4);
+    c.maxParallelDownloads = (pd >= 1 && pd <= 16) ? pd : 4;
+    int pu = o.value(QStringLiteral("sync_max_parallel_uploads")).toInt(4);
+    c.maxParallelUploads = (pu >= 1 && pu <= 16) ? pu : 4;
+    int cr = o.value(QStringLiteral("sync_index_commit_rows")).toInt(64);
+    c.indexCommitRows = (cr >= 1 && cr <= 10000) ? cr : 64;
+    int cm = o.value(QStringLiteral("sync_index_commit_ms")).toInt(1000);
+    c.indexCommitMs = (cm >= 0 && cm <= 60000) ? cm : 1000;
+    c.directUploads = o.value(QStringLiteral("sync_direct_uploads")).toBool(true);
     int rr = o.value(QStringLiteral("refresh_interval_sec")).toInt(60);
     c.refreshIntervalSec = (rr >= 5 && rr <= 3600) ? rr : 60;
     int pt = o.value(QStringLiteral("poll_time_sec")).toInt(120);
@@ -86,6 +95,11 @@ static bool saveToFile(const QString& path, const JsonConfig& c) {
     o.insert(QStringLiteral("splitter_state"), QString::fromUtf8(c.splitterState.toBase64()));
     o.insert(QStringLiteral("sync_folder"), c.syncFolder);
     o.insert(QStringLiteral("sync_max_retries"), c.maxRetries);
+    o.insert(QStringLiteral("sync_max_parallel_downloads"), c.maxParallelDownloads);
+    o.insert(QStringLiteral("sync_max_parallel_uploads"), c.maxParallelUploads);
+    o.insert(QStringLiteral("sync_index_commit_rows"), c.indexCommitRows);
+    o.insert(QStringLiteral("sync_index_commit_ms"), c.indexCommitMs);
+    o.insert(QStringLiteral("sync_direct_uploads"), c.directUploads);
     o.insert(QStringLiteral("refresh_interval_sec"), c.refreshIntervalSec);
     o.insert(QStringLiteral("poll_time_sec"), c.pollTimeSec);
     o.insert(QStringLiteral("hide_to_tray"), c.hideToTray);
@@ -18,6 +18,11 @@ struct JsonConfig {
     QByteArray splitterState;
     QString syncFolder;
     int maxRetries = 3;
+    int maxParallelDownloads = 4;
+    int maxParallelUploads = 4;
+    int indexCommitRows = 64;
+    int indexCommitMs = 1000;
+    bool directUploads = true;
     int refreshIntervalSec = 60;
     int pollTimeSec = 120;
     bool hideToTray = true;
@@ -9,6 +9,7 @@
 #include "shared/cloud_path_util.hpp"
 #include "json_config.hpp"
 #include "settings/domain/app_settings.hpp"
+#include "sync/infrastructure/sync_index.hpp"
 #include "shared/app_log.hpp"
 #include <QAction>
 #include <QApplication>
@@ -46,12 +47,16 @@ static void loadConfigIntoApp(ydisquette::CompositionRoot& root, ydisquette::Mai
         ydisquette::settings::AppSettings s = root.getSettingsUseCase().run();
         if (!c.syncFolder.isEmpty()) s.syncPath = c.syncFolder.toStdString();
         if (c.maxRetries >= 1 && c.maxRetries <= 100) s.maxRetries = c.maxRetries;
+        if (c.maxParallelDownloads >= 1 && c.maxParallelDownloads <= 16) s.maxParallelDownloads = c.maxParallelDownloads;
+        if (c.maxParallelUploads >= 1 && c.maxParallelUploads <= 16) s.maxParallelUploads = c.maxParallelUploads;
+        s.directUploads = c.directUploads;
         if (c.refreshIntervalSec >= 5 && c.refreshIntervalSec <= 3600) s.refreshIntervalSec = c.refreshIntervalSec;
         if (c.pollTimeSec >= 60 && c.pollTimeSec <= 3600) s.pollTimeSec = c.pollTimeSec;
         s.hideToTray = c.hideToTray;
         s.closeToTray = c.closeToTray;
         root.saveSettingsUseCase().run(s);
     }
+    ydisquette::sync::SyncIndex::setDefaultCommitPolicy({c.indexCommitRows, c.indexCommitMs});
     if (!c.selectedNodePaths.isEmpty()) {
         std::vector<std::string> paths;
         for (const QString& s : c.selectedNodePaths) {
@@ -76,6 +81,9 @@ static bool saveConfigFromApp(ydisquette::CompositionRoot& root, ydisquette::Mai
     ydisquette::settings::AppSettings s = root.getSettingsUseCase().run();
     c.syncFolder = QString::fromStdString(s.syncPath);
     c.maxRetries = s.maxRetries;
+    c.maxParallelDownloads = s.maxParallelDownloads;
+    c.maxParallelUploads = s.maxParallelUploads;
+    c.directUploads = s.directUploads;
     c.refreshIntervalSec = s.refreshIntervalSec;
     c.pollTimeSec = s.pollTimeSec;
     c.hideToTray = s.hideToTray;
@@ -6,6 +6,7 @@
 #include "settings/domain/app_settings.hpp"
 #include <disk_tree/domain/node.hpp>
 #include <disk_tree/domain/quota.hpp>
+#include <sync/application/sync_path_mapper.hpp>
 #include <sync/infrastructure/disk_resource_client.hpp>
 #include <sync/infrastructure/sync_service.hpp>
 #include <sync/infrastructure/sync_index.hpp>
@@ -48,7 +49,7 @@ namespace ydisquette {
 
 enum { PathRole = Qt::UserRole, IsDirRole = Qt::UserRole + 1, IsPlaceholderRole = Qt::UserRole + 2 };
 
-static QString utf8(const std::string& s) {
+static QString utf8(std::string_view s) {
     return QString::fromUtf8(s.data(), static_cast<int>(s.size()));
 }
 
@@ -207,6 +208,14 @@ MainContentWidget::MainContentWidget(CompositionRoot& root, QWidget* parent)
         pollTimer_->start();
     }
     QTimer::singleShot(0, this, &MainContentWidget::tryStartPoll);
+    root_->treeCache().setOnRevalidated([this](const std::string&) {
+        if (cacheRefreshPending_) return;
+        cacheRefreshPending_ = true;
+        QTimer::singleShot(200, this, [this]() {
+            cacheRefreshPending_ = false;
+            loadAndDisplay();
+        });
+    });
     ui_->treeLabel_->hide();
     ui_->quotaProgressBar_->setMinimum(0);
     ui_->quotaProgressBar_->setMaximum(100);
@@ -245,6 +254,7 @@ static void addNewFilesUnderDir(sync::SyncIndex& idx, const QString& syncRoot, c
         if (cfi.isDir()) {
             addNewFilesUnderDir(idx, syncRoot, childPath, childRel);
         } else {
+            if (sync::isPartialDownloadPath(name)) continue;
             if (idx.get(syncRoot, childRel).has_value()) continue;
             idx.upsertNew(syncRoot, childRel, cfi.lastModified().toSecsSinceEpoch(), cfi.size());
         }
@@ -257,14 +267,14 @@ static void markDeletedLocallyAsToDelete(sync::SyncIndex& idx, const QString& sy
         QStringList top = idx.getTopLevelRelativePaths(syncRoot);
         for (const QString& rel : top) {
             if (!QFileInfo(localRoot + rel).exists()) {
-                idx.setStatusPrefix(syncRoot, rel, QString::fromUtf8(sync::FileStatus::TO_DELETE));
+                idx.setStatusPrefix(syncRoot, rel, sync::FileStatus::TO_DELETE);
             }
         }
     } else {
         QStringList under = idx.getRelativePathsUnderPrefixExcept(syncRoot, baseRel, {});
         for (const QString& rel : under) {
             if (!QFileInfo(localRoot + rel).exists()) {
-                idx.setStatusPrefix(syncRoot, rel, QString::fromUtf8(sync::FileStatus::TO_DELETE));
+                idx.setStatusPrefix(syncRoot, rel, sync::FileStatus::TO_DELETE);
             }
         }
     }
@@ -283,8 +293,8 @@ void MainContentWidget::onSyncPathChanged(const QString& path) {
             QFileInfo fi(path);
             if (!fi.exists()) {
                 if (!baseRel.isEmpty() && idx.hasAnyWithPrefix(syncRoot, baseRel))
-                    idx.setStatusPrefix(syncRoot, baseRel, QString::fromUtf8(sync::FileStatus::TO_DELETE));
-            } else if (fi.isFile() && !baseRel.isEmpty()) {
+                    idx.setStatusPrefix(syncRoot, baseRel, sync::FileStatus::TO_DELETE);
+            } else if (fi.isFile() && !baseRel.isEmpty() && !sync::isPartialDownloadPath(baseRel)) {
                 if (!idx.get(syncRoot, baseRel).has_value())
                     idx.upsertNew(syncRoot, baseRel, fi.lastModified().toSecsSinceEpoch(), fi.size());
             } else if (fi.isDir()) {
@@ -307,8 +317,8 @@ void MainContentWidget::onSyncLocalDebounce() {
     if (!syncRoot.isEmpty()) {
         sync::SyncIndex idx;
         if (idx.open(root_->getSyncIndexDbPath())) {
-            QStringList newPaths = idx.getRelativePathsWithStatus(syncRoot, QString::fromUtf8(sync::FileStatus::NEW));
-            QStringList toDeletePaths = idx.getRelativePathsWithStatus(syncRoot, QString::fromUtf8(sync::FileStatus::TO_DELETE));
+            QStringList newPaths = idx.getRelativePathsWithStatus(syncRoot, sync::FileStatus::NEW);
+            QStringList toDeletePaths = idx.getRelativePathsWithStatus(syncRoot, sync::FileStatus::TO_DELETE);
             idx.close();
             if (newPaths.isEmpty() && toDeletePaths.isEmpty())
                 return;
@@ -316,10 +326,12 @@ void MainContentWidget::onSyncLocalDebounce() {
     }
     auto token = root_->tokenProvider().getAccessToken();
     if (!token || token->empty()) return;
-    root_->syncService().startSyncLocalToCloud(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+    root_->syncService().startSyncLocalToCloud(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelUploads, settings.directUploads);
 }
 
 MainContentWidget::~MainContentWidget() {
+    if (root_) root_->treeCache().setOnRevalidated(nullptr);
     delete ui_;
 }
 
@@ -344,25 +356,26 @@ static void insertPlaceholderRow(QStandardItem* nameItem) {
 }
 
 void MainContentWidget::appendChildrenToRow(QStandardItem* nameItem, const std::string& path) {
-    root_->treeRepository().getChildrenAsync(path, [this, nameItem](std::vector<std::shared_ptr<disk_tree::Node>> children) {
+    root_->treeRepository().getChildrenAsync(path, [this, nameItem](disk_tree::NodeList children) {
         appendChildrenToRowFromData(nameItem, children);
     });
 }
 
 void MainContentWidget::appendChildrenToRowFromData(QStandardItem* nameItem,
-    const std::vector<std::shared_ptr<disk_tree::Node>>& children) {
+    const disk_tree::NodeList& children) {
     std::vector<std::string> selectedPaths = root_->getSelectedPaths();
     QIcon dirIcon = themeIcon(this, {"folder", "folder-open", "inode-directory"}, QStyle::SP_DirIcon);
-    for (const auto& c : children) {
-        if (!c->isDir()) continue;
-        QString name = utf8(c->name.empty() ? c->path : c->name);
+    for (disk_tree::NodeRef c : children) {
+        if (!c.isDir()) continue;
+        const std::string path = c.path();
+        QString name = utf8(c.name().empty() ? std::string_view(path) : c.name());
         QStandardItem* nameCol = new QStandardItem(dirIcon, name);
-        nameCol->setData(utf8(c->path), PathRole);
+        nameCol->setData(utf8(path), PathRole);
         nameCol->setData(true, IsDirRole);
         nameCol->setEditable(false);
         nameCol->setCheckable(true);
         treeModel_->blockSignals(true);
-        nameCol->setCheckState(checkStateForPath(c->path, selectedPaths));
+        nameCol->setCheckState(checkStateForPath(path, selectedPaths));
         treeModel_->blockSignals(false);
         insertPlaceholderRow(nameCol);
         QStandardItem* sizeCol = new QStandardItem;
@@ -479,7 +492,8 @@ void MainContentWidget::runUncheckCleanupAndRestart(const std::string& pathStr)
         auto settings = root_->getSettingsUseCase().run();
         auto token = root_->tokenProvider().getAccessToken();
         if (!settings.syncPath.empty() && token && !token->empty()) {
-            root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+            root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelDownloads);
         }
     }
 }
@@ -525,36 +539,38 @@ void MainContentWidget::setPathChecked(const QString& path, bool checked) {
     updateSyncIndicator();
 }
 
-static QJsonArray nodesToJsonArray(const std::vector<std::shared_ptr<disk_tree::Node>>& nodes,
+static QJsonArray nodesToJsonArray(const disk_tree::NodeList& nodes,
                                    const std::vector<std::string>& selectedPaths) {
     QJsonArray arr;
-    for (const auto& c : nodes) {
-        if (!c->isDir()) continue;
+    for (disk_tree::NodeRef c : nodes) {
+        if (!c.isDir()) continue;
+        const std::string path = c.path();
         QJsonObject o;
-        o.insert(QStringLiteral("name"), utf8(c->name.empty() ? c->path : c->name));
-        o.insert(QStringLiteral("path"), utf8(c->path));
+        o.insert(QStringLiteral("name"), utf8(c.name().empty() ? std::string_view(path) : c.name()));
+        o.insert(QStringLiteral("path"), utf8(path));
         o.insert(QStringLiteral("dir"), true);
-        bool checked = isPathCheckedForDisplay(c->path, selectedPaths);
+        bool checked = isPathCheckedForDisplay(path, selectedPaths);
         o.insert(QStringLiteral("checked"), checked);
         arr.append(o);
     }
     return arr;
 }
 
-static QJsonArray contentsToJsonArray(const std::vector<std::shared_ptr<disk_tree::Node>>& nodes,
+static QJsonArray contentsToJsonArray(const disk_tree::NodeList& nodes,
                                       const std::vector<std::string>& selectedPaths) {
     QJsonArray arr;
-    for (const auto& c : nodes) {
+    for (disk_tree::NodeRef c : nodes) {
+        const std::string path = c.path();
         QJsonObject o;
-        o.insert(QStringLiteral("name"), utf8(c->name.empty() ? c->path : c->name));
-        o.insert(QStringLiteral("path"), utf8(c->path));
-        o.insert(QStringLiteral("dir"), c->isDir());
-        if (c->isDir()) {
-            bool checked = isPathCheckedForDisplay(c->path, selectedPaths);
+        o.insert(QStringLiteral("name"), utf8(c.name().empty() ? std::string_view(path) : c.name()));
+        o.insert(QStringLiteral("path"), utf8(path));
+        o.insert(QStringLiteral("dir"), c.isDir());
+        if (c.isDir()) {
+            bool checked = isPathCheckedForDisplay(path, selectedPaths);
             o.insert(QStringLiteral("checked"), checked);
         } else {
-            o.insert(QStringLiteral("size"), static_cast<qint64>(c->size));
-            o.insert(QStringLiteral("modified"), utf8(c->modified));
+            o.insert(QStringLiteral("size"), static_cast<qint64>(c.size()));
+            o.insert(QStringLiteral("modified"), utf8(c.modified()));
         }
         arr.append(o);
     }
@@ -566,7 +582,7 @@ void MainContentWidget::requestChildrenForPath(const QString& path) {
     std::string pathStr = path.toStdString();
     if (pathStr == "disk:/" || pathStr == "disk:") pathStr = "/";
     const std::string pathForApi = pathStr;
-    root_->treeRepository().getChildrenAsync(pathForApi, [this, path](std::vector<std::shared_ptr<disk_tree::Node>> children) {
+    root_->treeRepository().getChildrenAsync(pathForApi, [this, path](disk_tree::NodeList children) {
         std::vector<std::string> sel = root_->getSelectedPaths();
         QJsonArray arr = nodesToJsonArray(children, sel);
         QByteArray json = QJsonDocument(arr).toJson(QJsonDocument::Compact);
@@ -579,7 +595,7 @@ void MainContentWidget::requestContentsForPath(const QString& path) {
     std::string pathStr = path.toStdString();
     if (pathStr == "disk:/" || pathStr == "disk:") pathStr = "/";
     const std::string pathForApi = pathStr;
-    root_->treeRepository().getChildrenAsync(pathForApi, [this, path](std::vector<std::shared_ptr<disk_tree::Node>> children) {
+    root_->treeRepository().getChildrenAsync(pathForApi, [this, path](disk_tree::NodeList children) {
         std::vector<std::string> sel = root_->getSelectedPaths();
         QJsonArray arr = contentsToJsonArray(children, sel);
         QByteArray json = QJsonDocument(arr).toJson(QJsonDocument::Compact);
@@ -637,7 +653,7 @@ void MainContentWidget::loadAndDisplay(const std::vector<std::string>& ensureSel
         sizeCol->setEditable(false);
         insertPlaceholderRow(nameCol);
         treeModel_->appendRow({nameCol, sizeCol});
-        root_->treeRepository().getChildrenAsync(rootNode->path, [this, nameCol, gen, ensureNormalized, expandedPaths](std::vector<std::shared_ptr<disk_tree::Node>> children) {
+        root_->treeRepository().getChildrenAsync(rootNode->path, [this, nameCol, gen, ensureNormalized, expandedPaths](disk_tree::NodeList children) {
             if (loadGeneration_ != gen) return;
             nameCol->removeRow(0);
             appendChildrenToRowFromData(nameCol, children);
@@ -681,9 +697,11 @@ void MainContentWidget::onIndexStateLoaded(sync::IndexState state) {
     if (paths.empty() || settings.syncPath.empty()) return;
     if (root_->syncService().getStatus() == sync::SyncStatus::Syncing) return;
     if (state.toDownloadCount > 0 || state.cloudDeletedCount > 0)
-        root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+        root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelDownloads);
     if (state.toDeleteCount > 0)
-        root_->syncService().startSyncLocalToCloud(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+        root_->syncService().startSyncLocalToCloud(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelUploads, settings.directUploads);
 }
 
 void MainContentWidget::onScanCompleted() {
@@ -691,7 +709,8 @@ void MainContentWidget::onScanCompleted() {
     std::vector<std::string> paths = root_->getSelectedPaths();
     auto settings = root_->getSettingsUseCase().run();
     if (!paths.empty() && !settings.syncPath.empty())
-        root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+        root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelDownloads);
 }
 
 void MainContentWidget::onSyncIndexCheckTimer() {
@@ -732,6 +751,7 @@ void MainContentWidget::onPathsCreatedInCloud(const std::vector<std::string>& cl
     if (cloudPaths.empty()) return;
     std::vector<std::string> sel = root_->getSelectedPaths();
     for (const std::string& p : cloudPaths) {
+        root_->treeCache().invalidate(p);
         std::string n = ydisquette::normalizeCloudPath(p);
         if (std::find(sel.begin(), sel.end(), n) == sel.end())
             sel.push_back(n);
@@ -752,7 +772,8 @@ void MainContentWidget::onPathsCreatedInCloud(const std::vector<std::string>& cl
         if (!paths.empty() && !settings.syncPath.empty()) {
             auto token = root_->tokenProvider().getAccessToken();
             if (token && !token->empty())
-                root_->syncService().startSyncLocalToCloud(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+                root_->syncService().startSyncLocalToCloud(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelUploads, settings.directUploads);
         }
     });
 }
@@ -766,7 +787,7 @@ void MainContentWidget::onItemExpanded(const QModelIndex& index) {
     if (path.isEmpty()) return;
     nameItem->removeRow(0);
     const quint64 gen = loadGeneration_;
-    root_->treeRepository().getChildrenAsync(path.toStdString(), [this, nameItem, gen](std::vector<std::shared_ptr<disk_tree::Node>> children) {
+    root_->treeRepository().getChildrenAsync(path.toStdString(), [this, nameItem, gen](disk_tree::NodeList children) {
         if (loadGeneration_ != gen) {
             insertPlaceholderRow(nameItem);
             return;
@@ -804,6 +825,7 @@ void MainContentWidget::onItemChanged(QStandardItem* item) {
 
 void MainContentWidget::onStopSyncTriggered() {
     root_->syncService().stopSync();
+    root_->pollService().stopPoll();
 }
 
 void MainContentWidget::setStopSyncAction(QAction* action) {
@@ -841,6 +863,9 @@ QString MainContentWidget::getSettingsJson() const {
     QJsonObject o;
     o.insert(QStringLiteral("syncPath"), QString::fromStdString(s.syncPath));
     o.insert(QStringLiteral("maxRetries"), s.maxRetries);
+    o.insert(QStringLiteral("maxParallelDownloads"), s.maxParallelDownloads);
+    o.insert(QStringLiteral("maxParallelUploads"), s.maxParallelUploads);
+    o.insert(QStringLiteral("directUploads"), s.directUploads);
     o.insert(QStringLiteral("refreshIntervalSec"), s.refreshIntervalSec);
     o.insert(QStringLiteral("hideToTray"), s.hideToTray);
     o.insert(QStringLiteral("closeToTray"), s.closeToTray);
@@ -889,6 +914,12 @@ bool MainContentWidget::saveSettingsFromJson(const QString& json) {
         s.syncPath = proposedSyncPath;
     if (o.contains(QStringLiteral("maxRetries")))
         s.maxRetries = o.value(QStringLiteral("maxRetries")).toInt(3);
+    if (o.contains(QStringLiteral("maxParallelDownloads")))
+        s.maxParallelDownloads = std::clamp(o.value(QStringLiteral("maxParallelDownloads")).toInt(4), 1, 16);
+    if (o.contains(QStringLiteral("maxParallelUploads")))
+        s.maxParallelUploads = std::clamp(o.value(QStringLiteral("maxParallelUploads")).toInt(4), 1, 16);
+    if (o.contains(QStringLiteral("directUploads")))
+        s.directUploads = o.value(QStringLiteral("directUploads")).toBool(true);
     if (o.contains(QStringLiteral("refreshIntervalSec")))
         s.refreshIntervalSec = std::clamp(o.value(QStringLiteral("refreshIntervalSec")).toInt(60), kRefreshIntervalMin, kRefreshIntervalMax);
     if (o.contains(QStringLiteral("hideToTray")))
@@ -898,6 +929,9 @@ bool MainContentWidget::saveSettingsFromJson(const QString& json) {
     root_->saveSettingsUseCase().run(s);
     JsonConfig c = JsonConfig::load();
     c.syncFolder = QString::fromStdString(s.syncPath);
+    c.maxParallelDownloads = s.maxParallelDownloads;
+    c.maxParallelUploads = s.maxParallelUploads;
+    c.directUploads = s.directUploads;
     c.refreshIntervalSec = s.refreshIntervalSec;
     c.hideToTray = s.hideToTray;
     c.closeToTray = s.closeToTray;
@@ -995,7 +1029,8 @@ void MainContentWidget::onSyncClicked() {
             tr("Please sign in first (restart the app and sign in if needed)."));
         return;
     }
-    root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+    root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelDownloads);
 }
 
 void MainContentWidget::onSyncStatusChanged(sync::SyncStatus status) {
@@ -1014,6 +1049,7 @@ void MainContentWidget::onSyncStatusChanged(sync::SyncStatus status) {
         runUncheckCleanupAndRestart(pendingUncheckPath_);
     }
     if (status == sync::SyncStatus::Idle && wasSyncing) {
+        root_->treeCache().markAllStale();
         if (skipNextIdleRefresh_) {
             skipNextIdleRefresh_ = false;
         } else {
@@ -1038,7 +1074,7 @@ void MainContentWidget::onTokenExpired() {
         auto settings = root_->getSettingsUseCase().run();
         if (!paths.empty() && !settings.syncPath.empty()) {
             root_->syncService().startSync(paths, settings.syncPath,
-                root_->getSyncIndexDbPath(), settings.maxRetries);
+                root_->getSyncIndexDbPath(), settings.maxRetries, settings.maxParallelDownloads);
         }
     } else {
         QMessageBox::warning(this, tr("Synchronize"),
@@ -1060,6 +1096,7 @@ void MainContentWidget::onTreeSelectionChanged() {
     QModelIndexList sel = ui_->treeView_->selectionModel()->selectedRows(0);
     contentsModel_->removeRows(0, contentsModel_->rowCount());
     currentFolderPath_.clear();
+    ++contentsGeneration_;
     if (sel.isEmpty()) return;
     QModelIndex idx = sel.front();
     QStandardItem* nameItem = treeModel_->itemFromIndex(idx);
@@ -1067,23 +1104,34 @@ void MainContentWidget::onTreeSelectionChanged() {
     QString path = nameItem->data(PathRole).toString();
     if (path.isEmpty() || !nameItem->data(IsDirRole).toBool()) return;
     currentFolderPath_ = path;
-    root_->treeRepository().getChildrenAsync(path.toStdString(), [this](std::vector<std::shared_ptr<disk_tree::Node>> children) {
-        setContentsFromNodes(children);
+    loadContentsList();
+}
+
+void MainContentWidget::loadContentsList() {
+    const quint64 gen = ++contentsGeneration_;
+    auto firstPage = std::make_shared<bool>(true);
+    root_->treeRepository().getChildrenPagedAsync(currentFolderPath_.toStdString(), [this, gen, firstPage](disk_tree::ChildrenPage page) {
+        if (contentsGeneration_ != gen) return;
+        if (*firstPage) {
+            contentsModel_->removeRows(0, contentsModel_->rowCount());
+            *firstPage = false;
+        }
+        appendContentsFromNodes(page.items);
     });
 }
 
-void MainContentWidget::setContentsFromNodes(const std::vector<std::shared_ptr<disk_tree::Node>>& children) {
-    contentsModel_->removeRows(0, contentsModel_->rowCount());
+void MainContentWidget::appendContentsFromNodes(const disk_tree::NodeList& children) {
     QIcon dirIcon = themeIcon(this, {"folder", "folder-open", "inode-directory"}, QStyle::SP_DirIcon);
     QIcon fileIcon = themeIcon(this, {"document", "text-x-generic"}, QStyle::SP_FileIcon);
-    for (const auto& c : children) {
-        QString name = utf8(c->name.empty() ? c->path : c->name);
-        QStandardItem* item = new QStandardItem(c->isDir() ? dirIcon : fileIcon, name);
+    for (disk_tree::NodeRef c : children) {
+        const std::string path = c.path();
+        QString name = c.name().empty() ? utf8(path) : utf8(c.name());
+        QStandardItem* item = new QStandardItem(c.isDir() ? dirIcon : fileIcon, name);
         item->setEditable(false);
-        item->setData(utf8(c->path), PathRole);
-        item->setData(c->isDir(), IsDirRole);
-        QString tip = c->isFile() ? tr("%1 · %2").arg(formatBytes(c->size)).arg(utf8(c->modified))
-                                  : utf8(c->modified);
+        item->setData(utf8(path), PathRole);
+        item->setData(c.isDir(), IsDirRole);
+        QString tip = c.isFile() ? tr("%1 · %2").arg(formatBytes(c.size())).arg(utf8(c.modified()))
+                                 : utf8(c.modified());
         if (!tip.isEmpty()) item->setToolTip(tip);
         contentsModel_->appendRow(item);
     }
@@ -1091,9 +1139,7 @@ void MainContentWidget::setContentsFromNodes(const std::vector<std::shared_ptr<d
 
 void MainContentWidget::refreshContentsList() {
     if (currentFolderPath_.isEmpty()) return;
-    root_->treeRepository().getChildrenAsync(currentFolderPath_.toStdString(), [this](std::vector<std::shared_ptr<disk_tree::Node>> children) {
-        setContentsFromNodes(children);
-    });
+    loadContentsList();
 }
 
 void MainContentWidget::refreshQuotaLabel() {
@@ -1122,8 +1168,11 @@ void MainContentWidget::onInternetCheckFinished() {
     online_ = ok;
     if (wasOffline && online_)
         tryResumeSyncAfterOnline();
-    else if (!online_ && syncStatus_ == sync::SyncStatus::Syncing)
-        root_->syncService().stopSync();
+    else if (!online_) {
+        if (syncStatus_ == sync::SyncStatus::Syncing)
+            root_->syncService().stopSync();
+        root_->pollService().stopPoll();
+    }
     internetCheckReply_.clear();
     reply->deleteLater();
     updateSyncIndicator();
@@ -1137,7 +1186,8 @@ void MainContentWidget::tryResumeSyncAfterOnline() {
     if (paths.empty() || settings.syncPath.empty()) return;
     auto token = root_->tokenProvider().getAccessToken();
     if (!token || token->empty()) return;
-    root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries);
+    root_->syncService().startSync(paths, settings.syncPath, root_->getSyncIndexDbPath(), settings.maxRetries,
+                settings.maxParallelDownloads);
 }
 
 void MainContentWidget::onSyncThroughput(qint64 bytesPerSecond) {
@@ -1356,10 +1406,11 @@ void MainContentWidget::onContentsContextMenuRequested(const QPoint& pos) {
                 tr("Delete «%1» from Yandex.Disk?").arg(path),
                 QMessageBox::Yes | QMessageBox::No, QMessageBox::No) != QMessageBox::Yes)
             return;
-        root_->deleteResourceUseCase().runAsync(path.toStdString(), [this](sync::DiskResourceResult r) {
+        root_->deleteResourceUseCase().runAsync(path.toStdString(), [this, path](sync::DiskResourceResult r) {
             if (!r.success)
                 QMessageBox::warning(this, tr("Delete error"), r.errorMessage.isEmpty() ? tr("Failed to delete.") : r.errorMessage);
             else {
+                root_->treeCache().invalidate(path.toStdString());
                 refreshContentsList();
                 refreshQuotaLabel();
             }
@@ -1416,8 +1467,9 @@ void MainContentWidget::deleteFromDisk(const QString& cloudPath) {
         emit deleteFinished(false, tr("Invalid path."));
         return;
     }
-    root_->deleteResourceUseCase().runAsync(cloudPath.toStdString(), [this](sync::DiskResourceResult r) {
+    root_->deleteResourceUseCase().runAsync(cloudPath.toStdString(), [this, cloudPath](sync::DiskResourceResult r) {
         if (r.success) {
+            root_->treeCache().invalidate(cloudPath.toStdString());
             refreshQuotaLabel();
         }
         emit deleteFinished(r.success, r.errorMessage.isEmpty() ? tr("Failed to delete.") : r.errorMessage);
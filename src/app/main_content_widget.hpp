@@ -1,6 +1,7 @@
 #pragma once
 
 #include <disk_tree/domain/node.hpp>
+#include <disk_tree/domain/node_list.hpp>
 #include <disk_tree/domain/quota.hpp>
 #include <sync/domain/sync_status.hpp>
 #include <sync/infrastructure/sync_index.hpp>
@@ -108,9 +109,9 @@ private:
     void loadAndDisplay();
     void loadAndDisplay(const std::vector<std::string>& ensureSelectedPaths);
     void appendChildrenToRow(QStandardItem* nameItem, const std::string& path);
-    void appendChildrenToRowFromData(QStandardItem* nameItem,
-                                     const std::vector<std::shared_ptr<disk_tree::Node>>& children);
-    void setContentsFromNodes(const std::vector<std::shared_ptr<disk_tree::Node>>& children);
+    void appendChildrenToRowFromData(QStandardItem* nameItem, const disk_tree::NodeList& children);
+    void loadContentsList();
+    void appendContentsFromNodes(const disk_tree::NodeList& children);
     void refreshContentsList();
     void refreshQuotaLabel();
     void updateStatusBar(const disk_tree::Quota& q);
@@ -145,7 +146,9 @@ private:
     QString lastSyncError_;
     QString lastSyncProgressMessage_;
     quint64 loadGeneration_ = 0;
+    quint64 contentsGeneration_ = 0;
     bool skipNextIdleRefresh_ = false;
+    bool cacheRefreshPending_ = false;
     bool scanInProgress_ = false;
     QAction* stopSyncAction_ = nullptr;
     QAction* syncAction_ = nullptr;
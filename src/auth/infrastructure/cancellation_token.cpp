@@ -0,0 +1,14 @@
+#include "auth/infrastructure/cancellation_token.hpp"
+
+namespace ydisquette {
+namespace auth {
+
+CancellationToken::CancellationToken(QObject* parent) : QObject(parent) {}
+
+void CancellationToken::cancel() {
+    if (!cancelled_.exchange(true))
+        emit cancelled();
+}
+
+}  // namespace auth
+}  // namespace ydisquette
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QObject>
+#include <atomic>
+
+namespace ydisquette {
+namespace auth {
+
+class CancellationToken : public QObject {
+    Q_OBJECT
+public:
+    explicit CancellationToken(QObject* parent = nullptr);
+
+    void cancel();
+    void reset() { cancelled_ = false; }
+    bool isCancelled() const { return cancelled_.load(); }
+
+signals:
+    void cancelled();
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+}  // namespace auth
+}  // namespace ydisquette
@@ -1,7 +1,9 @@
 #include "auth/infrastructure/ssl_ignoring_network_access_manager.hpp"
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QSslConfiguration>
 #include <QSslError>
+#include <memory>
 
 namespace ydisquette {
 namespace auth {
@@ -12,10 +14,30 @@ SslIgnoringNetworkAccessManager::SslIgnoringNetworkAccessManager(QObject* parent
 QNetworkReply* SslIgnoringNetworkAccessManager::createRequest(Operation op,
                                                               const QNetworkRequest& request,
                                                               QIODevice* outgoingData) {
-    QNetworkReply* reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+    QNetworkRequest req(request);
+    req.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    if (req.url().scheme() == QLatin1String("https")) {
+        QSslConfiguration ssl = req.sslConfiguration();
+        ssl.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+        req.setSslConfiguration(ssl);
+    }
+    QNetworkReply* reply = QNetworkAccessManager::createRequest(op, req, outgoingData);
     connect(reply, &QNetworkReply::sslErrors, reply, [reply](const QList<QSslError>&) {
         reply->ignoreSslErrors();
     });
+    ++requestCount_;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    auto connected = std::make_shared<bool>(false);
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [this, connected]() {
+        if (*connected) return;
+        *connected = true;
+        ++newConnectionCount_;
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply, connected]() {
+        if (!*connected && reply->error() != QNetworkReply::OperationCanceledError)
+            ++reusedConnectionCount_;
+    });
+#endif
     return reply;
 }
 
@@ -10,9 +10,18 @@ class SslIgnoringNetworkAccessManager : public QNetworkAccessManager {
 public:
     explicit SslIgnoringNetworkAccessManager(QObject* parent = nullptr);
 
+    qint64 requestCount() const { return requestCount_; }
+    qint64 newConnectionCount() const { return newConnectionCount_; }
+    qint64 reusedConnectionCount() const { return reusedConnectionCount_; }
+
 protected:
     QNetworkReply* createRequest(Operation op, const QNetworkRequest& request,
                                  QIODevice* outgoingData) override;
+
+private:
+    qint64 requestCount_ = 0;
+    qint64 newConnectionCount_ = 0;
+    qint64 reusedConnectionCount_ = 0;
 };
 
 }  // namespace auth
@@ -1,240 +1,425 @@
 #include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include <QBuffer>
 #include <QEventLoop>
 #include <QNetworkReply>
+#include <QTimer>
 #include <QUrl>
 #include <QUrlQuery>
 #include <QDateTime>
+#include <QFile>
+#include <filesystem>
 #include <functional>
+#include <memory>
 
 namespace ydisquette {
 namespace auth {
 
 const char YandexDiskApiClient::kBaseUrl[] = "https://cloud-api.yandex.net/v1/disk";
+const char YandexDiskApiClient::kProbeFields[] = "path";
+const char YandexDiskApiClient::kListingFields[] =
+    "_embedded.items.type,_embedded.items.path,_embedded.items.name,_embedded.items.modified,"
+    "_embedded.items.size,_embedded.total";
+const char YandexDiskApiClient::kLastUploadedFields[] = "items.type,items.path,items.modified,items.size";
+const char YandexDiskApiClient::kTrashFields[] =
+    "path,origin_path,type,deleted,_embedded.items.path,_embedded.items.origin_path,"
+    "_embedded.items.type,_embedded.items.deleted";
+const char YandexDiskApiClient::kStatFields[] = "size,md5";
+const char YandexDiskApiClient::kFilePathFields[] = "items.path";
+const char YandexDiskApiClient::kFileEntryFields[] = "items.path,items.size,items.modified";
+const char YandexDiskApiClient::kTempDownloadSuffix[] = ".download";
+const qint64 YandexDiskApiClient::kDownloadChunkSize = 256 * 1024;
+const int YandexDiskApiClient::kRequestTimeoutMs = 30000;
+const int YandexDiskApiClient::kTransferStallTimeoutMs = 900000;
 static const QByteArray kSpoofedUserAgent =
     QByteArrayLiteral("Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 "
                       "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36");
 
-YandexDiskApiClient::YandexDiskApiClient(ITokenProvider const& tokenProvider,
-                                         QNetworkAccessManager* nam,
-                                         QObject* parent)
-    : QObject(parent), tokenProvider_(tokenProvider), nam_(nam) {}
+namespace {
 
-ApiResponse YandexDiskApiClient::get(const std::string& path, const QUrlQuery& query) const {
-    auto token = tokenProvider_.getAccessToken();
-    if (!token || token->empty()) {
-        return {401, ""};
-    }
+const char kTimedOutProperty[] = "ydTimedOut";
 
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + path));
-    if (!query.isEmpty()) url.setQuery(query);
+QString replyErrorString(QNetworkReply* reply) {
+    if (reply->property(kTimedOutProperty).toBool())
+        return QStringLiteral("Request timed out");
+    return reply->errorString();
+}
+
+ApiResponse readReply(QNetworkReply* reply) {
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    QByteArray body = reply->readAll();
+    if (reply->error() != QNetworkReply::NoError && body.isEmpty())
+        body = replyErrorString(reply).toUtf8();
+    return {status, body};
+}
 
+QNetworkRequest apiRequest(const QUrl& url, const std::string& token) {
     QNetworkRequest req(url);
-    req.setTransferTimeout(30000);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
     req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
+    req.setRawHeader("Authorization", ("OAuth " + token).c_str());
     req.setRawHeader("User-Agent", kSpoofedUserAgent);
+    return req;
+}
 
-    QNetworkReply* reply = nam_->get(req);
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+QNetworkRequest downloadRequest(const QString& absoluteUrl, const std::string& token) {
+    QNetworkRequest req{QUrl(absoluteUrl)};
+    req.setTransferTimeout(YandexDiskApiClient::kTransferStallTimeoutMs);
+    req.setRawHeader("Accept", "application/octet-stream");
+    req.setRawHeader("Accept-Encoding", "identity");
+    req.setRawHeader("Authorization", ("OAuth " + token).c_str());
+    req.setRawHeader("User-Agent", kSpoofedUserAgent);
+    return req;
+}
 
+struct FileSink {
+    QFile file;
+    QByteArray chunk;
+    QString error;
+    QString targetPath;
+    bool keepPartial = false;
+    qint64 resumeFrom = 0;
+    qint64 rangeLength = -1;
+    qint64 base = 0;
+    qint64 expectedSize = -1;
+    qint64 written = 0;
+};
+
+bool checkContentRange(QNetworkReply* reply, FileSink* sink) {
+    const QByteArray expected = "bytes " + QByteArray::number(sink->resumeFrom) + '-';
+    if (reply->rawHeader("Content-Range").startsWith(expected)) return true;
+    sink->error = QStringLiteral("Unexpected Content-Range: ") + QString::fromLatin1(reply->rawHeader("Content-Range"));
+    return false;
+}
+
+bool openSink(QNetworkReply* reply, FileSink* sink) {
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    std::string body = reply->readAll().toStdString();
-    if (reply->error() != QNetworkReply::NoError && body.empty())
-        body = reply->errorString().toStdString();
-    reply->deleteLater();
-    return {status, body};
+    if (sink->rangeLength >= 0) {
+        if (status != 206) {
+            sink->error = QStringLiteral("Range request answered with HTTP %1").arg(status);
+            return false;
+        }
+        if (!checkContentRange(reply, sink)) return false;
+        return sink->file.open(QIODevice::ReadWrite) && sink->file.seek(sink->resumeFrom);
+    }
+    const QVariant contentLength = reply->header(QNetworkRequest::ContentLengthHeader);
+    if (status != 206 || sink->resumeFrom <= 0) {
+        sink->base = 0;
+        if (contentLength.isValid()) sink->expectedSize = contentLength.toLongLong();
+        return sink->file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!checkContentRange(reply, sink)) return false;
+    if (!sink->file.resize(sink->resumeFrom))
+        return false;
+    sink->base = sink->resumeFrom;
+    if (contentLength.isValid()) sink->expectedSize = sink->base + contentLength.toLongLong();
+    return sink->file.open(QIODevice::WriteOnly | QIODevice::Append);
 }
 
-ApiResponse YandexDiskApiClient::getByFullUrl(const QString& fullUrlWithQuery) const {
-    auto token = tokenProvider_.getAccessToken();
-    if (!token || token->empty()) {
-        return {401, ""};
+// Moves a finished part file over the download target in one rename, so the target is either the
+// previous file or the complete new one. A failed download leaves the target untouched.
+void commitSink(bool succeeded, FileSink* sink) {
+    if (sink->targetPath.isEmpty()) return;
+    if (succeeded) {
+        std::error_code ec;
+        std::filesystem::rename(sink->file.filesystemFileName(), QFile(sink->targetPath).filesystemFileName(), ec);
+        if (!ec) return;
+        sink->error = QStringLiteral("Cannot rename %1: %2")
+                          .arg(sink->file.fileName(), QString::fromLocal8Bit(ec.message().c_str()));
     }
-    QUrl url(fullUrlWithQuery);
+    if (!sink->keepPartial) sink->file.remove();
+}
 
-    QNetworkRequest req(url);
-    req.setTransferTimeout(30000);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
+void drainToFile(QNetworkReply* reply, FileSink* sink) {
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status < 200 || status >= 300 || !sink->error.isEmpty()) return;
+    if (!sink->file.isOpen() && !openSink(reply, sink)) {
+        if (sink->error.isEmpty()) sink->error = sink->file.errorString();
+        reply->abort();
+        return;
+    }
+    if (sink->chunk.isEmpty())
+        sink->chunk.resize(static_cast<int>(YandexDiskApiClient::kDownloadChunkSize));
+    while (reply->bytesAvailable() > 0) {
+        const qint64 n = reply->read(sink->chunk.data(), sink->chunk.size());
+        if (n <= 0) break;
+        if (sink->rangeLength >= 0 && sink->written + n > sink->rangeLength) {
+            sink->error = QStringLiteral("Range response longer than requested");
+            reply->abort();
+            return;
+        }
+        if (sink->file.write(sink->chunk.constData(), n) != n) {
+            sink->error = sink->file.errorString();
+            reply->abort();
+            return;
+        }
+        sink->written += n;
+    }
+}
+
+ApiResponse finishFileDownload(QNetworkReply* reply, FileSink* sink) {
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    drainToFile(reply, sink);
+    ApiResponse res{status, ""};
+    if (res.ok() && sink->error.isEmpty() && !sink->file.isOpen() && !openSink(reply, sink)
+        && sink->error.isEmpty())
+        sink->error = sink->file.errorString();
+    if (res.ok() && sink->error.isEmpty() && sink->rangeLength >= 0 && sink->written != sink->rangeLength)
+        sink->error = QStringLiteral("Short range response: %1 of %2 bytes").arg(sink->written).arg(sink->rangeLength);
+    if (res.ok() && sink->error.isEmpty() && sink->expectedSize >= 0 && sink->base + sink->written != sink->expectedSize)
+        sink->error = QStringLiteral("Short response: %1 of %2 bytes").arg(sink->base + sink->written).arg(sink->expectedSize);
+    sink->file.close();
+    commitSink(res.ok() && sink->error.isEmpty() && reply->error() == QNetworkReply::NoError, sink);
+    if (!sink->error.isEmpty()) {
+        res.statusCode = 0;
+        res.body = sink->error.toUtf8();
+    } else if (!res.ok()) {
+        res.body = reply->readAll();
+        if (res.body.isEmpty()) res.body = replyErrorString(reply).toUtf8();
+    } else if (reply->error() != QNetworkReply::NoError) {
+        res.statusCode = 0;
+        res.body = replyErrorString(reply).toUtf8();
+    }
+    return res;
+}
+
+QNetworkRequest uploadRequest(const QString& absoluteUrl, QIODevice* body) {
+    QUrl u(absoluteUrl);
+    QNetworkRequest req(u);
+    req.setTransferTimeout(YandexDiskApiClient::kTransferStallTimeoutMs);
+    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/octet-stream"));
+    req.setHeader(QNetworkRequest::ContentLengthHeader, body->size() - body->pos());
     req.setRawHeader("User-Agent", kSpoofedUserAgent);
-    QNetworkReply* reply = nam_->get(req);
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+    return req;
+}
+
+void reportUploadProgress(QNetworkReply* reply, std::function<void(qint64)> onProgress) {
+    if (!onProgress) return;
+    struct State { qint64 lastSent = 0; qint64 lastTime = QDateTime::currentMSecsSinceEpoch(); };
+    auto state = std::make_shared<State>();
+    QObject::connect(reply, &QNetworkReply::uploadProgress, reply, [onProgress, state](qint64 sent, qint64) {
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (now > state->lastTime && (now - state->lastTime) >= 150) {
+            qint64 bytesPerSec = (sent - state->lastSent) * 1000 / (now - state->lastTime);
+            state->lastSent = sent;
+            state->lastTime = now;
+            onProgress(bytesPerSec);
+        }
+    });
+}
+
+ApiResponse finishUpload(QNetworkReply* reply) {
     const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    std::string body = reply->readAll().toStdString();
-    if (reply->error() != QNetworkReply::NoError && body.empty())
-        body = reply->errorString().toStdString();
-    reply->deleteLater();
-    return {status, body};
+    QByteArray replyBody = reply->readAll();
+    if (reply->error() != QNetworkReply::NoError) {
+        QString err = replyErrorString(reply);
+        if (err.isEmpty()) err = QStringLiteral("Network error (%1)").arg(reply->error());
+        if (replyBody.isEmpty() || status == 0) replyBody = err.toUtf8();
+    }
+    return {status, replyBody};
+}
+
+}  // namespace
+
+YandexDiskApiClient::YandexDiskApiClient(ITokenProvider const& tokenProvider,
+                                         QNetworkAccessManager* nam,
+                                         QObject* parent)
+    : QObject(parent), tokenProvider_(tokenProvider), nam_(nam), baseUrl_(QString::fromLatin1(kBaseUrl)) {}
+
+QUrl YandexDiskApiClient::apiUrl(const std::string& pathWithQuery) const {
+    return QUrl(baseUrl_ + QString::fromStdString(pathWithQuery));
+}
+
+QNetworkReply* YandexDiskApiClient::track(QNetworkReply* reply, int timeoutMs) const {
+    if (cancel_) {
+        connect(cancel_.data(), &CancellationToken::cancelled, reply, &QNetworkReply::abort);
+        if (cancel_->isCancelled())
+            QMetaObject::invokeMethod(reply, &QNetworkReply::abort, Qt::QueuedConnection);
+    }
+    if (timeoutMs > 0) {
+        QTimer* deadline = new QTimer(reply);
+        deadline->setSingleShot(true);
+        connect(deadline, &QTimer::timeout, reply, [reply]() {
+            reply->setProperty(kTimedOutProperty, true);
+            reply->abort();
+        });
+        connect(reply, &QNetworkReply::finished, deadline, &QTimer::stop);
+        deadline->start(timeoutMs);
+    }
+    return reply;
+}
+
+ApiResponse YandexDiskApiClient::wait(const std::function<void(Callback)>& start) const {
+    std::optional<ApiResponse> result;
+    QEventLoop loop;
+    start([&result, &loop](ApiResponse res) {
+        result = std::move(res);
+        loop.quit();
+    });
+    if (!result) loop.exec();
+    return *result;
+}
+
+void YandexDiskApiClient::project(QUrlQuery& query, const char* fields) {
+    query.removeAllQueryItems(QStringLiteral("fields"));
+    query.addQueryItem(QStringLiteral("fields"), QString::fromLatin1(fields));
+}
+
+ApiResponse YandexDiskApiClient::get(const std::string& path, const QUrlQuery& query) const {
+    return wait([&](Callback cb) { getAsync(path, query, std::move(cb)); });
+}
+
+ApiResponse YandexDiskApiClient::probe() const {
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("path"), QStringLiteral("/"));
+    project(query, kProbeFields);
+    return get("/resources", query);
+}
+
+void YandexDiskApiClient::getAsync(const std::string& path, const QUrlQuery& query,
+                                    std::function<void(ApiResponse)> cb) const {
+    QUrl url = apiUrl(path);
+    if (!query.isEmpty()) url.setQuery(query);
+    getUrlAsync(url, std::move(cb));
+}
+
+ApiResponse YandexDiskApiClient::getByFullUrl(const QString& fullUrlWithQuery) const {
+    return wait([&](Callback cb) { getByFullUrlAsync(fullUrlWithQuery, std::move(cb)); });
 }
 
 void YandexDiskApiClient::getByFullUrlAsync(const QString& fullUrlWithQuery,
                                             std::function<void(ApiResponse)> cb) const {
+    getUrlAsync(QUrl(fullUrlWithQuery), std::move(cb));
+}
+
+void YandexDiskApiClient::getUrlAsync(const QUrl& url, Callback cb) const {
     auto token = tokenProvider_.getAccessToken();
     if (!token || token->empty()) {
         if (cb) cb({401, ""});
         return;
     }
-    QUrl url(fullUrlWithQuery);
-    QNetworkRequest req(url);
-    req.setTransferTimeout(30000);
+    QNetworkRequest req = apiRequest(url, *token);
     req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-    QNetworkReply* reply = nam_->get(req);
+    QNetworkReply* reply = track(nam_->get(req), kRequestTimeoutMs);
     connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        std::string body = reply->readAll().toStdString();
-        if (reply->error() != QNetworkReply::NoError && body.empty())
-            body = reply->errorString().toStdString();
+        ApiResponse res = readReply(reply);
         reply->deleteLater();
-        if (cb) cb({status, body});
+        if (cb) cb(res);
     });
 }
 
-void YandexDiskApiClient::getAsync(const std::string& path, const QUrlQuery& query,
-                                    std::function<void(ApiResponse)> cb) const {
+ApiResponse YandexDiskApiClient::put(const std::string& path, const QByteArray& body) const {
+    return wait([&](Callback cb) { putAsync(path, body, std::move(cb)); });
+}
+
+void YandexDiskApiClient::putAsync(const std::string& path, const QByteArray& body,
+                                   std::function<void(ApiResponse)> cb) const {
     auto token = tokenProvider_.getAccessToken();
     if (!token || token->empty()) {
         if (cb) cb({401, ""});
         return;
     }
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + path));
-    if (!query.isEmpty()) url.setQuery(query);
-    QNetworkRequest req(url);
+    QNetworkRequest req = apiRequest(apiUrl(path), *token);
     req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-    QNetworkReply* reply = nam_->get(req);
+    QNetworkReply* reply = track(nam_->put(req, body), kRequestTimeoutMs);
     connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        const std::string body = reply->readAll().toStdString();
+        ApiResponse res = readReply(reply);
         reply->deleteLater();
-        if (cb) cb({status, body});
+        if (cb) cb(res);
     });
 }
 
-ApiResponse YandexDiskApiClient::put(const std::string& path, const QByteArray& body) const {
-    auto token = tokenProvider_.getAccessToken();
-    if (!token || token->empty()) {
-        return {401, ""};
-    }
-
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + path));
-    QNetworkRequest req(url);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-
-    QNetworkReply* reply = nam_->put(req, body);
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    const std::string replyBody = reply->readAll().toStdString();
-    reply->deleteLater();
-    return {status, replyBody};
+ApiResponse YandexDiskApiClient::putNoBody(const std::string& pathWithQuery) const {
+    return wait([&](Callback cb) { putNoBodyAsync(pathWithQuery, std::move(cb)); });
 }
 
-ApiResponse YandexDiskApiClient::putNoBody(const std::string& pathWithQuery) const {
+void YandexDiskApiClient::putNoBodyAsync(const std::string& pathWithQuery,
+                                         std::function<void(ApiResponse)> cb) const {
     auto token = tokenProvider_.getAccessToken();
     if (!token || token->empty()) {
-        return {401, ""};
+        if (cb) cb({401, ""});
+        return;
     }
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + pathWithQuery));
-    QNetworkRequest req(url);
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-
-    QNetworkReply* reply = nam_->put(req, QByteArray());
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    std::string replyBody = reply->readAll().toStdString();
-    if (reply->error() != QNetworkReply::NoError && replyBody.empty())
-        replyBody = reply->errorString().toStdString();
-    reply->deleteLater();
-    return {status, replyBody};
+    QNetworkRequest req = apiRequest(apiUrl(pathWithQuery), *token);
+    QNetworkReply* reply = track(nam_->put(req, QByteArray()), kRequestTimeoutMs);
+    connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
+        ApiResponse res = readReply(reply);
+        reply->deleteLater();
+        if (cb) cb(res);
+    });
 }
 
 ApiResponse YandexDiskApiClient::postNoBody(const std::string& pathWithQuery) const {
+    return wait([&](Callback cb) { postNoBodyAsync(pathWithQuery, std::move(cb)); });
+}
+
+void YandexDiskApiClient::postNoBodyAsync(const std::string& pathWithQuery,
+                                          std::function<void(ApiResponse)> cb) const {
     auto token = tokenProvider_.getAccessToken();
     if (!token || token->empty()) {
-        return {401, ""};
+        if (cb) cb({401, ""});
+        return;
     }
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + pathWithQuery));
-    QNetworkRequest req(url);
+    QNetworkRequest req = apiRequest(apiUrl(pathWithQuery), *token);
     req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/x-www-form-urlencoded"));
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-
-    QNetworkReply* reply = nam_->post(req, QByteArray());
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+    QNetworkReply* reply = track(nam_->post(req, QByteArray()), kRequestTimeoutMs);
+    connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
+        ApiResponse res = readReply(reply);
+        reply->deleteLater();
+        if (cb) cb(res);
+    });
+}
 
-    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    std::string replyBody = reply->readAll().toStdString();
-    if (reply->error() != QNetworkReply::NoError && replyBody.empty())
-        replyBody = reply->errorString().toStdString();
-    reply->deleteLater();
-    return {status, replyBody};
+ApiResponse YandexDiskApiClient::downloadToFile(const QString& absoluteUrl, const QString& localPath,
+                                                qint64 resumeFrom, const QString& partPath) const {
+    return wait([&](Callback cb) { downloadToFileAsync(absoluteUrl, localPath, std::move(cb), resumeFrom, partPath); });
 }
 
-ApiResponse YandexDiskApiClient::getAbsoluteUrl(const QString& absoluteUrl) const {
+void YandexDiskApiClient::downloadToFileAsync(const QString& absoluteUrl, const QString& localPath,
+                                              std::function<void(ApiResponse)> cb, qint64 resumeFrom,
+                                              const QString& partPath) const {
     auto token = tokenProvider_.getAccessToken();
     if (!token || token->empty()) {
-        return {401, ""};
+        if (cb) cb({401, ""});
+        return;
     }
-    QUrl u(absoluteUrl);
-    QNetworkRequest req(u);
-    req.setRawHeader("Accept", "application/octet-stream");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-
-    QNetworkReply* reply = nam_->get(req);
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    const std::string body = reply->readAll().toStdString();
-    reply->deleteLater();
-    return {status, body};
+    QNetworkRequest req = downloadRequest(absoluteUrl, *token);
+    if (resumeFrom > 0)
+        req.setRawHeader("Range", "bytes=" + QByteArray::number(resumeFrom) + '-');
+    auto sink = std::make_shared<FileSink>();
+    sink->file.setFileName(partPath.isEmpty() ? localPath + QLatin1String(kTempDownloadSuffix) : partPath);
+    sink->targetPath = localPath;
+    sink->keepPartial = !partPath.isEmpty();
+    sink->resumeFrom = resumeFrom;
+    QNetworkReply* reply = track(nam_->get(req), 0);
+    reply->setReadBufferSize(kDownloadChunkSize * 4);
+    connect(reply, &QNetworkReply::readyRead, this, [reply, sink]() { drainToFile(reply, sink.get()); });
+    connect(reply, &QNetworkReply::finished, this, [reply, sink, cb]() {
+        ApiResponse res = finishFileDownload(reply, sink.get());
+        reply->deleteLater();
+        if (cb) cb(res);
+    });
 }
 
-void YandexDiskApiClient::getAbsoluteUrlAsync(const QString& absoluteUrl,
-                                               std::function<void(ApiResponse)> cb) const {
+void YandexDiskApiClient::downloadRangeToFileAsync(const QString& absoluteUrl, const QString& localPath,
+                                                   qint64 offset, qint64 length,
+                                                   std::function<void(ApiResponse, qint64 bytesWritten)> cb) const {
     auto token = tokenProvider_.getAccessToken();
     if (!token || token->empty()) {
-        if (cb) cb({401, ""});
+        if (cb) cb({401, ""}, 0);
         return;
     }
-    QUrl u(absoluteUrl);
-    QNetworkRequest req(u);
-    req.setRawHeader("Accept", "application/octet-stream");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-    QNetworkReply* reply = nam_->get(req);
-    connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        const std::string body = reply->readAll().toStdString();
+    QNetworkRequest req = downloadRequest(absoluteUrl, *token);
+    req.setRawHeader("Range", "bytes=" + QByteArray::number(offset) + '-' + QByteArray::number(offset + length - 1));
+    auto sink = std::make_shared<FileSink>();
+    sink->file.setFileName(localPath);
+    sink->resumeFrom = offset;
+    sink->rangeLength = length;
+    QNetworkReply* reply = track(nam_->get(req), 0);
+    reply->setReadBufferSize(kDownloadChunkSize * 4);
+    connect(reply, &QNetworkReply::readyRead, this, [reply, sink]() { drainToFile(reply, sink.get()); });
+    connect(reply, &QNetworkReply::finished, this, [reply, sink, cb]() {
+        ApiResponse res = finishFileDownload(reply, sink.get());
         reply->deleteLater();
-        if (cb) cb({status, body});
+        if (cb) cb(res, sink->written);
     });
 }
 
@@ -244,63 +429,32 @@ ApiResponse YandexDiskApiClient::putToAbsoluteUrl(const QString& absoluteUrl, co
 
 ApiResponse YandexDiskApiClient::putToAbsoluteUrl(const QString& absoluteUrl, const QByteArray& body,
                                                    std::function<void(qint64 bytesPerSecond)> onProgress) const {
-    QUrl u(absoluteUrl);
-    QNetworkRequest req(u);
-    req.setTransferTimeout(900000);
-    req.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/octet-stream"));
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
+    auto buffer = std::make_shared<QBuffer>();
+    buffer->setData(body);
+    buffer->open(QIODevice::ReadOnly);
+    return wait([&](Callback cb) { putFromDeviceAsync(absoluteUrl, buffer, std::move(onProgress), std::move(cb)); });
+}
 
-    QNetworkReply* reply = nam_->put(req, body);
-    if (onProgress) {
-        struct State { qint64 lastSent = 0; qint64 lastTime = QDateTime::currentMSecsSinceEpoch(); };
-        State* state = new State;
-        connect(reply, &QNetworkReply::uploadProgress, reply, [onProgress, state](qint64 sent, qint64) {
-            qint64 now = QDateTime::currentMSecsSinceEpoch();
-            if (now > state->lastTime && (now - state->lastTime) >= 150) {
-                qint64 bytesPerSec = (sent - state->lastSent) * 1000 / (now - state->lastTime);
-                state->lastSent = sent;
-                state->lastTime = now;
-                onProgress(bytesPerSec);
-            }
-        });
-        connect(reply, &QNetworkReply::destroyed, reply, [state]() { delete state; });
-    }
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
+ApiResponse YandexDiskApiClient::putFromDevice(const QString& absoluteUrl, QIODevice* body,
+                                                std::function<void(qint64 bytesPerSecond)> onProgress) const {
+    std::shared_ptr<QIODevice> borrowed(body, [](QIODevice*) {});
+    return wait([&](Callback cb) { putFromDeviceAsync(absoluteUrl, borrowed, std::move(onProgress), std::move(cb)); });
+}
 
-    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    std::string replyBody = reply->readAll().toStdString();
-    if (reply->error() != QNetworkReply::NoError) {
-        QString err = reply->errorString();
-        if (err.isEmpty()) err = QStringLiteral("Network error (%1)").arg(reply->error());
-        if (replyBody.empty() || status == 0) replyBody = err.toStdString();
-    }
-    reply->deleteLater();
-    return {status, replyBody};
+void YandexDiskApiClient::putFromDeviceAsync(const QString& absoluteUrl, std::shared_ptr<QIODevice> body,
+                                             std::function<void(qint64 bytesPerSecond)> onProgress,
+                                             std::function<void(ApiResponse)> cb) const {
+    QNetworkReply* reply = track(nam_->put(uploadRequest(absoluteUrl, body.get()), body.get()), 0);
+    reportUploadProgress(reply, std::move(onProgress));
+    connect(reply, &QNetworkReply::finished, this, [reply, body, cb]() {
+        ApiResponse res = finishUpload(reply);
+        reply->deleteLater();
+        if (cb) cb(res);
+    });
 }
 
 ApiResponse YandexDiskApiClient::deleteResource(const std::string& path) const {
-    auto token = tokenProvider_.getAccessToken();
-    if (!token || token->empty()) {
-        return {401, ""};
-    }
-
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + path));
-    QNetworkRequest req(url);
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-
-    QNetworkReply* reply = nam_->deleteResource(req);
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    const std::string body = reply->readAll().toStdString();
-    reply->deleteLater();
-    return {status, body};
+    return wait([&](Callback cb) { deleteResourceAsync(path, std::move(cb)); });
 }
 
 void YandexDiskApiClient::deleteResourceAsync(const std::string& path,
@@ -310,17 +464,12 @@ void YandexDiskApiClient::deleteResourceAsync(const std::string& path,
         if (cb) cb({401, ""});
         return;
     }
-    QUrl url(QString::fromStdString(std::string(kBaseUrl) + path));
-    QNetworkRequest req(url);
-    req.setRawHeader("Accept", "application/json");
-    req.setRawHeader("Authorization", ("OAuth " + *token).c_str());
-    req.setRawHeader("User-Agent", kSpoofedUserAgent);
-    QNetworkReply* reply = nam_->deleteResource(req);
+    QNetworkRequest req = apiRequest(apiUrl(path), *token);
+    QNetworkReply* reply = track(nam_->deleteResource(req), kRequestTimeoutMs);
     connect(reply, &QNetworkReply::finished, this, [reply, cb]() {
-        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-        const std::string body = reply->readAll().toStdString();
+        ApiResponse res = readReply(reply);
         reply->deleteLater();
-        if (cb) cb({status, body});
+        if (cb) cb(res);
     });
 }
 
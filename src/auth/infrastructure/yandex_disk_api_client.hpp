@@ -1,23 +1,31 @@
 #pragma once
 
 #include "auth/application/itoken_provider.hpp"
+#include "auth/infrastructure/cancellation_token.hpp"
 #include <QByteArray>
 #include <QObject>
+#include <QPointer>
 #include <QString>
 #include <QUrlQuery>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 
+class QIODevice;
 class QNetworkAccessManager;
+class QNetworkReply;
+class QUrl;
 
 namespace ydisquette {
 namespace auth {
 
 struct ApiResponse {
     int statusCode{};
-    std::string body;
+    QByteArray body;
     bool ok() const { return statusCode >= 200 && statusCode < 300; }
+    std::string_view bodyView() const { return std::string_view(body.constData(), static_cast<size_t>(body.size())); }
 };
 
 class YandexDiskApiClient : public QObject {
@@ -27,29 +35,75 @@ public:
                                 QNetworkAccessManager* nam,
                                 QObject* parent = nullptr);
     ApiResponse get(const std::string& path, const QUrlQuery& query = QUrlQuery()) const;
+    ApiResponse probe() const;
     void getAsync(const std::string& path, const QUrlQuery& query,
                   std::function<void(ApiResponse)> cb) const;
     ApiResponse getByFullUrl(const QString& fullUrlWithQuery) const;
     void getByFullUrlAsync(const QString& fullUrlWithQuery,
                            std::function<void(ApiResponse)> cb) const;
-    ApiResponse getAbsoluteUrl(const QString& absoluteUrl) const;
-    void getAbsoluteUrlAsync(const QString& absoluteUrl,
-                            std::function<void(ApiResponse)> cb) const;
+    // Streams into partPath (or a sibling "<localPath>.download" when empty) and renames it over
+    // localPath only once the reply completed with the advertised length. An explicit partPath is
+    // kept on failure so the caller can resume from it; the implicit one is removed.
+    ApiResponse downloadToFile(const QString& absoluteUrl, const QString& localPath,
+                               qint64 resumeFrom = 0, const QString& partPath = QString()) const;
+    void downloadToFileAsync(const QString& absoluteUrl, const QString& localPath,
+                             std::function<void(ApiResponse)> cb, qint64 resumeFrom = 0,
+                             const QString& partPath = QString()) const;
+    void downloadRangeToFileAsync(const QString& absoluteUrl, const QString& localPath,
+                                  qint64 offset, qint64 length,
+                                  std::function<void(ApiResponse, qint64 bytesWritten)> cb) const;
     ApiResponse put(const std::string& path, const QByteArray& body = QByteArray()) const;
+    void putAsync(const std::string& path, const QByteArray& body,
+                  std::function<void(ApiResponse)> cb) const;
     ApiResponse putNoBody(const std::string& pathWithQuery) const;
+    void putNoBodyAsync(const std::string& pathWithQuery,
+                        std::function<void(ApiResponse)> cb) const;
     ApiResponse postNoBody(const std::string& pathWithQuery) const;
+    void postNoBodyAsync(const std::string& pathWithQuery,
+                         std::function<void(ApiResponse)> cb) const;
     ApiResponse putToAbsoluteUrl(const QString& absoluteUrl, const QByteArray& body) const;
     ApiResponse putToAbsoluteUrl(const QString& absoluteUrl, const QByteArray& body,
                                  std::function<void(qint64 bytesPerSecond)> onProgress) const;
+    ApiResponse putFromDevice(const QString& absoluteUrl, QIODevice* body,
+                              std::function<void(qint64 bytesPerSecond)> onProgress) const;
+    void putFromDeviceAsync(const QString& absoluteUrl, std::shared_ptr<QIODevice> body,
+                            std::function<void(qint64 bytesPerSecond)> onProgress,
+                            std::function<void(ApiResponse)> cb) const;
     ApiResponse deleteResource(const std::string& path) const;
     void deleteResourceAsync(const std::string& path,
                              std::function<void(ApiResponse)> cb) const;
 
+    void setCancellationToken(CancellationToken* token) { cancel_ = token; }
+    void setBaseUrl(const QString& baseUrl) { baseUrl_ = baseUrl; }
+    const QString& baseUrl() const { return baseUrl_; }
+
+    static void project(QUrlQuery& query, const char* fields);
+
     static const char kBaseUrl[];
+    static const char kProbeFields[];
+    static const char kListingFields[];
+    static const char kLastUploadedFields[];
+    static const char kTrashFields[];
+    static const char kStatFields[];
+    static const char kFilePathFields[];
+    static const char kFileEntryFields[];
+    static const char kTempDownloadSuffix[];
+    static const qint64 kDownloadChunkSize;
+    static const int kRequestTimeoutMs;
+    static const int kTransferStallTimeoutMs;
 
 private:
+    using Callback = std::function<void(ApiResponse)>;
+
+    QUrl apiUrl(const std::string& pathWithQuery) const;
+    void getUrlAsync(const QUrl& url, Callback cb) const;
+    QNetworkReply* track(QNetworkReply* reply, int timeoutMs) const;
+    ApiResponse wait(const std::function<void(Callback)>& start) const;
+
     ITokenProvider const& tokenProvider_;
     QNetworkAccessManager* nam_;
+    QPointer<CancellationToken> cancel_;
+    QString baseUrl_;
 };
 
 }  // namespace auth
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "disk_tree/domain/node.hpp"
+#include "disk_tree/domain/node_list.hpp"
 #include <functional>
 #include <memory>
 #include <string>
@@ -9,12 +10,22 @@
 namespace ydisquette {
 namespace disk_tree {
 
+struct ChildrenPage {
+    NodeList items;
+    bool last = true;
+    bool ok = true;
+};
+
 struct ITreeRepository {
     virtual ~ITreeRepository() = default;
     virtual std::shared_ptr<Node> getRoot() = 0;
-    virtual std::vector<std::shared_ptr<Node>> getChildren(const std::string& path) = 0;
-    virtual void getChildrenAsync(const std::string& path,
-                                  std::function<void(std::vector<std::shared_ptr<Node>>)> cb) = 0;
+    virtual NodeList getChildren(const std::string& path) = 0;
+    virtual void getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) = 0;
+    virtual void getChildrenPagedAsync(const std::string& path, std::function<void(ChildrenPage)> onPage) {
+        getChildrenAsync(path, [onPage](NodeList items) {
+            onPage({std::move(items), true, true});
+        });
+    }
 };
 
 }  // namespace disk_tree
@@ -16,6 +16,7 @@ struct Node {
     std::string name;
     int64_t size{};
     std::string modified;
+    int64_t modifiedSec{};
     bool syncSelected{};
 
     std::vector<std::shared_ptr<Node>> children;
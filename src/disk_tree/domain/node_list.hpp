@@ -0,0 +1,198 @@
+#pragma once
+
+#include "disk_tree/domain/node.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ydisquette {
+namespace disk_tree {
+
+class NodeList;
+
+class NodeRef {
+public:
+    NodeRef(const NodeList& list, uint32_t id) : list_(&list), id_(id) {}
+
+    uint32_t id() const { return id_; }
+    NodeType type() const;
+    bool isDir() const { return type() == NodeType::Dir; }
+    bool isFile() const { return type() == NodeType::File; }
+    std::string_view name() const;
+    std::string_view modified() const;
+    int64_t size() const;
+    int64_t modifiedSec() const;
+    std::string path() const;
+
+private:
+    const NodeList* list_;
+    uint32_t id_;
+};
+
+class NodeList {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NodeRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = NodeRef;
+
+        const_iterator(const NodeList* list, uint32_t id) : list_(list), id_(id) {}
+        NodeRef operator*() const { return NodeRef(*list_, id_); }
+        const_iterator& operator++() {
+            ++id_;
+            return *this;
+        }
+        bool operator==(const const_iterator& o) const { return id_ == o.id_ && list_ == o.list_; }
+        bool operator!=(const const_iterator& o) const { return !(*this == o); }
+
+    private:
+        const NodeList* list_;
+        uint32_t id_;
+    };
+
+    void reserve(size_t count, size_t textBytes = 0) {
+        entries_.reserve(count);
+        if (textBytes) text_.reserve(textBytes);
+    }
+
+    void add(NodeType type, std::string_view path, std::string_view name, int64_t size,
+             std::string_view modified = {}, int64_t modifiedSec = 0) {
+        if (entries_.empty() && !hasParent_ && endsWithName(path, name)) {
+            parent_.assign(path.data(), path.size() - name.size() - 1);
+            hasParent_ = true;
+        }
+        Entry e;
+        e.type = type;
+        e.size = size;
+        e.modifiedSec = modifiedSec;
+        e.name = intern(name);
+        e.modified = intern(modified);
+        e.ownPath = !derivesFromParent(path, name);
+        if (e.ownPath) e.path = intern(path);
+        entries_.push_back(e);
+    }
+
+    void add(const NodeRef& n) { add(n.type(), n.path(), n.name(), n.size(), n.modified(), n.modifiedSec()); }
+
+    void append(const NodeList& other) {
+        if (&other == this) {
+            const NodeList copy = other;
+            append(copy);
+            return;
+        }
+        reserve(entries_.size() + other.size(), text_.size() + other.text_.size());
+        for (NodeRef n : other) add(n);
+    }
+
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+    NodeRef operator[](size_t i) const { return NodeRef(*this, static_cast<uint32_t>(i)); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, static_cast<uint32_t>(entries_.size())); }
+
+    size_t bytesUsed() const {
+        return sizeof(*this) + entries_.capacity() * sizeof(Entry) + text_.capacity() + parent_.capacity();
+    }
+
+    bool operator==(const NodeList& o) const {
+        if (size() != o.size()) return false;
+        for (size_t i = 0; i < size(); ++i) {
+            NodeRef a = (*this)[i];
+            NodeRef b = o[i];
+            if (a.type() != b.type() || a.size() != b.size() || a.name() != b.name()
+                || a.modified() != b.modified() || a.path() != b.path())
+                return false;
+        }
+        return true;
+    }
+    bool operator!=(const NodeList& o) const { return !(*this == o); }
+
+    std::vector<std::shared_ptr<Node>> toNodes() const {
+        std::vector<std::shared_ptr<Node>> out;
+        out.reserve(entries_.size());
+        for (NodeRef n : *this) {
+            if (n.isDir())
+                out.push_back(Node::makeDir(n.path(), std::string(n.name()), std::string(n.modified())));
+            else
+                out.push_back(Node::makeFile(n.path(), std::string(n.name()), n.size(), std::string(n.modified())));
+            out.back()->modifiedSec = n.modifiedSec();
+        }
+        return out;
+    }
+
+    static NodeList fromNodes(const std::vector<std::shared_ptr<Node>>& nodes) {
+        NodeList out;
+        out.reserve(nodes.size());
+        for (const auto& n : nodes)
+            if (n) out.add(n->type, n->path, n->name, n->size, n->modified, n->modifiedSec);
+        return out;
+    }
+
+private:
+    friend class NodeRef;
+
+    struct Slice {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+    struct Entry {
+        Slice name;
+        Slice path;
+        Slice modified;
+        int64_t size = 0;
+        int64_t modifiedSec = 0;
+        NodeType type = NodeType::File;
+        bool ownPath = false;
+    };
+
+    static bool endsWithName(std::string_view path, std::string_view name) {
+        return !name.empty() && path.size() > name.size() && path[path.size() - name.size() - 1] == '/'
+            && path.substr(path.size() - name.size()) == name;
+    }
+
+    bool derivesFromParent(std::string_view path, std::string_view name) const {
+        return hasParent_ && path.size() == parent_.size() + 1 + name.size() && endsWithName(path, name)
+            && path.substr(0, parent_.size()) == parent_;
+    }
+
+    Slice intern(std::string_view s) {
+        Slice out{static_cast<uint32_t>(text_.size()), static_cast<uint32_t>(s.size())};
+        text_.append(s.data(), s.size());
+        return out;
+    }
+
+    std::string_view view(Slice s) const { return std::string_view(text_.data() + s.offset, s.length); }
+
+    std::vector<Entry> entries_;
+    std::string text_;
+    std::string parent_;
+    bool hasParent_ = false;
+};
+
+inline NodeType NodeRef::type() const { return list_->entries_[id_].type; }
+inline std::string_view NodeRef::name() const { return list_->view(list_->entries_[id_].name); }
+inline std::string_view NodeRef::modified() const { return list_->view(list_->entries_[id_].modified); }
+inline int64_t NodeRef::size() const { return list_->entries_[id_].size; }
+inline int64_t NodeRef::modifiedSec() const { return list_->entries_[id_].modifiedSec; }
+
+inline std::string NodeRef::path() const {
+    const NodeList::Entry& e = list_->entries_[id_];
+    if (e.ownPath) return std::string(list_->view(e.path));
+    const std::string_view name = list_->view(e.name);
+    std::string out;
+    out.reserve(list_->parent_.size() + 1 + name.size());
+    out += list_->parent_;
+    out += '/';
+    out += name;
+    return out;
+}
+
+}  // namespace disk_tree
+}  // namespace ydisquette
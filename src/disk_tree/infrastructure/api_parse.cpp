@@ -1,43 +1,100 @@
 #include "disk_tree/infrastructure/api_parse.hpp"
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
+#include "shared/iso_datetime.hpp"
+#include "shared/json_reader.hpp"
 
 namespace ydisquette {
 namespace disk_tree {
 
-Quota parseDiskJson(const std::string& body) {
-    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body));
-    if (!doc.isObject()) return {};
-    QJsonObject o = doc.object();
+Quota parseDiskJson(std::string_view body) {
+    JsonReader r(body);
     Quota q;
-    q.totalSpace = static_cast<int64_t>(o.value(QStringLiteral("total_space")).toInteger(0));
-    q.usedSpace = static_cast<int64_t>(o.value(QStringLiteral("used_space")).toInteger(0));
-    return q;
+    std::string_view key;
+    if (!r.beginObject()) return {};
+    while (r.nextKey(key)) {
+        if (key == "total_space")
+            q.totalSpace = r.readInteger(0);
+        else if (key == "used_space")
+            q.usedSpace = r.readInteger(0);
+        else
+            r.skipValue();
+    }
+    return r.atEnd() ? q : Quota{};
+}
+
+std::vector<std::shared_ptr<Node>> parseResourcesJson(std::string_view body) {
+    return parseResourcesPageJson(body).items.toNodes();
+}
+
+namespace {
+
+struct ItemFields {
+    std::string type;
+    std::string path;
+    std::string name;
+    std::string modified;
+    int64_t size = 0;
+};
+
+void readItem(JsonReader& r, ItemFields& f, NodeList& out) {
+    f.type.clear();
+    f.path.clear();
+    f.name.clear();
+    f.modified.clear();
+    f.size = 0;
+    std::string_view key;
+    r.beginObject();
+    while (r.nextKey(key)) {
+        if (key == "type")
+            r.readString(f.type);
+        else if (key == "path")
+            r.readString(f.path);
+        else if (key == "name")
+            r.readString(f.name);
+        else if (key == "modified")
+            r.readString(f.modified);
+        else if (key == "size")
+            f.size = r.readInteger(0);
+        else
+            r.skipValue();
+    }
+    if (!r.ok()) return;
+    const bool isDir = f.type == "dir";
+    out.add(isDir ? NodeType::Dir : NodeType::File, f.path, f.name, isDir ? 0 : f.size, f.modified,
+            parseIsoDateTimeToSec(f.modified));
 }
 
-std::vector<std::shared_ptr<Node>> parseResourcesJson(const std::string& body) {
-    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body));
-    if (!doc.isObject()) return {};
-    QJsonObject root = doc.object();
-    QJsonObject embedded = root.value(QStringLiteral("_embedded")).toObject();
-    QJsonArray items = embedded.value(QStringLiteral("items")).toArray();
-
-    std::vector<std::shared_ptr<Node>> out;
-    for (const QJsonValue& v : items) {
-        QJsonObject o = v.toObject();
-        QString type = o.value(QStringLiteral("type")).toString();
-        std::string pathStr = o.value(QStringLiteral("path")).toString().toUtf8().toStdString();
-        std::string name = o.value(QStringLiteral("name")).toString().toUtf8().toStdString();
-        std::string modified = o.value(QStringLiteral("modified")).toString().toUtf8().toStdString();
-        if (type == QLatin1String("dir")) {
-            out.push_back(Node::makeDir(std::move(pathStr), std::move(name), std::move(modified)));
-        } else {
-            qint64 size = o.value(QStringLiteral("size")).toInteger(0);
-            out.push_back(Node::makeFile(std::move(pathStr), std::move(name), static_cast<int64_t>(size), std::move(modified)));
+}  // namespace
+
+ResourcesPage parseResourcesPageJson(std::string_view body) {
+    JsonReader r(body);
+    ResourcesPage page;
+    ItemFields fields;
+    std::string_view key;
+    if (!r.beginObject()) return {};
+    while (r.nextKey(key)) {
+        if (key != "_embedded" || !r.isObject()) {
+            r.skipValue();
+            continue;
+        }
+        r.beginObject();
+        while (r.nextKey(key)) {
+            if (key == "total") {
+                page.total = static_cast<int>(r.readInteger(-1));
+            } else if (key == "items" && r.isArray()) {
+                page.items = NodeList();
+                r.beginArray();
+                while (r.nextElement()) {
+                    if (r.isObject())
+                        readItem(r, fields, page.items);
+                    else
+                        r.skipValue();
+                }
+            } else {
+                r.skipValue();
+            }
         }
     }
-    return out;
+    return r.atEnd() ? page : ResourcesPage{};
 }
 
 }  // namespace disk_tree
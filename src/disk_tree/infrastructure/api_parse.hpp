@@ -1,16 +1,24 @@
 #pragma once
 
 #include "disk_tree/domain/node.hpp"
+#include "disk_tree/domain/node_list.hpp"
 #include "disk_tree/domain/quota.hpp"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
 
 namespace ydisquette {
 namespace disk_tree {
 
-Quota parseDiskJson(const std::string& body);
-std::vector<std::shared_ptr<Node>> parseResourcesJson(const std::string& body);
+struct ResourcesPage {
+    NodeList items;
+    int total = -1;
+};
+
+Quota parseDiskJson(std::string_view body);
+std::vector<std::shared_ptr<Node>> parseResourcesJson(std::string_view body);
+ResourcesPage parseResourcesPageJson(std::string_view body);
 
 }  // namespace disk_tree
 }  // namespace ydisquette
@@ -11,12 +11,12 @@ ApiQuotaService::ApiQuotaService(auth::YandexDiskApiClient const& api) : api_(ap
 Quota ApiQuotaService::getQuota() {
     auth::ApiResponse res = api_.get("");
     if (!res.ok()) return {};
-    return parseDiskJson(res.body);
+    return parseDiskJson(res.bodyView());
 }
 
 void ApiQuotaService::getQuotaAsync(std::function<void(Quota)> cb) {
     api_.getAsync("", QUrlQuery(), [cb](auth::ApiResponse res) {
-        cb(res.ok() ? parseDiskJson(res.body) : Quota{});
+        cb(res.ok() ? parseDiskJson(res.bodyView()) : Quota{});
     });
 }
 
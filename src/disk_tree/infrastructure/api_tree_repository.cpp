@@ -1,39 +1,122 @@
 #include "disk_tree/infrastructure/api_tree_repository.hpp"
 #include "disk_tree/infrastructure/api_parse.hpp"
 #include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "shared/cloud_path_util.hpp"
+#include <QEventLoop>
 #include <QUrlQuery>
 
 namespace ydisquette {
 namespace disk_tree {
 
+const int ApiTreeRepository::kPageLimit = 1000;
+
+struct ApiTreeRepository::Listing {
+    std::string path;
+    std::string key;
+    std::vector<std::function<void(ChildrenPage)>> subscribers;
+    std::vector<ChildrenPage> delivered;
+    int total = -1;
+    bool finished = false;
+};
+
 static QString pathToQString(const std::string& path) {
     return QString::fromUtf8(path.data(), static_cast<int>(path.size()));
 }
 
-ApiTreeRepository::ApiTreeRepository(auth::YandexDiskApiClient const& api) : api_(api) {}
+ApiTreeRepository::ApiTreeRepository(auth::YandexDiskApiClient const& api, int pageLimit)
+    : api_(api), pageLimit_(pageLimit > 0 ? pageLimit : kPageLimit) {}
 
 std::shared_ptr<Node> ApiTreeRepository::getRoot() {
     return Node::makeDir("/", "");
 }
 
-std::vector<std::shared_ptr<Node>> ApiTreeRepository::getChildren(const std::string& path) {
-    QUrlQuery q;
-    q.addQueryItem(QStringLiteral("path"), pathToQString(path));
-    q.addQueryItem(QStringLiteral("limit"), QStringLiteral("1000"));
-    auth::ApiResponse res = api_.get("/resources", q);
-    if (!res.ok()) return {};
-    return parseResourcesJson(res.body);
+NodeList ApiTreeRepository::getChildren(const std::string& path) {
+    NodeList out;
+    bool done = false;
+    bool ok = true;
+    QEventLoop loop;
+    getChildrenPagedAsync(path, [&](ChildrenPage page) {
+        out.append(page.items);
+        if (!page.last) return;
+        done = true;
+        ok = page.ok;
+        loop.quit();
+    });
+    if (!done) loop.exec();
+    if (!ok) return {};
+    return out;
+}
+
+void ApiTreeRepository::getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) {
+    auto out = std::make_shared<NodeList>();
+    getChildrenPagedAsync(path, [out, cb](ChildrenPage page) {
+        out->append(page.items);
+        if (!page.last) return;
+        cb(page.ok ? std::move(*out) : NodeList());
+    });
 }
 
-void ApiTreeRepository::getChildrenAsync(const std::string& path,
-                                         std::function<void(std::vector<std::shared_ptr<Node>>)> cb) {
+void ApiTreeRepository::getChildrenPagedAsync(const std::string& path, std::function<void(ChildrenPage)> onPage) {
+    const std::string key = normalizeCloudPath(path);
+    auto it = inFlight_.find(key);
+    if (it != inFlight_.end()) {
+        ++coalesced_;
+        std::shared_ptr<Listing> listing = it->second;
+        for (const ChildrenPage& page : listing->delivered)
+            onPage(page);
+        listing->subscribers.push_back(std::move(onPage));
+        return;
+    }
+    auto listing = std::make_shared<Listing>();
+    listing->path = path;
+    listing->key = key;
+    listing->subscribers.push_back(std::move(onPage));
+    inFlight_[key] = listing;
+    fetchPage(listing, 0);
+}
+
+void ApiTreeRepository::fetchPage(const std::shared_ptr<Listing>& listing, int offset) {
     QUrlQuery q;
-    q.addQueryItem(QStringLiteral("path"), pathToQString(path));
-    q.addQueryItem(QStringLiteral("limit"), QStringLiteral("1000"));
-    api_.getAsync("/resources", q, [cb](auth::ApiResponse res) {
-        cb(res.ok() ? parseResourcesJson(res.body) : std::vector<std::shared_ptr<Node>>{});
+    q.addQueryItem(QStringLiteral("path"), pathToQString(listing->path));
+    q.addQueryItem(QStringLiteral("limit"), QString::number(pageLimit_));
+    if (offset > 0)
+        q.addQueryItem(QStringLiteral("offset"), QString::number(offset));
+    auth::YandexDiskApiClient::project(q, auth::YandexDiskApiClient::kListingFields);
+    api_.getAsync("/resources", q, [this, listing, offset](auth::ApiResponse res) {
+        onPageFetched(listing, offset, res);
     });
 }
 
+void ApiTreeRepository::onPageFetched(const std::shared_ptr<Listing>& listing, int offset,
+                                      const auth::ApiResponse& res) {
+    if (!res.ok()) {
+        deliver(listing, {{}, true, false});
+        return;
+    }
+    const int next = offset + pageLimit_;
+    const bool requested = listing->total >= 0 && next < listing->total;
+    if (requested) fetchPage(listing, next);
+    ResourcesPage page = parseResourcesPageJson(res.bodyView());
+    if (page.total >= 0) listing->total = page.total;
+    const bool more = requested
+        || (listing->total >= 0 ? next < listing->total : static_cast<int>(page.items.size()) >= pageLimit_);
+    if (more && !requested) fetchPage(listing, next);
+    deliver(listing, {std::move(page.items), !more, true});
+}
+
+void ApiTreeRepository::deliver(const std::shared_ptr<Listing>& listing, ChildrenPage page) {
+    if (listing->finished) return;
+    if (page.last) {
+        listing->finished = true;
+        auto it = inFlight_.find(listing->key);
+        if (it != inFlight_.end() && it->second == listing) inFlight_.erase(it);
+    } else {
+        listing->delivered.push_back(page);
+    }
+    const std::vector<std::function<void(ChildrenPage)>> subscribers = listing->subscribers;
+    for (const auto& onPage : subscribers)
+        onPage(page);
+}
+
 }  // namespace disk_tree
 }  // namespace ydisquette
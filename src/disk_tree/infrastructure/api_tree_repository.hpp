@@ -5,24 +5,39 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace ydisquette {
 namespace auth {
 class YandexDiskApiClient;
+struct ApiResponse;
 }
 namespace disk_tree {
 
 class ApiTreeRepository : public ITreeRepository {
 public:
-    explicit ApiTreeRepository(auth::YandexDiskApiClient const& api);
+    explicit ApiTreeRepository(auth::YandexDiskApiClient const& api, int pageLimit = kPageLimit);
     std::shared_ptr<Node> getRoot() override;
-    std::vector<std::shared_ptr<Node>> getChildren(const std::string& path) override;
-    void getChildrenAsync(const std::string& path,
-                          std::function<void(std::vector<std::shared_ptr<Node>>)> cb) override;
+    NodeList getChildren(const std::string& path) override;
+    void getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) override;
+    void getChildrenPagedAsync(const std::string& path, std::function<void(ChildrenPage)> onPage) override;
+
+    int coalescedCount() const { return coalesced_; }
+
+    static const int kPageLimit;
 
 private:
+    struct Listing;
+
+    void fetchPage(const std::shared_ptr<Listing>& listing, int offset);
+    void onPageFetched(const std::shared_ptr<Listing>& listing, int offset, const auth::ApiResponse& res);
+    void deliver(const std::shared_ptr<Listing>& listing, ChildrenPage page);
+
     auth::YandexDiskApiClient const& api_;
+    int pageLimit_;
+    std::unordered_map<std::string, std::shared_ptr<Listing>> inFlight_;
+    int coalesced_ = 0;
 };
 
 }  // namespace disk_tree
@@ -0,0 +1,156 @@
+#include "disk_tree/infrastructure/caching_tree_repository.hpp"
+#include "disk_tree/infrastructure/tree_cache_store.hpp"
+#include "shared/cloud_path_util.hpp"
+#include <QDateTime>
+#include <QEventLoop>
+#include <QTimer>
+
+namespace ydisquette {
+namespace disk_tree {
+
+const qint64 CachingTreeRepository::kFreshForMs = 10 * 60 * 1000;
+const qint64 CachingTreeRepository::kMaxStaleMs = 60 * 60 * 1000;
+
+static std::string cacheKey(const std::string& path) {
+    std::string key = normalizeCloudPath(path);
+    while (key.size() > 1 && key.back() == '/') key.pop_back();
+    return key.empty() ? std::string("/") : key;
+}
+
+static std::string parentKey(const std::string& key) {
+    const size_t slash = key.rfind('/');
+    if (slash == std::string::npos || slash == 0) return "/";
+    return key.substr(0, slash);
+}
+
+CachingTreeRepository::CachingTreeRepository(ITreeRepository& inner, TreeCacheStore* store, qint64 freshForMs,
+                                             qint64 maxStaleMs)
+    : inner_(inner), store_(store), freshForMs_(qMax<qint64>(0, freshForMs)),
+      maxStaleMs_(qMax(freshForMs_, maxStaleMs)) {}
+
+std::shared_ptr<Node> CachingTreeRepository::getRoot() {
+    return inner_.getRoot();
+}
+
+NodeList CachingTreeRepository::getChildren(const std::string& path) {
+    const std::string key = cacheKey(path);
+    if (auto hit = cached(key, path)) return std::move(*hit);
+    NodeList out;
+    bool done = false;
+    bool ok = true;
+    QEventLoop loop;
+    fetch(key, path, false, [&](ChildrenPage page) {
+        out.append(page.items);
+        if (!page.last) return;
+        done = true;
+        ok = page.ok;
+        loop.quit();
+    });
+    if (!done) loop.exec();
+    if (!ok) return {};
+    return out;
+}
+
+void CachingTreeRepository::getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) {
+    auto out = std::make_shared<NodeList>();
+    getChildrenPagedAsync(path, [out, cb](ChildrenPage page) {
+        out->append(page.items);
+        if (!page.last) return;
+        cb(page.ok ? std::move(*out) : NodeList());
+    });
+}
+
+void CachingTreeRepository::getChildrenPagedAsync(const std::string& path, std::function<void(ChildrenPage)> onPage) {
+    const std::string key = cacheKey(path);
+    if (auto hit = cached(key, path)) {
+        QTimer::singleShot(0, [onPage, children = std::move(*hit)]() {
+            onPage({children, true, true});
+        });
+        return;
+    }
+    fetch(key, path, false, std::move(onPage));
+}
+
+void CachingTreeRepository::invalidate(const std::string& path) {
+    const std::string key = cacheKey(path);
+    for (const std::string& k : {key, parentKey(key)}) {
+        entries_.erase(k);
+        if (store_) store_->remove(k);
+    }
+}
+
+void CachingTreeRepository::markAllStale() {
+    staleBefore_ = QDateTime::currentMSecsSinceEpoch();
+}
+
+std::optional<NodeList> CachingTreeRepository::cached(const std::string& key, const std::string& path) {
+    if (freshForMs_ <= 0) return std::nullopt;
+    const Entry* e = lookup(key);
+    if (!e || QDateTime::currentMSecsSinceEpoch() - e->fetchedAtMs >= maxStaleMs_) {
+        ++misses_;
+        return std::nullopt;
+    }
+    ++hits_;
+    NodeList children = e->children;
+    if (!isFresh(*e))
+        revalidate(key, path);
+    return children;
+}
+
+const CachingTreeRepository::Entry* CachingTreeRepository::lookup(const std::string& key) {
+    auto it = entries_.find(key);
+    if (it != entries_.end() && isFresh(it->second))
+        return &it->second;
+    if (store_) {
+        std::optional<CachedListing> stored = store_->load(key);
+        if (stored && (it == entries_.end() || stored->fetchedAtMs > it->second.fetchedAtMs)) {
+            Entry& e = entries_[key];
+            e.children = std::move(stored->children);
+            e.fetchedAtMs = stored->fetchedAtMs;
+            return &e;
+        }
+    }
+    return it != entries_.end() ? &it->second : nullptr;
+}
+
+bool CachingTreeRepository::isFresh(const Entry& e) const {
+    return e.fetchedAtMs > staleBefore_ && QDateTime::currentMSecsSinceEpoch() - e.fetchedAtMs < freshForMs_;
+}
+
+void CachingTreeRepository::fetch(const std::string& key, const std::string& path, bool revalidation,
+                                  std::function<void(ChildrenPage)> onPage) {
+    auto acc = std::make_shared<NodeList>();
+    std::weak_ptr<bool> alive = alive_;
+    inner_.getChildrenPagedAsync(path, [this, alive, key, revalidation, acc, onPage](ChildrenPage page) {
+        acc->append(page.items);
+        const bool last = page.last;
+        const bool ok = page.ok;
+        if (onPage) onPage(std::move(page));
+        if (!last || !ok || alive.expired()) return;
+        if (remember(key, std::move(*acc)) && revalidation && onRevalidated_)
+            onRevalidated_(key);
+    });
+}
+
+void CachingTreeRepository::revalidate(const std::string& key, const std::string& path) {
+    if (!revalidating_.insert(key).second) return;
+    ++revalidations_;
+    std::weak_ptr<bool> alive = alive_;
+    fetch(key, path, true, [this, alive, key](ChildrenPage page) {
+        if (page.last && !alive.expired()) revalidating_.erase(key);
+    });
+}
+
+bool CachingTreeRepository::remember(const std::string& key, NodeList children) {
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (store_) store_->save(key, children, now);
+    if (freshForMs_ <= 0) return false;
+    Entry& e = entries_[key];
+    const bool changed = e.children != children;
+    e.children = std::move(children);
+    e.fetchedAtMs = now;
+    return changed;
+}
+
+}  // namespace disk_tree
+}  // namespace ydisquette
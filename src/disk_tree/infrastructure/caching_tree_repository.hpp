@@ -0,0 +1,69 @@
+#pragma once
+
+#include "disk_tree/application/itree_repository.hpp"
+#include "disk_tree/domain/node.hpp"
+#include "disk_tree/domain/node_list.hpp"
+#include <QtGlobal>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ydisquette {
+namespace disk_tree {
+
+class TreeCacheStore;
+
+class CachingTreeRepository : public ITreeRepository {
+public:
+    CachingTreeRepository(ITreeRepository& inner, TreeCacheStore* store, qint64 freshForMs = kFreshForMs,
+                          qint64 maxStaleMs = kMaxStaleMs);
+    std::shared_ptr<Node> getRoot() override;
+    NodeList getChildren(const std::string& path) override;
+    void getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) override;
+    void getChildrenPagedAsync(const std::string& path, std::function<void(ChildrenPage)> onPage) override;
+
+    void invalidate(const std::string& path);
+    void markAllStale();
+    void setOnRevalidated(std::function<void(const std::string& path)> cb) { onRevalidated_ = std::move(cb); }
+
+    int hitCount() const { return hits_; }
+    int missCount() const { return misses_; }
+    int revalidationCount() const { return revalidations_; }
+
+    static const qint64 kFreshForMs;
+    static const qint64 kMaxStaleMs;
+
+private:
+    struct Entry {
+        NodeList children;
+        qint64 fetchedAtMs = 0;
+    };
+
+    std::optional<NodeList> cached(const std::string& key, const std::string& path);
+    const Entry* lookup(const std::string& key);
+    bool isFresh(const Entry& e) const;
+    void fetch(const std::string& key, const std::string& path, bool revalidation,
+               std::function<void(ChildrenPage)> onPage);
+    void revalidate(const std::string& key, const std::string& path);
+    bool remember(const std::string& key, NodeList children);
+
+    ITreeRepository& inner_;
+    TreeCacheStore* store_;
+    qint64 freshForMs_;
+    qint64 maxStaleMs_;
+    qint64 staleBefore_ = 0;
+    std::function<void(const std::string&)> onRevalidated_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_set<std::string> revalidating_;
+    std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+    int hits_ = 0;
+    int misses_ = 0;
+    int revalidations_ = 0;
+};
+
+}  // namespace disk_tree
+}  // namespace ydisquette
@@ -3,13 +3,12 @@
 namespace ydisquette {
 namespace disk_tree {
 
-std::vector<std::shared_ptr<Node>> MockTreeRepository::getChildren(const std::string&) {
+NodeList MockTreeRepository::getChildren(const std::string&) {
     if (!root_) return {};
-    return root_->children;
+    return NodeList::fromNodes(root_->children);
 }
 
-void MockTreeRepository::getChildrenAsync(const std::string& path,
-                                          std::function<void(std::vector<std::shared_ptr<Node>>)> cb) {
+void MockTreeRepository::getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) {
     cb(getChildren(path));
 }
 
@@ -14,9 +14,8 @@ class MockTreeRepository : public ITreeRepository {
 public:
     void setRoot(std::shared_ptr<Node> root) { root_ = std::move(root); }
     std::shared_ptr<Node> getRoot() override { return root_; }
-    std::vector<std::shared_ptr<Node>> getChildren(const std::string& path) override;
-    void getChildrenAsync(const std::string& path,
-                         std::function<void(std::vector<std::shared_ptr<Node>>)> cb) override;
+    NodeList getChildren(const std::string& path) override;
+    void getChildrenAsync(const std::string& path, std::function<void(NodeList)> cb) override;
 
 private:
     std::shared_ptr<Node> root_;
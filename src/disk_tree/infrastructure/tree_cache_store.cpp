@@ -0,0 +1,130 @@
+#include "disk_tree/infrastructure/tree_cache_store.hpp"
+#include "shared/sqlite_database.hpp"
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace ydisquette {
+namespace disk_tree {
+
+static const quint8 kFormatVersion = 2;
+
+static QByteArray toBytes(std::string_view s) {
+    return QByteArray(s.data(), static_cast<int>(s.size()));
+}
+
+static std::string_view toView(const QByteArray& b) {
+    return std::string_view(b.constData(), static_cast<size_t>(b.size()));
+}
+
+static QByteArray encodeListing(const NodeList& children) {
+    QByteArray body;
+    QDataStream out(&body, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kFormatVersion << static_cast<quint32>(children.size());
+    for (NodeRef node : children) {
+        out << static_cast<quint8>(node.type()) << toBytes(node.path()) << toBytes(node.name())
+            << toBytes(node.modified()) << static_cast<qint64>(node.size()) << static_cast<qint64>(node.modifiedSec());
+    }
+    return body;
+}
+
+static bool decodeListing(const QByteArray& body, NodeList& children) {
+    QDataStream in(body);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint8 version = 0;
+    quint32 count = 0;
+    in >> version >> count;
+    if (in.status() != QDataStream::Ok || version != kFormatVersion) return false;
+    children.reserve(count, static_cast<size_t>(body.size()));
+    for (quint32 i = 0; i < count; ++i) {
+        quint8 type = 0;
+        QByteArray path, name, modified;
+        qint64 size = 0;
+        qint64 modifiedSec = 0;
+        in >> type >> path >> name >> modified >> size >> modifiedSec;
+        if (in.status() != QDataStream::Ok) return false;
+        children.add(type == static_cast<quint8>(NodeType::Dir) ? NodeType::Dir : NodeType::File, toView(path),
+                     toView(name), size, toView(modified), modifiedSec);
+    }
+    return true;
+}
+
+TreeCacheStore::~TreeCacheStore() {
+    close();
+}
+
+QString TreeCacheStore::pathNextTo(const QString& dbPath) {
+    return QFileInfo(dbPath).absolutePath() + QStringLiteral("/tree_cache.db");
+}
+
+bool TreeCacheStore::open(const QString& dbPath) {
+    if (!connectionName_.isEmpty())
+        return true;
+    QFileInfo fi(dbPath);
+    QDir().mkpath(fi.absolutePath());
+    connectionName_ = QStringLiteral("tree_cache_") + QString::number(reinterpret_cast<quintptr>(this));
+    if (!openSqliteDatabase(connectionName_, dbPath)) {
+        close();
+        return false;
+    }
+    if (!QSqlQuery(queryDb()).exec(QStringLiteral(
+            "CREATE TABLE IF NOT EXISTS tree_cache ("
+            "path TEXT PRIMARY KEY, fetched_at INTEGER NOT NULL, body BLOB NOT NULL)"))) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void TreeCacheStore::close() {
+    if (connectionName_.isEmpty()) return;
+    QSqlDatabase::removeDatabase(connectionName_);
+    connectionName_.clear();
+}
+
+QSqlDatabase TreeCacheStore::queryDb() const {
+    return QSqlDatabase::database(connectionName_);
+}
+
+std::optional<CachedListing> TreeCacheStore::load(const std::string& path) const {
+    if (connectionName_.isEmpty()) return std::nullopt;
+    QSqlQuery q(queryDb());
+    q.prepare(QStringLiteral("SELECT fetched_at, body FROM tree_cache WHERE path = ?"));
+    q.addBindValue(QString::fromStdString(path));
+    if (!q.exec() || !q.next()) return std::nullopt;
+    CachedListing out;
+    out.fetchedAtMs = q.value(0).toLongLong();
+    if (!decodeListing(q.value(1).toByteArray(), out.children)) return std::nullopt;
+    return out;
+}
+
+bool TreeCacheStore::save(const std::string& path, const NodeList& children, qint64 fetchedAtMs) {
+    if (connectionName_.isEmpty()) return false;
+    QSqlQuery q(queryDb());
+    q.prepare(QStringLiteral("INSERT OR REPLACE INTO tree_cache (path, fetched_at, body) VALUES (?, ?, ?)"));
+    q.addBindValue(QString::fromStdString(path));
+    q.addBindValue(fetchedAtMs);
+    q.addBindValue(encodeListing(children));
+    return q.exec();
+}
+
+bool TreeCacheStore::remove(const std::string& path) {
+    if (connectionName_.isEmpty()) return false;
+    QSqlQuery q(queryDb());
+    q.prepare(QStringLiteral("DELETE FROM tree_cache WHERE path = ?"));
+    q.addBindValue(QString::fromStdString(path));
+    return q.exec();
+}
+
+bool TreeCacheStore::clear() {
+    if (connectionName_.isEmpty()) return false;
+    QSqlQuery q(queryDb());
+    return q.exec(QStringLiteral("DELETE FROM tree_cache"));
+}
+
+}  // namespace disk_tree
+}  // namespace ydisquette
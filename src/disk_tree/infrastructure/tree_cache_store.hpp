@@ -0,0 +1,40 @@
+#pragma once
+
+#include "disk_tree/domain/node_list.hpp"
+#include <QSqlDatabase>
+#include <QString>
+#include <optional>
+#include <string>
+
+namespace ydisquette {
+namespace disk_tree {
+
+struct CachedListing {
+    NodeList children;
+    qint64 fetchedAtMs = 0;
+};
+
+class TreeCacheStore {
+public:
+    TreeCacheStore() = default;
+    ~TreeCacheStore();
+
+    bool open(const QString& dbPath);
+    void close();
+    bool isOpen() const { return !connectionName_.isEmpty(); }
+
+    std::optional<CachedListing> load(const std::string& path) const;
+    bool save(const std::string& path, const NodeList& children, qint64 fetchedAtMs);
+    bool remove(const std::string& path);
+    bool clear();
+
+    static QString pathNextTo(const QString& dbPath);
+
+private:
+    QSqlDatabase queryDb() const;
+
+    QString connectionName_;
+};
+
+}  // namespace disk_tree
+}  // namespace ydisquette
@@ -8,6 +8,9 @@ namespace settings {
 struct AppSettings {
     std::string syncPath;
     int maxRetries = 3;
+    int maxParallelDownloads = 4;
+    int maxParallelUploads = 4;
+    bool directUploads = true;
     int refreshIntervalSec = 60;
     int pollTimeSec = 120;
     bool hideToTray = true;
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ydisquette {
+
+namespace iso_datetime_detail {
+
+inline bool readDigits(std::string_view s, size_t pos, size_t count, int& out) {
+    if (pos + count > s.size()) return false;
+    int v = 0;
+    for (size_t i = pos; i < pos + count; ++i) {
+        const unsigned d = static_cast<unsigned char>(s[i]) - static_cast<unsigned>('0');
+        if (d > 9) return false;
+        v = v * 10 + static_cast<int>(d);
+    }
+    out = v;
+    return true;
+}
+
+inline bool isLeapYear(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+inline int daysInMonth(int y, int m) {
+    static const int kDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && isLeapYear(y) ? 29 : kDays[m - 1];
+}
+
+inline int64_t daysFromCivil(int y, int m, int d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const int64_t yoe = y - era * 400;
+    const int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+}  // namespace iso_datetime_detail
+
+inline int64_t parseIsoDateTimeToSec(std::string_view s) {
+    using namespace iso_datetime_detail;
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t' || s.front() == '\n' || s.front() == '\r'))
+        s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\n' || s.back() == '\r'))
+        s.remove_suffix(1);
+    if (s.size() < 19 || s[4] != '-' || s[7] != '-' || (s[10] != 'T' && s[10] != ' ') || s[13] != ':'
+        || s[16] != ':')
+        return 0;
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+    if (!readDigits(s, 0, 4, year) || !readDigits(s, 5, 2, month) || !readDigits(s, 8, 2, day)
+        || !readDigits(s, 11, 2, hour) || !readDigits(s, 14, 2, minute) || !readDigits(s, 17, 2, second))
+        return 0;
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month) || hour > 23 || minute > 59
+        || second > 59)
+        return 0;
+
+    size_t i = 19;
+    if (i < s.size() && (s[i] == '.' || s[i] == ',')) {
+        const size_t start = ++i;
+        while (i < s.size() && s[i] >= '0' && s[i] <= '9') ++i;
+        if (i == start) return 0;
+    }
+    int offsetSec = 0;
+    if (i < s.size()) {
+        if (s[i] == 'Z' || s[i] == 'z') {
+            ++i;
+        } else if (s[i] == '+' || s[i] == '-') {
+            const int sign = s[i] == '-' ? -1 : 1;
+            int offH = 0, offM = 0;
+            if (!readDigits(s, i + 1, 2, offH)) return 0;
+            i += 3;
+            if (i < s.size() && s[i] == ':') ++i;
+            if (i < s.size()) {
+                if (!readDigits(s, i, 2, offM)) return 0;
+                i += 2;
+            }
+            if (offH > 23 || offM > 59) return 0;
+            offsetSec = sign * (offH * 3600 + offM * 60);
+        } else {
+            return 0;
+        }
+    }
+    if (i != s.size()) return 0;
+    return daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offsetSec;
+}
+
+}  // namespace ydisquette
@@ -0,0 +1,267 @@
+#include "shared/json_reader.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace ydisquette {
+
+const int JsonReader::kMaxDepth = 512;
+
+static void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+char JsonReader::peek() {
+    while (pos_ < s_.size()) {
+        const char c = s_[pos_];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') return c;
+        ++pos_;
+    }
+    return '\0';
+}
+
+bool JsonReader::fail() {
+    ok_ = false;
+    pos_ = s_.size();
+    return false;
+}
+
+bool JsonReader::expect(char c) {
+    if (!ok_ || peek() != c) return fail();
+    ++pos_;
+    return true;
+}
+
+bool JsonReader::atEnd() {
+    return ok_ && peek() == '\0' && pos_ == s_.size();
+}
+
+bool JsonReader::isObject() {
+    return ok_ && peek() == '{';
+}
+
+bool JsonReader::isArray() {
+    return ok_ && peek() == '[';
+}
+
+bool JsonReader::beginObject() {
+    if (!expect('{')) return false;
+    first_ = true;
+    return true;
+}
+
+bool JsonReader::beginArray() {
+    if (!expect('[')) return false;
+    first_ = true;
+    return true;
+}
+
+bool JsonReader::nextMember(char close) {
+    if (!ok_) return false;
+    const char c = peek();
+    const bool first = first_;
+    first_ = false;
+    if (c == close) {
+        ++pos_;
+        return false;
+    }
+    if (first) return true;
+    if (c != ',') return fail();
+    ++pos_;
+    return true;
+}
+
+bool JsonReader::nextKey(std::string_view& key) {
+    if (!nextMember('}')) return false;
+    if (peek() != '"' || !parseString(&key_) || !expect(':')) return fail();
+    key = key_;
+    return true;
+}
+
+bool JsonReader::nextElement() {
+    return nextMember(']');
+}
+
+bool JsonReader::parseString(std::string* out) {
+    ++pos_;
+    if (out) out->clear();
+    for (;;) {
+        const size_t start = pos_;
+        while (pos_ < s_.size()) {
+            const unsigned char c = static_cast<unsigned char>(s_[pos_]);
+            if (c == '"' || c == '\\' || c < 0x20) break;
+            ++pos_;
+        }
+        if (out) out->append(s_.data() + start, pos_ - start);
+        if (pos_ >= s_.size()) return fail();
+        const char c = s_[pos_];
+        if (c == '"') {
+            ++pos_;
+            return true;
+        }
+        if (c != '\\' || pos_ + 1 >= s_.size()) return fail();
+        const char e = s_[pos_ + 1];
+        pos_ += 2;
+        char plain = 0;
+        switch (e) {
+        case '"': plain = '"'; break;
+        case '\\': plain = '\\'; break;
+        case '/': plain = '/'; break;
+        case 'b': plain = '\b'; break;
+        case 'f': plain = '\f'; break;
+        case 'n': plain = '\n'; break;
+        case 'r': plain = '\r'; break;
+        case 't': plain = '\t'; break;
+        case 'u': {
+            auto readHex4 = [this](uint32_t& v) {
+                if (pos_ + 4 > s_.size()) return false;
+                v = 0;
+                for (int i = 0; i < 4; ++i) {
+                    const int h = hexValue(s_[pos_ + i]);
+                    if (h < 0) return false;
+                    v = (v << 4) | static_cast<uint32_t>(h);
+                }
+                pos_ += 4;
+                return true;
+            };
+            uint32_t cp = 0;
+            if (!readHex4(cp)) return fail();
+            if (cp >= 0xD800 && cp <= 0xDBFF && pos_ + 1 < s_.size() && s_[pos_] == '\\' && s_[pos_ + 1] == 'u') {
+                const size_t save = pos_;
+                pos_ += 2;
+                uint32_t low = 0;
+                if (readHex4(low) && low >= 0xDC00 && low <= 0xDFFF)
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                else
+                    pos_ = save;
+            }
+            if (cp >= 0xD800 && cp <= 0xDFFF) cp = 0xFFFD;
+            if (out) appendUtf8(*out, cp);
+            continue;
+        }
+        default:
+            return fail();
+        }
+        if (out) *out += plain;
+    }
+}
+
+bool JsonReader::parseNumber(int64_t& out, bool& integral) {
+    const size_t start = pos_;
+    if (pos_ < s_.size() && s_[pos_] == '-') ++pos_;
+    const size_t intStart = pos_;
+    while (pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9') ++pos_;
+    const size_t intDigits = pos_ - intStart;
+    if (intDigits == 0 || (intDigits > 1 && s_[intStart] == '0')) return fail();
+    integral = true;
+    if (pos_ < s_.size() && s_[pos_] == '.') {
+        ++pos_;
+        const size_t fracStart = pos_;
+        while (pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9') ++pos_;
+        if (pos_ == fracStart) return fail();
+        integral = false;
+    }
+    if (pos_ < s_.size() && (s_[pos_] == 'e' || s_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < s_.size() && (s_[pos_] == '+' || s_[pos_] == '-')) ++pos_;
+        const size_t expStart = pos_;
+        while (pos_ < s_.size() && s_[pos_] >= '0' && s_[pos_] <= '9') ++pos_;
+        if (pos_ == expStart) return fail();
+        integral = false;
+    }
+    if (integral && intDigits <= 18) {
+        int64_t v = 0;
+        for (size_t i = intStart; i < intStart + intDigits; ++i) v = v * 10 + (s_[i] - '0');
+        out = s_[start] == '-' ? -v : v;
+        return true;
+    }
+    const std::string text(s_.data() + start, pos_ - start);
+    const double d = std::strtod(text.c_str(), nullptr);
+    integral = std::isfinite(d) && std::trunc(d) == d && d >= -9.2e18 && d <= 9.2e18;
+    out = integral ? static_cast<int64_t>(d) : 0;
+    return true;
+}
+
+bool JsonReader::parseLiteral(std::string_view word) {
+    if (s_.substr(pos_, word.size()) != word) return fail();
+    pos_ += word.size();
+    return true;
+}
+
+bool JsonReader::skipValue(int depth) {
+    if (depth > kMaxDepth) return fail();
+    switch (peek()) {
+    case '{': {
+        beginObject();
+        std::string_view key;
+        while (nextKey(key))
+            if (!skipValue(depth + 1)) return false;
+        return ok_;
+    }
+    case '[':
+        beginArray();
+        while (nextElement())
+            if (!skipValue(depth + 1)) return false;
+        return ok_;
+    case '"':
+        return parseString(nullptr);
+    case 't':
+        return parseLiteral("true");
+    case 'f':
+        return parseLiteral("false");
+    case 'n':
+        return parseLiteral("null");
+    default: {
+        int64_t ignored = 0;
+        bool integral = false;
+        return parseNumber(ignored, integral);
+    }
+    }
+}
+
+bool JsonReader::skipValue() {
+    return ok_ && skipValue(0);
+}
+
+bool JsonReader::readString(std::string& out) {
+    if (ok_ && peek() == '"') return parseString(&out);
+    out.clear();
+    skipValue();
+    return false;
+}
+
+int64_t JsonReader::readInteger(int64_t fallback) {
+    if (!ok_) return fallback;
+    const char c = peek();
+    if (c != '-' && (c < '0' || c > '9')) {
+        skipValue();
+        return fallback;
+    }
+    int64_t v = 0;
+    bool integral = false;
+    if (!parseNumber(v, integral) || !integral) return fallback;
+    return v;
+}
+
+}  // namespace ydisquette
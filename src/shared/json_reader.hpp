@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ydisquette {
+
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text) : s_(text) {}
+
+    bool ok() const { return ok_; }
+    bool atEnd();
+
+    bool isObject();
+    bool isArray();
+    bool beginObject();
+    bool nextKey(std::string_view& key);
+    bool beginArray();
+    bool nextElement();
+
+    bool readString(std::string& out);
+    int64_t readInteger(int64_t fallback);
+    bool skipValue();
+
+private:
+    static const int kMaxDepth;
+
+    char peek();
+    bool fail();
+    bool expect(char c);
+    bool nextMember(char close);
+    bool parseString(std::string* out);
+    bool parseNumber(int64_t& out, bool& integral);
+    bool parseLiteral(std::string_view word);
+    bool skipValue(int depth);
+
+    std::string_view s_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+    bool first_ = false;
+    std::string key_;
+};
+
+}  // namespace ydisquette
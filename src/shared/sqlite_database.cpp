@@ -0,0 +1,29 @@
+#include "shared/sqlite_database.hpp"
+#include "shared/app_log.hpp"
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QVariant>
+
+namespace ydisquette {
+
+static const int kBusyTimeoutMs = 5000;
+static const qint64 kMmapBytes = 64ll * 1024 * 1024;
+static const int kCacheKib = 8192;
+
+bool openSqliteDatabase(const QString& connectionName, const QString& dbPath) {
+    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName);
+    db.setDatabaseName(dbPath);
+    db.setConnectOptions(QStringLiteral("QSQLITE_BUSY_TIMEOUT=") + QString::number(kBusyTimeoutMs));
+    if (!db.open())
+        return false;
+    QSqlQuery q(db);
+    if (!q.exec(QStringLiteral("PRAGMA journal_mode=WAL")) || !q.next()
+        || q.value(0).toString().compare(QLatin1String("wal"), Qt::CaseInsensitive) != 0)
+        ydisquette::logToFile(QStringLiteral("[Db] database not in WAL mode: ") + dbPath);
+    q.exec(QStringLiteral("PRAGMA synchronous=NORMAL"));
+    q.exec(QStringLiteral("PRAGMA cache_size=-") + QString::number(kCacheKib));
+    q.exec(QStringLiteral("PRAGMA mmap_size=") + QString::number(kMmapBytes));
+    return true;
+}
+
+}
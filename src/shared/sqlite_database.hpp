@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QString>
+
+namespace ydisquette {
+
+// Opens a QSQLITE connection in WAL mode with the app-wide busy timeout and cache pragmas.
+// Used for every database that several threads share (sync index, poll runs, tree cache).
+bool openSqliteDatabase(const QString& connectionName, const QString& dbPath);
+
+}
@@ -11,9 +11,6 @@ namespace sync {
 class DownloadFileUseCase {
 public:
     explicit DownloadFileUseCase(DiskResourceClient& client) : client_(client) {}
-    DiskResourceResult run(const std::string& remotePath, const QString& localPath) {
-        return client_.downloadFile(remotePath, localPath);
-    }
     void runAsync(const std::string& remotePath, const QString& localPath,
                   std::function<void(DiskResourceResult)> cb) {
         client_.downloadFileAsync(remotePath, localPath, std::move(cb));
@@ -0,0 +1,59 @@
+#include "sync/application/flat_file_scan.hpp"
+#include "shared/cloud_path_util.hpp"
+#include "shared/app_log.hpp"
+
+namespace ydisquette {
+namespace sync {
+
+const int FlatFileScan::kPageSize = 1000;
+
+bool FlatFileScan::isUnderSelectedRoots(const QString& relativePath, const QStringList& roots) {
+    for (const QString& root : roots) {
+        if (root.isEmpty() || relativePath == root) return true;
+        if (relativePath.size() > root.size() && relativePath.startsWith(root)
+            && relativePath.at(root.size()) == QLatin1Char('/'))
+            return true;
+    }
+    return false;
+}
+
+FlatFileScan::Result FlatFileScan::run(DiskResourceClient& diskClient,
+                                       SyncIndex& index,
+                                       const QString& syncRoot,
+                                       const std::vector<std::string>& selectedPaths,
+                                       std::function<bool()> stopRequested,
+                                       int pageSize) {
+    QStringList roots;
+    for (const std::string& p : selectedPaths)
+        roots.append(cloudPathToRelativeQString(normalizeCloudPath(p)));
+    int scanned = 0;
+    int matched = 0;
+    for (int offset = 0;; offset += pageSize) {
+        if (stopRequested && stopRequested()) return Result::Stopped;
+        std::vector<RemoteFileEntry> files;
+        int itemCount = 0;
+        DiskResourceResult r = diskClient.listFilesPage(pageSize, offset, files, itemCount);
+        if (!r.success) return Result::ListError;
+        scanned += itemCount;
+        QVector<SyncIndexRow> rows;
+        rows.reserve(static_cast<int>(files.size()));
+        for (const RemoteFileEntry& f : files) {
+            QString rel = cloudPathToRelativeQString(f.path);
+            if (rel.isEmpty() || !isUnderSelectedRoots(rel, roots)) continue;
+            rows.append({rel, f.modifiedSec, f.size});
+        }
+        matched += rows.size();
+        if (!index.insertMissing(syncRoot, rows, FileStatus::TO_DOWNLOAD)
+            || !index.commit() || !index.beginTransaction()) {
+            ydisquette::logToFile(QStringLiteral("[Sync] flat scan index flush failed"));
+            return Result::IndexError;
+        }
+        if (itemCount < pageSize) break;
+    }
+    ydisquette::logToFile(QStringLiteral("[Sync] flat scan listed=") + QString::number(scanned)
+        + QStringLiteral(" matched=") + QString::number(matched));
+    return Result::Success;
+}
+
+}  // namespace sync
+}  // namespace ydisquette
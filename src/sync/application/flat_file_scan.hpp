@@ -0,0 +1,31 @@
+#pragma once
+
+#include "sync/infrastructure/disk_resource_client.hpp"
+#include "sync/infrastructure/sync_index.hpp"
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ydisquette {
+namespace sync {
+
+class FlatFileScan {
+public:
+    enum class Result { Success, Stopped, ListError, IndexError };
+
+    static Result run(DiskResourceClient& diskClient,
+                      SyncIndex& index,
+                      const QString& syncRoot,
+                      const std::vector<std::string>& selectedPaths,
+                      std::function<bool()> stopRequested,
+                      int pageSize = kPageSize);
+
+    static bool isUnderSelectedRoots(const QString& relativePath, const QStringList& roots);
+
+    static const int kPageSize;
+};
+
+}  // namespace sync
+}  // namespace ydisquette
@@ -13,7 +13,8 @@ struct ISyncService {
     virtual void startSync(const std::vector<std::string>& selectedPaths,
                           const std::string& syncPath,
                           const QString& indexDbPath = QString(),
-                          int maxRetries = 3) = 0;
+                          int maxRetries = 3,
+                          int maxParallelDownloads = 4) = 0;
     virtual void stopSync() = 0;
     virtual SyncStatus getStatus() const = 0;
 };
@@ -1,51 +1,80 @@
 #include "sync/application/scan_and_fill_index_use_case.hpp"
+#include "sync/application/flat_file_scan.hpp"
+#include "sync/infrastructure/tree_walker.hpp"
 #include "shared/cloud_path_util.hpp"
-#include "sync/domain/cloud_datetime.hpp"
 #include "shared/app_log.hpp"
-#include <QDateTime>
+#include <optional>
 
 namespace ydisquette {
 namespace sync {
 
+const int ScanAndFillIndexUseCase::kFlatScanDirThreshold = 200;
+
 ScanAndFillIndexUseCase::Result ScanAndFillIndexUseCase::run(
     disk_tree::ITreeRepository& treeRepo,
+    DiskResourceClient* diskClient,
     SyncIndex& index,
     const QString& syncRoot,
     const std::vector<std::string>& selectedPaths,
-    std::function<bool()> stopRequested) {
-    std::function<bool(const std::string&)> scanFolder = [&](const std::string& cloudPath) -> bool {
-        if (stopRequested && stopRequested()) return false;
-        std::vector<std::shared_ptr<disk_tree::Node>> children = treeRepo.getChildren(cloudPath);
-        for (const auto& node : children) {
+    std::function<bool()> stopRequested,
+    Mode mode) {
+    if (!diskClient) mode = Mode::Recursive;
+    auto runFlat = [&]() -> std::optional<Result> {
+        FlatFileScan::Result r = FlatFileScan::run(*diskClient, index, syncRoot, selectedPaths, stopRequested);
+        if (r == FlatFileScan::Result::Stopped) return Result::Stopped;
+        if (r == FlatFileScan::Result::IndexError) return Result::IndexError;
+        if (r == FlatFileScan::Result::ListError) return std::nullopt;
+        return index.commit() ? Result::Success : Result::IndexError;
+    };
+    if (mode == Mode::Flat) {
+        if (auto r = runFlat()) return *r;
+        ydisquette::logToFile(QStringLiteral("[Sync] flat scan listing failed, falling back to folder walk"));
+        mode = Mode::Recursive;
+    }
+
+    int dirsSeen = 0;
+    bool switchToFlat = false;
+    bool indexFailed = false;
+    auto visit = [&](const std::string&, const TreeWalker::Children& children, bool) -> bool {
+        for (disk_tree::NodeRef node : children) {
             if (stopRequested && stopRequested()) return false;
-            if (!node) continue;
-            std::string childPath = node->path;
-            if (node->isDir()) {
-                if (!scanFolder(childPath)) return false;
-            } else {
-                QString rel = cloudPathToRelativeQString(childPath);
-                if (rel.isEmpty()) continue;
-                auto entry = index.get(syncRoot, rel);
-                if (!entry) {
-                    qint64 mtimeSec = 0;
-                    if (!node->modified.empty()) {
-                        QDateTime dt = parseCloudModified(node->modified);
-                        if (dt.isValid()) mtimeSec = dt.toSecsSinceEpoch();
-                    }
-                    qint64 size = static_cast<qint64>(node->size);
-                    index.set(syncRoot, rel, mtimeSec, size, QString::fromUtf8(FileStatus::TO_DOWNLOAD), 0);
+            if (node.isDir()) {
+                if (mode == Mode::Auto && ++dirsSeen > kFlatScanDirThreshold) {
+                    switchToFlat = true;
+                    return false;
                 }
+                continue;
+            }
+            QString rel = cloudPathToRelativeQString(node.path());
+            if (rel.isEmpty()) continue;
+            auto entry = index.get(syncRoot, rel);
+            if (!entry) {
+                index.set(syncRoot, rel, node.modifiedSec(), static_cast<qint64>(node.size()),
+                          FileStatus::TO_DOWNLOAD, 0);
             }
         }
         if (!index.commit() || !index.beginTransaction()) {
             ydisquette::logToFile(QStringLiteral("[Sync] scan index flush failed"));
+            indexFailed = true;
             return false;
         }
         return true;
     };
-    for (const std::string& cloudPath : selectedPaths) {
-        if (stopRequested && stopRequested()) return Result::Stopped;
-        if (!scanFolder(cloudPath)) return Result::Stopped;
+    auto walk = [&]() {
+        TreeWalker walker(treeRepo);
+        for (const std::string& cloudPath : selectedPaths)
+            walker.add(cloudPath);
+        return walker.run(visit, stopRequested);
+    };
+    if (!walk()) {
+        if (indexFailed) return Result::IndexError;
+        if (!switchToFlat) return Result::Stopped;
+        ydisquette::logToFile(QStringLiteral("[Sync] scan found more than ") + QString::number(kFlatScanDirThreshold)
+            + QStringLiteral(" folders, switching to flat file listing"));
+        if (auto r = runFlat()) return *r;
+        ydisquette::logToFile(QStringLiteral("[Sync] flat scan listing failed, continuing folder walk"));
+        mode = Mode::Recursive;
+        if (!walk()) return indexFailed ? Result::IndexError : Result::Stopped;
     }
     if (!index.commit())
         return Result::IndexError;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "sync/domain/sync_file_status.hpp"
+#include "sync/infrastructure/disk_resource_client.hpp"
 #include "sync/infrastructure/sync_index.hpp"
 #include <disk_tree/application/itree_repository.hpp>
 #include <functional>
@@ -14,12 +15,17 @@ namespace sync {
 class ScanAndFillIndexUseCase {
 public:
     enum class Result { Success, Stopped, IndexError };
+    enum class Mode { Auto, Recursive, Flat };
 
     static Result run(disk_tree::ITreeRepository& treeRepo,
+                      DiskResourceClient* diskClient,
                       SyncIndex& index,
                       const QString& syncRoot,
                       const std::vector<std::string>& selectedPaths,
-                      std::function<bool()> stopRequested);
+                      std::function<bool()> stopRequested,
+                      Mode mode = Mode::Auto);
+
+    static const int kFlatScanDirThreshold;
 };
 
 }  // namespace sync
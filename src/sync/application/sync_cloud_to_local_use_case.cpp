@@ -3,13 +3,17 @@
 #include "sync/domain/cloud_local_compare.hpp"
 #include "sync/domain/sync_file_status.hpp"
 #include "sync/application/sync_path_mapper.hpp"
+#include "sync/infrastructure/transfer_pool.hpp"
+#include "sync/infrastructure/tree_walker.hpp"
 #include "shared/app_log.hpp"
+#include <QDateTime>
 #include <QDir>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QSet>
 #include <algorithm>
+#include <memory>
 
 namespace ydisquette {
 namespace sync {
@@ -27,13 +31,14 @@ SyncCloudToLocalUseCase::Result SyncCloudToLocalUseCase::run(
     const QString& localRoot,
     const std::vector<std::string>& selectedPaths,
     int maxRetries,
+    int maxParallelDownloads,
     std::function<bool()> stopRequested,
     const SyncCloudToLocalCallbacks& callbacks) {
     const bool useIndex = index != nullptr;
     qint64 throughputBytes = 0;
 
     auto flushIndex = [useIndex, index]() {
-        if (useIndex && index && index->commit()) index->beginTransaction();
+        if (useIndex && index) index->flushBatched();
     };
 
     auto toRelativePath = [&syncRoot](const QString& localPath) -> QString {
@@ -41,7 +46,7 @@ SyncCloudToLocalUseCase::Result SyncCloudToLocalUseCase::run(
     };
 
     if (useIndex && index) {
-        QStringList cloudDeleted = index->getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::CLOUD_DELETED));
+        QStringList cloudDeleted = index->getRelativePathsWithStatus(syncRoot, FileStatus::CLOUD_DELETED);
         std::sort(cloudDeleted.begin(), cloudDeleted.end(), [](const QString& a, const QString& b) {
             return a.length() > b.length() || (a.length() == b.length() && a > b);
         });
@@ -63,8 +68,8 @@ SyncCloudToLocalUseCase::Result SyncCloudToLocalUseCase::run(
                     callbacks.onError(QStringLiteral("Failed to remove local file: ") + localPath);
             }
         }
-        QStringList toDownload = index->getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::TO_DOWNLOAD));
-        toDownload.append(index->getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::DOWNLOADING)));
+        QStringList toDownload = index->getRelativePathsWithStatus(syncRoot, FileStatus::TO_DOWNLOAD);
+        toDownload.append(index->getRelativePathsWithStatus(syncRoot, FileStatus::DOWNLOADING));
         toDownload.removeDuplicates();
         if (toDownload.isEmpty()) {
             if (!index->commit())
@@ -73,116 +78,165 @@ SyncCloudToLocalUseCase::Result SyncCloudToLocalUseCase::run(
         }
     }
 
-    std::function<bool(const std::string&)> syncFolder = [&](const std::string& cloudPath) -> bool {
+    TransferPool pool(maxParallelDownloads);
+
+    auto markSynced = [&](const QString& localPath) {
+        if (!useIndex || !index) return;
+        QString rel = normRel(toRelativePath(localPath));
+        if (rel.isEmpty()) return;
+        auto entry = index->get(syncRoot, rel);
+        if (entry && entry->status == FileStatus::TO_DELETE) return;
+        QFileInfo fi2(localPath);
+        if (entry && entry->status == FileStatus::SYNCED
+            && entry->size == fi2.size()
+            && entry->mtime_sec == fi2.lastModified().toSecsSinceEpoch())
+            return;
+        if (!index->set(syncRoot, rel, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
+                        FileStatus::SYNCED, 0))
+            ydisquette::logToFile(QStringLiteral("[Sync] index set FAIL (cloud→local) ") + rel);
+        flushIndex();
+    };
+
+    auto resumeOffsetFor = [&](const QString& localPath, qint64 remoteSize) -> qint64 {
+        if (!useIndex || !index) return 0;
+        QString rel = normRel(toRelativePath(localPath));
+        if (rel.isEmpty()) return 0;
+        auto entry = index->get(syncRoot, rel);
+        if (!entry || entry->part_remote_size != remoteSize) return 0;
+        return (entry->part_offset > 0 && entry->part_offset < remoteSize) ? entry->part_offset : 0;
+    };
+
+    auto markDownloadFailed = [&](const QString& rel, const DiskResourceResult& dr, qint64 remoteSize) {
+        auto entry = index->get(syncRoot, rel);
+        index->setPartial(syncRoot, rel, dr.partialBytes, dr.partialBytes > 0 ? remoteSize : 0);
+        if (stopRequested && stopRequested()) {
+            index->setStatus(syncRoot, rel, FileStatus::TO_DOWNLOAD, 0);
+            flushIndex();
+            return;
+        }
+        int newRetries = (entry ? entry->retries : 0) + 1;
+        FileStatus newStatus = (newRetries >= maxRetries) ? FileStatus::FAILED : FileStatus::TO_DOWNLOAD;
+        index->setStatus(syncRoot, rel, newStatus, 1);
+        ydisquette::logToFile(QStringLiteral("[Sync] download failed ") + rel
+            + QStringLiteral(" retries=") + QString::number(newRetries));
+        flushIndex();
+    };
+
+    auto enqueueDownload = [&](const std::string& remotePath, const QString& localPath, qint64 fileSize,
+                               std::function<void(const DiskResourceResult&)> onFinished) {
+        const qint64 resumeFrom = resumeOffsetFor(localPath, fileSize);
+        pool.enqueue([&, remotePath, localPath, fileSize, resumeFrom, onFinished](TransferPool::Done done) {
+            if (stopRequested && stopRequested()) {
+                done();
+                return;
+            }
+            ydisquette::logToFile(QStringLiteral("[Sync] download start ") + QString::fromStdString(remotePath)
+                + QStringLiteral(" size=") + QString::number(fileSize)
+                + (resumeFrom > 0 ? QStringLiteral(" resume=") + QString::number(resumeFrom) : QString()));
+            auto fileTimer = std::make_shared<QElapsedTimer>();
+            fileTimer->start();
+            auto onDownloaded =
+                [&, remotePath, localPath, fileSize, resumeFrom, fileTimer, onFinished, done](DiskResourceResult dr) {
+                    if (dr.success) {
+                        const qint64 fetched = fileSize - resumeFrom;
+                        ydisquette::logToFile(QStringLiteral("[Sync] download OK ") + QString::fromStdString(remotePath));
+                        if (callbacks.onProgressMessage)
+                            callbacks.onProgressMessage(QStringLiteral("cloud→local OK ") + QString::fromStdString(remotePath));
+                        throughputBytes += fetched;
+                        pool.recordTransferred(fetched);
+                        if (callbacks.onThroughput)
+                            callbacks.onThroughput(pool.maxParallel() > 1
+                                ? pool.bytesPerSecond()
+                                : fetched * 1000 / qMax(qint64(1), fileTimer->elapsed()));
+                    } else if (!useIndex || !index) {
+                        QFile::remove(partialDownloadPath(localPath));
+                    }
+                    onFinished(dr);
+                    done();
+                };
+            if (resumeFrom == 0 && fileSize >= DiskResourceClient::kSegmentedDownloadThreshold)
+                diskClient.downloadFileSegmentedAsync(remotePath, localPath, fileSize, onDownloaded);
+            else
+                diskClient.downloadFileAsync(remotePath, localPath, onDownloaded, resumeFrom);
+        }, [&diskClient, remotePath]() { diskClient.prefetchDownloadHref(remotePath); });
+    };
+
+    auto syncFolder = [&](const std::string& cloudPath, const TreeWalker::Children& children, bool listed) -> bool {
         if (stopRequested && stopRequested()) return false;
         if (callbacks.onProgressMessage)
             callbacks.onProgressMessage(QString::fromStdString(cloudPath));
-        std::vector<std::shared_ptr<disk_tree::Node>> children = treeRepo.getChildren(cloudPath);
         QString localDir = localRoot + cloudPathToRelativeQString(cloudPath);
-        for (const auto& node : children) {
+        for (disk_tree::NodeRef node : children) {
             if (stopRequested && stopRequested()) return false;
-            if (!node) continue;
-            std::string remotePath = node->path;
+            std::string remotePath = node.path();
             QString localPath = localRoot + cloudPathToRelativeQString(remotePath);
-            if (node->isDir()) {
-                if (!syncFolder(remotePath)) return false;
-            } else {
+            if (!node.isDir()) {
                 QFileInfo fi(localPath);
                 bool exists = fi.exists();
                 bool empty = fi.size() == 0;
-                bool needDownload = !exists || empty || cloudNewerThanLocal(node.get(), localPath);
+                bool needDownload = !exists || empty || cloudNewerThanLocal(node.modifiedSec(), localPath);
                 if (useIndex && index) {
                     QString rel = normRel(toRelativePath(localPath));
                     if (!rel.isEmpty()) {
                         auto entry = index->get(syncRoot, rel);
-                        if (entry && entry->status == QLatin1String(FileStatus::TO_DELETE))
+                        if (entry && entry->status == FileStatus::TO_DELETE)
                             needDownload = false;
-                        else if (entry && FileStatus::needsDownload(entry->status))
+                        else if (entry && needsDownload(entry->status))
                             needDownload = true;
                         else if (entry && entry->status == FileStatus::SYNCED && exists
-                                 && fi.size() == static_cast<qint64>(node->size)
-                                 && entry->size == static_cast<qint64>(node->size))
+                                 && fi.size() == static_cast<qint64>(node.size())
+                                 && entry->size == static_cast<qint64>(node.size()))
                             needDownload = false;
                     }
                 }
                 if (!needDownload) {
-                } else {
-                    if (useIndex && index) {
-                        QString rel = normRel(toRelativePath(localPath));
-                        if (!rel.isEmpty()) {
-                            auto entry = index->get(syncRoot, rel);
-                            if (entry && entry->status == QLatin1String(FileStatus::TO_DELETE))
-                                continue;
-                            if (!entry) index->upsertNew(syncRoot, rel, 0, 0);
-                            index->setStatus(syncRoot, rel, QString::fromUtf8(FileStatus::DOWNLOADING), 0);
-                            flushIndex();
-                        }
-                    }
-                    if (callbacks.onProgressMessage)
-                        callbacks.onProgressMessage(QStringLiteral("cloud→local ") + QString::fromStdString(remotePath));
-                    QString parentDir = QFileInfo(localPath).absolutePath();
-                    if (!QDir().mkpath(parentDir)) {
-                        if (callbacks.onError)
-                            callbacks.onError(QStringLiteral("Failed to create directory: ") + parentDir);
-                        continue;
-                    }
-                    ydisquette::logToFile(QStringLiteral("[Sync] download start ") + QString::fromStdString(remotePath)
-                        + QStringLiteral(" size=") + QString::number(node ? static_cast<qint64>(node->size) : 0));
-                    QElapsedTimer fileTimer;
-                    fileTimer.start();
-                    DiskResourceResult dr = diskClient.downloadFile(remotePath, localPath);
-                    if (dr.success) {
-                        ydisquette::logToFile(QStringLiteral("[Sync] download OK ") + QString::fromStdString(remotePath));
-                        if (callbacks.onProgressMessage)
-                            callbacks.onProgressMessage(QStringLiteral("cloud→local OK ") + QString::fromStdString(remotePath));
-                        throughputBytes += static_cast<qint64>(node->size);
-                        qint64 fileMs = qMax(qint64(1), fileTimer.elapsed());
-                        qint64 fileSize = static_cast<qint64>(node->size);
-                        if (callbacks.onThroughput)
-                            callbacks.onThroughput(fileSize * 1000 / fileMs);
+                    markSynced(localPath);
+                    continue;
+                }
+                if (useIndex && index) {
+                    QString rel = normRel(toRelativePath(localPath));
+                    if (!rel.isEmpty()) {
+                        auto entry = index->get(syncRoot, rel);
+                        if (entry && entry->status == FileStatus::TO_DELETE)
+                            continue;
+                        if (!entry) index->upsertNew(syncRoot, rel, 0, 0);
+                        index->setStatus(syncRoot, rel, FileStatus::DOWNLOADING, 0);
+                        flushIndex();
                     }
-                    if (!dr.success) {
+                }
+                if (callbacks.onProgressMessage)
+                    callbacks.onProgressMessage(QStringLiteral("cloud→local ") + QString::fromStdString(remotePath));
+                QString parentDir = QFileInfo(localPath).absolutePath();
+                if (!QDir().mkpath(parentDir)) {
+                    if (callbacks.onError)
+                        callbacks.onError(QStringLiteral("Failed to create directory: ") + parentDir);
+                    continue;
+                }
+                const qint64 remoteSize = static_cast<qint64>(node.size());
+                enqueueDownload(remotePath, localPath, remoteSize,
+                    [&, localPath, remoteSize](const DiskResourceResult& dr) {
+                        if (dr.success) {
+                            markSynced(localPath);
+                            return;
+                        }
                         if (useIndex && index) {
                             QString rel = normRel(toRelativePath(localPath));
-                            if (!rel.isEmpty()) {
-                                auto entry = index->get(syncRoot, rel);
-                                int newRetries = (entry ? entry->retries : 0) + 1;
-                                QString newStatus = (newRetries >= maxRetries)
-                                    ? QString::fromUtf8(FileStatus::FAILED)
-                                    : QString::fromUtf8(FileStatus::TO_DOWNLOAD);
-                                index->setStatus(syncRoot, rel, newStatus, 1);
-                                ydisquette::logToFile(QStringLiteral("[Sync] download failed ") + rel
-                                    + QStringLiteral(" retries=") + QString::number(newRetries));
-                                flushIndex();
-                            }
+                            if (!rel.isEmpty()) markDownloadFailed(rel, dr, remoteSize);
                         }
-                        if (callbacks.onError)
+                        if (callbacks.onError && !(stopRequested && stopRequested()))
                             callbacks.onError(QStringLiteral("Download failed (HTTP %1). Yandex: %2")
                                                   .arg(dr.httpStatus).arg(dr.errorMessage));
-                        continue;
-                    }
-                }
-                if (useIndex && index) {
-                    QString rel = normRel(toRelativePath(localPath));
-                    if (rel.isEmpty()) continue;
-                    auto entry = index->get(syncRoot, rel);
-                    if (entry && entry->status == QLatin1String(FileStatus::TO_DELETE)) continue;
-                    QFileInfo fi2(localPath);
-                    if (entry && entry->status == QLatin1String(FileStatus::SYNCED)
-                        && entry->size == fi2.size()
-                        && entry->mtime_sec == fi2.lastModified().toSecsSinceEpoch())
-                        continue;
-                    if (!index->set(syncRoot, rel, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
-                                    QString::fromUtf8(FileStatus::SYNCED), 0))
-                        ydisquette::logToFile(QStringLiteral("[Sync] index set FAIL (cloud→local) ") + rel);
-                    flushIndex();
-                }
+                    });
             }
         }
+        if (!listed)
+            return true;
         QSet<QString> cloudNames;
-        for (const auto& node : children)
-            if (node && !node->name.empty())
-                cloudNames.insert(QString::fromStdString(node->name));
+        for (disk_tree::NodeRef node : children) {
+            const std::string_view name = node.name();
+            if (!name.empty())
+                cloudNames.insert(QString::fromUtf8(name.data(), static_cast<int>(name.size())));
+        }
         if (!QDir(localDir).exists())
             return true;
         QDir dir(localDir);
@@ -190,12 +244,13 @@ SyncCloudToLocalUseCase::Result SyncCloudToLocalUseCase::run(
         for (const QString& name : localNames) {
             if (stopRequested && stopRequested()) return false;
             if (cloudNames.contains(name)) continue;
+            if (isPartialDownloadPath(name) && cloudNames.contains(partialDownloadTarget(name))) continue;
             QString localPath = localDir + QLatin1Char('/') + name;
             QString rel = normRel(toRelativePath(localPath));
             if (rel.isEmpty()) continue;
             if (useIndex && index) {
                 if (index->hasAnyUnderPrefixWithStatus(syncRoot, rel,
-                    {QString::fromUtf8(FileStatus::NEW), QString::fromUtf8(FileStatus::UPLOADING)}))
+                    {FileStatus::NEW, FileStatus::UPLOADING}))
                     continue;
             }
             QFileInfo fi(localPath);
@@ -222,66 +277,58 @@ SyncCloudToLocalUseCase::Result SyncCloudToLocalUseCase::run(
         return true;
     };
 
-    std::function<bool(const std::string&)> downloadToDownloadOnly = [&](const std::string& cloudPath) -> bool {
+    auto downloadToDownloadOnly = [&](const std::string&, const TreeWalker::Children& children, bool) -> bool {
         if (stopRequested && stopRequested()) return false;
-        std::vector<std::shared_ptr<disk_tree::Node>> children = treeRepo.getChildren(cloudPath);
-        QString localDir = localRoot + cloudPathToRelativeQString(cloudPath);
-        for (const auto& node : children) {
+        for (disk_tree::NodeRef node : children) {
             if (stopRequested && stopRequested()) return false;
-            if (!node) continue;
-            std::string remotePath = node->path;
+            std::string remotePath = node.path();
             QString localPath = localRoot + cloudPathToRelativeQString(remotePath);
-            if (node->isDir()) {
-                if (!downloadToDownloadOnly(remotePath)) return false;
-            } else if (useIndex && index) {
+            if (!node.isDir() && useIndex && index) {
                 QString rel = normRel(toRelativePath(localPath));
                 if (rel.isEmpty()) continue;
                 auto entry = index->get(syncRoot, rel);
-                if (!entry || !FileStatus::needsDownload(entry->status)) continue;
-                index->setStatus(syncRoot, rel, QString::fromUtf8(FileStatus::DOWNLOADING), 0);
+                if (!entry || !needsDownload(entry->status)) continue;
+                index->setStatus(syncRoot, rel, FileStatus::DOWNLOADING, 0);
                 flushIndex();
                 if (callbacks.onProgressMessage)
                     callbacks.onProgressMessage(QStringLiteral("cloud→local ") + QString::fromStdString(remotePath));
                 if (!QDir().mkpath(QFileInfo(localPath).absolutePath())) continue;
-                DiskResourceResult dr = diskClient.downloadFile(remotePath, localPath);
-                if (dr.success) {
-                    throughputBytes += static_cast<qint64>(node->size);
-                    QFileInfo fi2(localPath);
-                    index->set(syncRoot, rel, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
-                               QString::fromUtf8(FileStatus::SYNCED), 0);
-                    flushIndex();
-                } else {
-                    int newRetries = (entry ? entry->retries : 0) + 1;
-                    QString newStatus = (newRetries >= maxRetries)
-                        ? QString::fromUtf8(FileStatus::FAILED)
-                        : QString::fromUtf8(FileStatus::TO_DOWNLOAD);
-                    index->setStatus(syncRoot, rel, newStatus, 1);
-                    flushIndex();
-                }
+                const qint64 remoteSize = static_cast<qint64>(node.size());
+                enqueueDownload(remotePath, localPath, remoteSize,
+                    [&, localPath, rel, remoteSize](const DiskResourceResult& dr) {
+                        if (dr.success) {
+                            QFileInfo fi2(localPath);
+                            index->set(syncRoot, rel, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
+                                       FileStatus::SYNCED, 0);
+                            flushIndex();
+                        } else {
+                            markDownloadFailed(rel, dr, remoteSize);
+                        }
+                    });
             }
         }
         return true;
     };
 
-    if (useIndex && index) {
-        for (const std::string& cloudPath : selectedPaths) {
-            if (stopRequested && stopRequested()) return Result::Stopped;
-            if (!downloadToDownloadOnly(cloudPath))
-                return (stopRequested && stopRequested()) ? Result::Stopped : Result::Error;
-        }
-    } else {
-        for (const std::string& cloudPath : selectedPaths) {
-            if (stopRequested && stopRequested()) return Result::Stopped;
-            if (callbacks.onProgressMessage)
-                callbacks.onProgressMessage(QString::fromStdString(cloudPath));
-            if (!syncFolder(cloudPath))
-                return (stopRequested && stopRequested()) ? Result::Stopped : Result::Error;
-        }
-    }
+    auto finish = [&](Result result) {
+        if (!pool.waitForIdle(stopRequested) && result == Result::Success)
+            result = Result::Stopped;
+        if (result == Result::Success && useIndex && index && !index->commit())
+            ydisquette::logToFile(QStringLiteral("[Sync] cloud→local index commit FAIL"));
+        return result;
+    };
+
+    if (stopRequested && stopRequested()) return finish(Result::Stopped);
+    TreeWalker walker(treeRepo);
+    for (const std::string& cloudPath : selectedPaths)
+        walker.add(cloudPath);
+    const bool walked = (useIndex && index)
+        ? walker.run(downloadToDownloadOnly, stopRequested)
+        : walker.run(syncFolder, stopRequested);
+    if (!walked)
+        return finish((stopRequested && stopRequested()) ? Result::Stopped : Result::Error);
 
-    if (useIndex && index && !index->commit())
-        ydisquette::logToFile(QStringLiteral("[Sync] cloud→local index commit FAIL"));
-    return Result::Success;
+    return finish(Result::Success);
 }
 
 }  // namespace sync
@@ -29,6 +29,7 @@ public:
                      const QString& localRoot,
                      const std::vector<std::string>& selectedPaths,
                      int maxRetries,
+                     int maxParallelDownloads,
                      std::function<bool()> stopRequested,
                      const SyncCloudToLocalCallbacks& callbacks);
 };
@@ -3,12 +3,16 @@
 #include "sync/application/sync_path_mapper.hpp"
 #include "shared/cloud_path_util.hpp"
 #include "sync/domain/cloud_local_compare.hpp"
+#include "sync/infrastructure/transfer_pool.hpp"
+#include "sync/infrastructure/tree_walker.hpp"
 #include "shared/app_log.hpp"
+#include <QDateTime>
 #include <QDir>
-#include <QElapsedTimer>
 #include <QFileInfo>
 #include <map>
 #include <set>
+#include <string_view>
+#include <unordered_map>
 
 namespace ydisquette {
 namespace sync {
@@ -26,6 +30,8 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
     const QString& localRoot,
     const std::vector<std::string>& selectedPaths,
     int maxRetries,
+    int maxParallelUploads,
+    bool directUploads,
     std::function<bool()> stopRequested,
     const SyncLocalToCloudCallbacks& callbacks) {
     const bool useIndex = index != nullptr;
@@ -77,11 +83,11 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
     }
 
     auto flushIndex = [useIndex, index]() {
-        if (useIndex && index && index->commit()) index->beginTransaction();
+        if (useIndex && index) index->flushBatched();
     };
 
     if (useIndex && index && !syncRoot.isEmpty()) {
-        QStringList toDeletePaths = index->getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::TO_DELETE));
+        QStringList toDeletePaths = index->getRelativePathsWithStatus(syncRoot, FileStatus::TO_DELETE);
         if (!toDeletePaths.isEmpty()) {
             ToDeleteBatches batches = computeToDeleteBatches(toDeletePaths);
             for (const QString& rel : batches.rootFiles) {
@@ -127,45 +133,168 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
         return normRel(localPathToRelative(localPath, syncRoot));
     };
 
+    TransferPool pool(maxParallelUploads);
+    std::map<quint64, qint64> liveRates;
+    quint64 nextUploadId = 0;
+
+    auto reportThroughput = [&]() {
+        if (!callbacks.onThroughput) return;
+        if (liveRates.empty()) {
+            callbacks.onThroughput(pool.bytesPerSecond());
+            return;
+        }
+        qint64 total = 0;
+        for (const auto& r : liveRates) total += r.second;
+        callbacks.onThroughput(total);
+    };
+
+    auto markUploadFailed = [&](const QString& localPath) {
+        if (!useIndex || !index || (stopRequested && stopRequested())) return;
+        QString rel = toRelativePath(localPath);
+        if (rel.isEmpty()) return;
+        auto entry = index->get(syncRoot, rel);
+        int newRetries = (entry ? entry->retries : 0) + 1;
+        FileStatus newStatus = (newRetries >= maxRetries) ? FileStatus::FAILED : FileStatus::UPLOADING;
+        index->setStatus(syncRoot, rel, newStatus, 1);
+        ydisquette::logToFile(QStringLiteral("[Sync] upload failed ") + rel
+            + QStringLiteral(" retries=") + QString::number(newRetries));
+        flushIndex();
+    };
+
+    auto finishUpload = [&](const QString& localPath, const std::string& originalCloudPath, qint64 fileSize) {
+        QString relOk = toRelativePath(localPath);
+        if (!relOk.isEmpty())
+            ydisquette::logToFile(QStringLiteral("[Sync] upload OK ") + relOk);
+        if (callbacks.onProgressMessage)
+            callbacks.onProgressMessage(QStringLiteral("local→cloud OK ") + QString::fromStdString(originalCloudPath));
+        pool.recordTransferred(fileSize);
+        reportThroughput();
+        if (useIndex && index && !relOk.isEmpty()) {
+            QFileInfo fi(localPath);
+            index->set(syncRoot, relOk, fi.lastModified().toSecsSinceEpoch(), fi.size(),
+                       FileStatus::SYNCED, 0);
+            flushIndex();
+        }
+    };
+
+    auto verifyUpload = [&](const QString& localPath, const std::string& cloudPath, qint64 fileSize,
+                            const QString& uploadedMd5, TransferPool::Done done) {
+        diskClient.statFileAsync(cloudPath, [&, localPath, cloudPath, fileSize, uploadedMd5, done](DiskResourceResult sr,
+                                                                                                   RemoteFileInfo info) {
+            QString mismatch;
+            if (!sr.success)
+                mismatch = sr.errorMessage;
+            else if (info.size != fileSize || QFileInfo(localPath).size() != fileSize)
+                mismatch = QStringLiteral("size %1, expected %2").arg(info.size).arg(fileSize);
+            else if (!info.md5.isEmpty() && info.md5.compare(uploadedMd5, Qt::CaseInsensitive) != 0)
+                mismatch = QStringLiteral("md5 %1").arg(info.md5);
+            if (!mismatch.isEmpty()) {
+                markUploadFailed(localPath);
+                if (callbacks.onError)
+                    callbacks.onError(QStringLiteral("Upload verification failed (local→cloud): ")
+                                      + QString::fromStdString(cloudPath) + QStringLiteral(": ") + mismatch);
+            } else {
+                finishUpload(localPath, cloudPath, fileSize);
+            }
+            done();
+        });
+    };
+
+    auto enqueueUpload = [&](const QString& localPath, const std::string& originalCloudPath) {
+        const std::string targetCloudPath = directUploads ? originalCloudPath : tempUploadPath(originalCloudPath);
+        pool.enqueue([&, localPath, originalCloudPath, targetCloudPath](TransferPool::Done done) {
+            if (stopRequested && stopRequested()) {
+                done();
+                return;
+            }
+            if (callbacks.onProgressMessage)
+                callbacks.onProgressMessage(QStringLiteral("local→cloud ") + QString::fromStdString(targetCloudPath));
+            const qint64 fileSize = QFileInfo(localPath).size();
+            ydisquette::logToFile(QStringLiteral("[Sync] upload start ") + QString::fromStdString(targetCloudPath)
+                + QStringLiteral(" size=") + QString::number(fileSize));
+            const quint64 uploadId = nextUploadId++;
+            diskClient.uploadFileAsync(targetCloudPath, localPath,
+                [&, uploadId](qint64 bytesPerSec) {
+                    liveRates[uploadId] = bytesPerSec;
+                    reportThroughput();
+                },
+                [&, localPath, originalCloudPath, targetCloudPath, fileSize, uploadId, done](DiskResourceResult ur) {
+                    liveRates.erase(uploadId);
+                    if (!ur.success) {
+                        markUploadFailed(localPath);
+                        if (callbacks.onError && !(stopRequested && stopRequested()))
+                            callbacks.onError(QStringLiteral("Upload failed (local→cloud): ") + ur.errorMessage);
+                        done();
+                        return;
+                    }
+                    if (directUploads) {
+                        verifyUpload(localPath, originalCloudPath, fileSize, ur.md5, done);
+                        return;
+                    }
+                    diskClient.deleteResourceAsync(originalCloudPath,
+                        [&, localPath, originalCloudPath, targetCloudPath, fileSize, done](DiskResourceResult) {
+                            diskClient.moveResourceAsync(targetCloudPath, originalCloudPath,
+                                [&, localPath, originalCloudPath, fileSize, done](DiskResourceResult mr) {
+                                    if (!mr.success) {
+                                        if (callbacks.onError)
+                                            callbacks.onError(QStringLiteral("Move failed (local→cloud): ") + mr.errorMessage);
+                                    } else {
+                                        finishUpload(localPath, originalCloudPath, fileSize);
+                                    }
+                                    done();
+                                });
+                        });
+                });
+        }, [&diskClient, targetCloudPath]() { diskClient.prefetchUploadHref(targetCloudPath); });
+    };
+
     std::set<std::string> createdFolders;
-    std::function<bool(const QString&, const std::string&)> syncLocalToCloudFolder = [&](const QString& localDirPath, const std::string& cloudPath) -> bool {
+    auto noteCloudFolder = [&](const std::string& cloudPath, const DiskResourceResult& cr) -> bool {
+        if (!cr.success && cr.httpStatus != 409) {
+            if (callbacks.onError)
+                callbacks.onError(QStringLiteral("Create folder failed (local→cloud): ") + cr.errorMessage);
+            return false;
+        }
+        if (cr.success && (cr.httpStatus == 200 || cr.httpStatus == 201))
+            createdFolders.insert(normalizeCloudPath(cloudPath));
+        return true;
+    };
+    auto createCloudFolder = [&](const std::string& cloudPath) -> bool {
+        return noteCloudFolder(cloudPath, diskClient.createFolder(cloudPath));
+    };
+
+    TreeWalker walker(treeRepo);
+    walker.setDescendIntoDirs(false);
+    std::map<std::string, QString> localDirFor;
+    auto syncLocalToCloudFolder = [&](const std::string& cloudPath, const TreeWalker::Children& cloudChildren, bool) -> bool {
         if (stopRequested && stopRequested()) return false;
+        const QString localDirPath = localDirFor[cloudPath];
+        localDirFor.erase(cloudPath);
         QDir dir(localDirPath);
         if (!dir.exists()) return true;
-        if (!cloudPath.empty() && cloudPath != "/") {
-            DiskResourceResult cr = diskClient.createFolder(cloudPath);
-            if (!cr.success && cr.httpStatus != 409) {
-                if (callbacks.onError)
-                    callbacks.onError(QStringLiteral("Create folder failed (local→cloud): ") + cr.errorMessage);
-                return false;
-            }
-            if (cr.success && (cr.httpStatus == 200 || cr.httpStatus == 201))
-                createdFolders.insert(normalizeCloudPath(cloudPath));
-        }
         const QStringList localNames = dir.entryList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot);
-        std::vector<std::shared_ptr<disk_tree::Node>> cloudChildren = treeRepo.getChildren(cloudPath);
-        std::map<std::string, disk_tree::Node*> cloudByName;
-        for (const auto& n : cloudChildren)
-            if (n && !n->name.empty()) cloudByName[n->name] = n.get();
+        std::unordered_map<std::string_view, disk_tree::NodeRef> cloudByName;
+        cloudByName.reserve(cloudChildren.size());
+        for (disk_tree::NodeRef n : cloudChildren)
+            if (!n.name().empty()) cloudByName.emplace(n.name(), n);
 
         for (const QString& name : localNames) {
             if (stopRequested && stopRequested()) return false;
+            if (isPartialDownloadPath(name)) continue;
             const QString localPath = localDirPath + QLatin1Char('/') + name;
             const std::string nameStr = name.toStdString();
             const std::string childCloudPath = std::string(cloudPath) + (cloudPath.empty() || cloudPath.back() == '/' ? "" : "/") + nameStr;
             if (QFileInfo(localPath).isDir()) {
-                DiskResourceResult cr = diskClient.createFolder(childCloudPath);
-                if (!cr.success && cr.httpStatus != 409) {
-                    if (callbacks.onError)
-                        callbacks.onError(QStringLiteral("Create folder failed (local→cloud): ") + cr.errorMessage);
-                    continue;
-                }
-                if (cr.success && (cr.httpStatus == 200 || cr.httpStatus == 201))
-                    createdFolders.insert(normalizeCloudPath(childCloudPath));
-                if (!syncLocalToCloudFolder(localPath, childCloudPath)) continue;
+                walker.addAfter(childCloudPath, [&, childCloudPath, localPath](std::function<void(bool)> proceed) {
+                    diskClient.createFolderAsync(childCloudPath, [&, childCloudPath, localPath, proceed](DiskResourceResult cr) {
+                        const bool created = noteCloudFolder(childCloudPath, cr);
+                        if (created) localDirFor[childCloudPath] = localPath;
+                        proceed(created);
+                    });
+                });
             } else {
                 auto it = cloudByName.find(nameStr);
-                disk_tree::Node* cloudNode = (it != cloudByName.end()) ? it->second : nullptr;
+                const bool inCloud = it != cloudByName.end();
                 bool needUpload = false;
                 if (useIndex && index) {
                     QString rel = toRelativePath(localPath);
@@ -175,14 +304,14 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
                         qint64 msec = fi.lastModified().toSecsSinceEpoch();
                         qint64 sz = fi.size();
                         needUpload = !entry || entry->mtime_sec != msec || entry->size != sz
-                            || FileStatus::needsUpload(entry->status);
+                            || needsUpload(entry->status);
                     } else {
                         needUpload = true;
                     }
                 } else {
                     needUpload = true;
                 }
-                if (needUpload && cloudNode && !localNewerThanCloud(cloudNode, localPath))
+                if (needUpload && inCloud && !localNewerThanCloud(it->second.modifiedSec(), localPath))
                     needUpload = false;
                 if (!needUpload) {
                     if (useIndex && index) {
@@ -193,10 +322,10 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
                             QFileInfo fi(localPath);
                             qint64 msec = fi.lastModified().toSecsSinceEpoch();
                             qint64 sz = fi.size();
-                            if (entry->status == QLatin1String(FileStatus::SYNCED)
+                            if (entry->status == FileStatus::SYNCED
                                 && entry->mtime_sec == msec && entry->size == sz)
                                 continue;
-                            index->set(syncRoot, rel, msec, sz, QString::fromUtf8(FileStatus::SYNCED), 0);
+                            index->set(syncRoot, rel, msec, sz, FileStatus::SYNCED, 0);
                             flushIndex();
                         }
                     }
@@ -211,76 +340,20 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
                             }
                         }
                     }
-                    std::string originalCloudPath = childCloudPath;
-                    std::string tempCloudPath = originalCloudPath + ".tmp-upload";
-                    if (callbacks.onProgressMessage)
-                        callbacks.onProgressMessage(QStringLiteral("local→cloud ") + QString::fromStdString(tempCloudPath));
-                    qint64 fileSize = QFileInfo(localPath).size();
-                    ydisquette::logToFile(QStringLiteral("[Sync] upload start ") + QString::fromStdString(tempCloudPath)
-                        + QStringLiteral(" size=") + QString::number(fileSize));
-                    QElapsedTimer fileTimer;
-                    fileTimer.start();
-                    DiskResourceResult ur = diskClient.uploadFile(tempCloudPath, localPath, [&callbacks](qint64 bytesPerSec) {
-                        if (callbacks.onThroughput) callbacks.onThroughput(bytesPerSec);
-                    });
-                    if (!ur.success) {
-                        if (useIndex && index) {
-                            QString rel = toRelativePath(localPath);
-                            if (!rel.isEmpty()) {
-                                auto entry = index->get(syncRoot, rel);
-                                int newRetries = (entry ? entry->retries : 0) + 1;
-                                QString newStatus = (newRetries >= maxRetries)
-                                    ? QString::fromUtf8(FileStatus::FAILED)
-                                    : QString::fromUtf8(FileStatus::UPLOADING);
-                                index->setStatus(syncRoot, rel, newStatus, 1);
-                                ydisquette::logToFile(QStringLiteral("[Sync] upload failed ") + rel
-                                    + QStringLiteral(" retries=") + QString::number(newRetries));
-                                flushIndex();
-                            }
-                        }
-                        if (callbacks.onError)
-                            callbacks.onError(QStringLiteral("Upload failed (local→cloud): ") + ur.errorMessage);
-                        continue;
-                    }
-                    DiskResourceResult delExisting = diskClient.deleteResource(originalCloudPath);
-                    Q_UNUSED(delExisting);
-                    DiskResourceResult mr = diskClient.moveResource(tempCloudPath, originalCloudPath);
-                    if (!mr.success) {
-                        if (callbacks.onError)
-                            callbacks.onError(QStringLiteral("Move failed (local→cloud): ") + mr.errorMessage);
-                        continue;
-                    }
-                    QString relOk = toRelativePath(localPath);
-                    if (!relOk.isEmpty())
-                        ydisquette::logToFile(QStringLiteral("[Sync] upload OK ") + relOk);
-                    if (callbacks.onProgressMessage)
-                        callbacks.onProgressMessage(QStringLiteral("local→cloud OK ") + QString::fromStdString(originalCloudPath));
-                    if (callbacks.onThroughput) {
-                        qint64 fileMs = qMax(qint64(1), fileTimer.elapsed());
-                        callbacks.onThroughput(fileSize * 1000 / fileMs);
-                    }
-                    if (useIndex && index) {
-                        QString rel = toRelativePath(localPath);
-                        if (!rel.isEmpty()) {
-                            QFileInfo fi(localPath);
-                            index->set(syncRoot, rel, fi.lastModified().toSecsSinceEpoch(), fi.size(),
-                                       QString::fromUtf8(FileStatus::SYNCED), 0);
-                            flushIndex();
-                        }
-                    }
+                    enqueueUpload(localPath, childCloudPath);
                 }
             }
         }
-        for (const auto& node : cloudChildren) {
-            if (!node) continue;
-            if (!localNames.contains(QString::fromStdString(node->name))) {
+        for (disk_tree::NodeRef node : cloudChildren) {
+            const std::string_view name = node.name();
+            if (!localNames.contains(QString::fromUtf8(name.data(), static_cast<int>(name.size())))) {
                 if (useIndex && index) {
-                    QString rel = cloudPathToRelativeQString(node->path).trimmed();
+                    QString rel = cloudPathToRelativeQString(node.path()).trimmed();
                     if (!rel.isEmpty()) {
-                        if (node->isDir())
-                            index->setStatusPrefix(syncRoot, rel, QString::fromUtf8(FileStatus::TO_DELETE));
+                        if (node.isDir())
+                            index->setStatusPrefix(syncRoot, rel, FileStatus::TO_DELETE);
                         else
-                            index->setStatus(syncRoot, rel, QString::fromUtf8(FileStatus::TO_DELETE), 0);
+                            index->setStatus(syncRoot, rel, FileStatus::TO_DELETE, 0);
                         flushIndex();
                     }
                 }
@@ -291,6 +364,7 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
 
     for (const std::string& cloudPath : pathSet) {
         if (stopRequested && stopRequested()) {
+            pool.waitForIdle(stopRequested);
             if (useIndex && index) index->rollback();
             return Result::Stopped;
         }
@@ -300,7 +374,7 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
             if (useIndex && index) {
                 QString prefix = cloudPathToRelativeQString(cloudPath).trimmed();
                 if (!prefix.isEmpty()) {
-                    index->setStatusPrefix(syncRoot, prefix, QString::fromUtf8(FileStatus::TO_DELETE));
+                    index->setStatusPrefix(syncRoot, prefix, FileStatus::TO_DELETE);
                     flushIndex();
                 }
             }
@@ -308,10 +382,23 @@ SyncLocalToCloudUseCase::Result SyncLocalToCloudUseCase::run(
         }
         if (callbacks.onProgressMessage)
             callbacks.onProgressMessage(QStringLiteral("local→cloud ") + QString::fromStdString(cloudPath));
-        if (!syncLocalToCloudFolder(localDir, cloudPath)) {
+        if (!createCloudFolder(cloudPath)) {
+            pool.waitForIdle(stopRequested);
             if (useIndex && index) index->rollback();
-            return (stopRequested && stopRequested()) ? Result::Stopped : Result::Error;
+            return Result::Error;
         }
+        localDirFor[cloudPath] = localDir;
+        walker.add(cloudPath);
+    }
+    if (!walker.run(syncLocalToCloudFolder, stopRequested)) {
+        pool.waitForIdle(stopRequested);
+        if (useIndex && index) index->rollback();
+        return (stopRequested && stopRequested()) ? Result::Stopped : Result::Error;
+    }
+
+    if (!pool.waitForIdle(stopRequested)) {
+        if (useIndex && index) index->rollback();
+        return Result::Stopped;
     }
 
     std::set<std::string> newTopLevelSet;
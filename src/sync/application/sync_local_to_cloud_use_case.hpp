@@ -30,6 +30,8 @@ public:
                      const QString& localRoot,
                      const std::vector<std::string>& selectedPaths,
                      int maxRetries,
+                     int maxParallelUploads,
+                     bool directUploads,
                      std::function<bool()> stopRequested,
                      const SyncLocalToCloudCallbacks& callbacks);
 };
@@ -3,11 +3,35 @@
 namespace ydisquette {
 namespace sync {
 
+static const char kPartialDownloadSuffix[] = ".yd.part";
+static const char kTempUploadSuffix[] = ".tmp-upload";
+
 QString localPathToRelative(const QString& localPath, const QString& syncRoot) {
     QString base = syncRoot + QLatin1Char('/');
     if (!localPath.startsWith(base)) return QString();
     return localPath.mid(base.size());
 }
 
+QString partialDownloadPath(const QString& localPath) {
+    return localPath + QLatin1String(kPartialDownloadSuffix);
+}
+
+bool isPartialDownloadPath(const QString& path) {
+    return path.endsWith(QLatin1String(kPartialDownloadSuffix));
+}
+
+QString partialDownloadTarget(const QString& partPath) {
+    if (!isPartialDownloadPath(partPath)) return partPath;
+    return partPath.left(partPath.size() - static_cast<int>(sizeof(kPartialDownloadSuffix) - 1));
+}
+
+std::string tempUploadPath(const std::string& cloudPath) {
+    return cloudPath + kTempUploadSuffix;
+}
+
+bool isTempUploadPath(const QString& cloudPath) {
+    return cloudPath.endsWith(QLatin1String(kTempUploadSuffix));
+}
+
 }  // namespace sync
 }  // namespace ydisquette
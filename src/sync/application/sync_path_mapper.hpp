@@ -1,11 +1,17 @@
 #pragma once
 
 #include <QString>
+#include <string>
 
 namespace ydisquette {
 namespace sync {
 
 QString localPathToRelative(const QString& localPath, const QString& syncRoot);
+QString partialDownloadPath(const QString& localPath);
+bool isPartialDownloadPath(const QString& path);
+QString partialDownloadTarget(const QString& partPath);
+std::string tempUploadPath(const std::string& cloudPath);
+bool isTempUploadPath(const QString& cloudPath);
 
 }  // namespace sync
 }  // namespace ydisquette
@@ -0,0 +1,72 @@
+#include "sync/application/temp_upload_janitor.hpp"
+#include "sync/application/flat_file_scan.hpp"
+#include "sync/application/sync_path_mapper.hpp"
+#include "sync/infrastructure/transfer_pool.hpp"
+#include "shared/app_log.hpp"
+#include "shared/cloud_path_util.hpp"
+#include <QStringList>
+
+namespace ydisquette {
+namespace sync {
+
+const int TempUploadJanitor::kPageSize = 1000;
+static const int kParallelDeletes = 4;
+
+TempUploadSweep TempUploadJanitor::run(DiskResourceClient& diskClient,
+                                       const std::vector<std::string>& selectedPaths,
+                                       std::function<bool()> stopRequested,
+                                       int pageSize) {
+    TempUploadSweep sweep;
+    if (selectedPaths.empty()) return sweep;
+    QStringList roots;
+    for (const std::string& p : selectedPaths)
+        roots.append(cloudPathToRelativeQString(normalizeCloudPath(p)));
+    TransferPool pool(kParallelDeletes);
+    bool listed = false;
+    bool listFailed = false;
+    std::function<void(int)> listFrom = [&](int offset) {
+        pool.enqueue([&, offset](TransferPool::Done done) {
+            if (stopRequested && stopRequested()) {
+                done();
+                return;
+            }
+            diskClient.listFilePathsPageAsync(pageSize, offset,
+                [&, offset, done](DiskResourceResult r, std::vector<std::string> paths, int itemCount) {
+                    if (!r.success) {
+                        listFailed = true;
+                        done();
+                        return;
+                    }
+                    sweep.scanned += itemCount;
+                    if (itemCount < pageSize)
+                        listed = true;
+                    else
+                        listFrom(offset + pageSize);
+                    for (const std::string& p : paths) {
+                        const QString rel = cloudPathToRelativeQString(p);
+                        if (!isTempUploadPath(rel) || !FlatFileScan::isUnderSelectedRoots(rel, roots)) continue;
+                        pool.enqueue([&sweep, &diskClient, p](TransferPool::Done deleted) {
+                            diskClient.deleteResourceAsync(p, [&sweep, deleted](DiskResourceResult dr) {
+                                if (dr.success)
+                                    ++sweep.removed;
+                                else
+                                    ++sweep.failed;
+                                deleted();
+                            });
+                        });
+                    }
+                    done();
+                });
+        });
+    };
+    listFrom(0);
+    if (!pool.waitForIdle(stopRequested)) return sweep;
+    sweep.complete = listed && !listFailed && sweep.failed == 0;
+    ydisquette::logToFile(QStringLiteral("[Sync] temp upload sweep scanned=") + QString::number(sweep.scanned)
+        + QStringLiteral(" removed=") + QString::number(sweep.removed)
+        + QStringLiteral(" failed=") + QString::number(sweep.failed));
+    return sweep;
+}
+
+}  // namespace sync
+}  // namespace ydisquette
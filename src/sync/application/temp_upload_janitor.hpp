@@ -0,0 +1,27 @@
+#pragma once
+
+#include "sync/infrastructure/disk_resource_client.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ydisquette {
+namespace sync {
+
+struct TempUploadSweep {
+    int scanned = 0;
+    int removed = 0;
+    int failed = 0;
+    bool complete = false;
+};
+
+class TempUploadJanitor {
+public:
+    static TempUploadSweep run(DiskResourceClient& diskClient, const std::vector<std::string>& selectedPaths,
+                               std::function<bool()> stopRequested, int pageSize = kPageSize);
+
+    static const int kPageSize;
+};
+
+}  // namespace sync
+}  // namespace ydisquette
@@ -1,17 +1,18 @@
 #pragma once
 
+#include "shared/iso_datetime.hpp"
 #include <QDateTime>
 #include <QtGlobal>
 #include <string>
+#include <string_view>
 
 namespace ydisquette {
 namespace sync {
 
 QDateTime parseCloudModified(const std::string& modified);
 
-inline qint64 parseCloudModifiedToSec(const std::string& modified) {
-    QDateTime dt = parseCloudModified(modified);
-    return dt.isValid() ? dt.toSecsSinceEpoch() : 0;
+inline qint64 parseCloudModifiedToSec(std::string_view modified) {
+    return parseIsoDateTimeToSec(modified);
 }
 
 }  // namespace sync
@@ -1,24 +1,20 @@
 #include "sync/domain/cloud_local_compare.hpp"
+#include <QDateTime>
+#include <QFileInfo>
 
 namespace ydisquette {
 namespace sync {
 
-bool cloudNewerThanLocal(const disk_tree::Node* node, const QString& localPath) {
-    if (!node || node->modified.empty()) return false;
-    QDateTime cloudDt = parseCloudModified(node->modified);
-    if (!cloudDt.isValid()) return false;
-    qint64 cloudSec = cloudDt.toSecsSinceEpoch();
+bool cloudNewerThanLocal(qint64 cloudModifiedSec, const QString& localPath) {
+    if (cloudModifiedSec <= 0) return false;
     qint64 localSec = QFileInfo(localPath).lastModified().toSecsSinceEpoch();
-    return cloudSec > localSec;
+    return cloudModifiedSec > localSec;
 }
 
-bool localNewerThanCloud(const disk_tree::Node* node, const QString& localPath) {
-    if (!node || node->modified.empty()) return true;
-    QDateTime cloudDt = parseCloudModified(node->modified);
-    if (!cloudDt.isValid()) return true;
-    qint64 cloudSec = cloudDt.toSecsSinceEpoch();
+bool localNewerThanCloud(qint64 cloudModifiedSec, const QString& localPath) {
+    if (cloudModifiedSec <= 0) return true;
     qint64 localSec = QFileInfo(localPath).lastModified().toSecsSinceEpoch();
-    return localSec > cloudSec;
+    return localSec > cloudModifiedSec;
 }
 
 }  // namespace sync
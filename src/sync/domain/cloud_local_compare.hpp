@@ -1,15 +1,13 @@
 #pragma once
 
-#include "sync/domain/cloud_datetime.hpp"
-#include <disk_tree/domain/node.hpp>
-#include <QFileInfo>
 #include <QString>
+#include <QtGlobal>
 
 namespace ydisquette {
 namespace sync {
 
-bool cloudNewerThanLocal(const disk_tree::Node* node, const QString& localPath);
-bool localNewerThanCloud(const disk_tree::Node* node, const QString& localPath);
+bool cloudNewerThanLocal(qint64 cloudModifiedSec, const QString& localPath);
+bool localNewerThanCloud(qint64 cloudModifiedSec, const QString& localPath);
 
 }  // namespace sync
 }  // namespace ydisquette
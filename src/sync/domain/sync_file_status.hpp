@@ -1,29 +1,80 @@
 #pragma once
 
-#include <QString>
+#include <optional>
+#include <string_view>
 
 namespace ydisquette {
 namespace sync {
 
-namespace FileStatus {
-constexpr const char* NEW = "NEW";
-constexpr const char* SYNCED = "SYNCED";
-constexpr const char* TO_DOWNLOAD = "TO_DOWNLOAD";
-constexpr const char* DOWNLOADING = "DOWNLOADING";
-constexpr const char* UPLOADING = "UPLOADING";
-constexpr const char* TO_DELETE = "TO_DELETE";
-constexpr const char* CLOUD_DELETED = "CLOUD_DELETED";
-constexpr const char* FAILED = "FAILED";
-inline bool isTerminal(const QString& s) {
-    return s == QLatin1String(SYNCED) || s == QLatin1String(FAILED);
-}
-inline bool needsUpload(const QString& s) {
-    return s == QLatin1String(NEW) || s == QLatin1String(UPLOADING);
-}
-inline bool needsDownload(const QString& s) {
-    return s == QLatin1String(TO_DOWNLOAD) || s == QLatin1String(DOWNLOADING);
-}
-}  // namespace FileStatus
+enum class FileStatus : int {
+    SYNCED = 0,
+    NEW = 1,
+    TO_DOWNLOAD = 2,
+    DOWNLOADING = 3,
+    UPLOADING = 4,
+    TO_DELETE = 5,
+    CLOUD_DELETED = 6,
+    FAILED = 7,
+};
+
+constexpr int kFileStatusCount = 8;
+
+constexpr const char* kFileStatusNames[kFileStatusCount] = {
+    "SYNCED", "NEW", "TO_DOWNLOAD", "DOWNLOADING", "UPLOADING", "TO_DELETE", "CLOUD_DELETED", "FAILED",
+};
+
+constexpr FileStatus fileStatusFromCode(int code) {
+    return code >= 0 && code < kFileStatusCount ? static_cast<FileStatus>(code) : FileStatus::SYNCED;
+}
+
+constexpr const char* fileStatusName(FileStatus s) {
+    return kFileStatusNames[static_cast<int>(fileStatusFromCode(static_cast<int>(s)))];
+}
+
+constexpr std::optional<FileStatus> fileStatusFromName(std::string_view name) {
+    for (int i = 0; i < kFileStatusCount; ++i)
+        if (name == kFileStatusNames[i]) return static_cast<FileStatus>(i);
+    return std::nullopt;
+}
+
+constexpr bool isTerminal(FileStatus s) {
+    return s == FileStatus::SYNCED || s == FileStatus::FAILED;
+}
+
+constexpr bool needsUpload(FileStatus s) {
+    return s == FileStatus::NEW || s == FileStatus::UPLOADING;
+}
+
+constexpr bool needsDownload(FileStatus s) {
+    return s == FileStatus::TO_DOWNLOAD || s == FileStatus::DOWNLOADING;
+}
+
+// Transitions the sync and poll loops make. Nothing moves a TO_DELETE file back into a transfer,
+// a file trashed in the cloud is not re-uploaded, and a pending upload is never demoted to
+// TO_DOWNLOAD. Any state may become SYNCED, NEW, FAILED, TO_DELETE or CLOUD_DELETED.
+constexpr bool canTransition(FileStatus from, FileStatus to) {
+    switch (to) {
+    case FileStatus::SYNCED:
+    case FileStatus::NEW:
+    case FileStatus::FAILED:
+    case FileStatus::TO_DELETE:
+    case FileStatus::CLOUD_DELETED:
+        return true;
+    case FileStatus::UPLOADING:
+        return from != FileStatus::TO_DELETE && from != FileStatus::CLOUD_DELETED;
+    case FileStatus::DOWNLOADING:
+        return from != FileStatus::TO_DELETE;
+    case FileStatus::TO_DOWNLOAD:
+        return !needsUpload(from) && from != FileStatus::TO_DELETE;
+    }
+    return false;
+}
+
+constexpr bool isRestrictedTarget(FileStatus to) {
+    for (int i = 0; i < kFileStatusCount; ++i)
+        if (!canTransition(static_cast<FileStatus>(i), to)) return true;
+    return false;
+}
 
 }  // namespace sync
 }  // namespace ydisquette
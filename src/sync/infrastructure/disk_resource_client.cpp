@@ -1,202 +1,383 @@
 #include "sync/infrastructure/disk_resource_client.hpp"
 #include "auth/infrastructure/yandex_disk_api_client.hpp"
 #include "auth/infrastructure/yandex_disk_path.hpp"
+#include "sync/application/sync_path_mapper.hpp"
+#include "sync/domain/cloud_datetime.hpp"
+#include "sync/infrastructure/hashing_file_device.hpp"
 #include "shared/app_log.hpp"
 #include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QUrl>
 #include <QUrlQuery>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <system_error>
+#include <vector>
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#endif
 
 namespace ydisquette {
 namespace sync {
 
+const qint64 DiskResourceClient::kSegmentedDownloadThreshold = 64 * 1024 * 1024;
+const int DiskResourceClient::kDownloadSegments = 4;
+
 DiskResourceClient::DiskResourceClient(auth::YandexDiskApiClient const& api) : api_(api) {}
 
-DiskResourceResult DiskResourceClient::createFolder(const std::string& path) {
-    const std::string norm = auth::normalizePathForApi(path);
+static qint64 usableResumeOffset(const QString& partPath, qint64 resumeFrom) {
+    if (resumeFrom <= 0) return 0;
+    QFileInfo fi(partPath);
+    return (fi.exists() && fi.size() >= resumeFrom) ? resumeFrom : 0;
+}
+
+static qint64 partialBytesAfterFailure(const QString& partPath, int httpStatus) {
+    if (httpStatus == 416) {
+        QFile::remove(partPath);
+        return 0;
+    }
+    QFileInfo fi(partPath);
+    return fi.exists() ? fi.size() : 0;
+}
+
+static bool preallocateFile(const QString& path, qint64 size, QString* error) {
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        *error = f.errorString();
+        return false;
+    }
+#ifdef Q_OS_LINUX
+    const int rc = posix_fallocate(f.handle(), 0, static_cast<off_t>(size));
+    if (rc == 0) return true;
+    if (rc != EOPNOTSUPP && rc != EINVAL) {
+        *error = QString::fromLocal8Bit(std::strerror(rc));
+        return false;
+    }
+#endif
+    if (!f.resize(size)) {
+        *error = f.errorString();
+        return false;
+    }
+    return true;
+}
+
+static DiskResourceResult commitPartialDownload(const QString& partPath, const QString& localPath,
+                                                const QString& pathQt) {
+    DiskResourceResult out;
+    std::error_code ec;
+    std::filesystem::rename(QFile(partPath).filesystemFileName(), QFile(localPath).filesystemFileName(), ec);
+    if (!ec) {
+        out.success = true;
+        return out;
+    }
+    out.errorMessage = QStringLiteral("Requested path: %1. Cannot rename %2: %3")
+        .arg(pathQt, partPath, QString::fromLocal8Bit(ec.message().c_str()));
+    out.partialBytes = partialBytesAfterFailure(partPath, 0);
+    ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
+    return out;
+}
+
+// A resource that is already gone is what a delete wants, so 404 counts as success.
+static DiskResourceResult deleteResult(const std::string& path, const auth::ApiResponse& res) {
+    DiskResourceResult out;
+    out.success = res.ok() || res.statusCode == 202 || res.statusCode == 404;
+    out.httpStatus = res.statusCode;
+    if (!out.success) {
+        out.errorMessage = QString::fromUtf8(res.body);
+        ydisquette::logToFile(QStringLiteral("[Sync] delete ") + QString::fromStdString(path)
+            + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
+    }
+    return out;
+}
+
+static std::string deleteRequest(const std::string& path) {
     QUrlQuery q;
-    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(norm));
-    auth::ApiResponse res = api_.putNoBody("/resources?" + q.query(QUrl::FullyEncoded).toStdString());
+    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(auth::normalizePathForApi(path)));
+    return "/resources?" + q.query(QUrl::FullyEncoded).toStdString();
+}
+
+static DiskResourceResult createFolderResult(const std::string& path, const auth::ApiResponse& res) {
     DiskResourceResult out;
     out.success = res.ok() || res.statusCode == 409;
     out.httpStatus = res.statusCode;
     if (!out.success) {
-        out.errorMessage = QString::fromStdString(res.body);
+        out.errorMessage = QString::fromUtf8(res.body);
         ydisquette::logToFile(QStringLiteral("[Sync] createFolder ") + QString::fromStdString(path) + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
     }
     return out;
 }
 
-DiskResourceResult DiskResourceClient::downloadFile(const std::string& remotePath, const QString& localPath) {
-    const QString pathQt = QString::fromStdString(remotePath);
-    const std::string normPath = auth::normalizePathForApi(remotePath);
-    const QByteArray pathEncoded = QUrl::toPercentEncoding(QString::fromStdString(normPath), QByteArray());
-    const QString fullUrl = QStringLiteral("https://cloud-api.yandex.net/v1/disk/resources/download?path=")
-                            + QString::fromUtf8(pathEncoded);
-    auth::ApiResponse step1 = api_.getByFullUrl(fullUrl);
-    DiskResourceResult out;
-    if (!step1.ok()) {
-        out.httpStatus = step1.statusCode;
-        out.errorMessage = QStringLiteral("Requested path: %1. Yandex: %2")
-                               .arg(pathQt, QString::fromStdString(step1.body));
-        ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-        return out;
-    }
-    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(step1.body));
-    if (!doc.isObject()) {
-        out.errorMessage = QStringLiteral("Requested path: %1. Invalid download response").arg(pathQt);
-        ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-        return out;
-    }
-    QString href = doc.object().value(QStringLiteral("href")).toString();
-    if (href.isEmpty()) {
-        out.errorMessage = QStringLiteral("Requested path: %1. No href in download response").arg(pathQt);
-        ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-        return out;
-    }
-    auth::ApiResponse step2 = api_.getAbsoluteUrl(href);
-    if (!step2.ok()) {
-        out.httpStatus = step2.statusCode;
-        out.errorMessage = QStringLiteral("Requested path: %1. Download URL: %2. Yandex: %3")
-                               .arg(pathQt, href, QString::fromStdString(step2.body));
-        ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-        return out;
-    }
-    QFile f(localPath);
-    if (!f.open(QIODevice::WriteOnly)) {
-        out.errorMessage = f.errorString();
-        ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-        return out;
+static std::string createFolderRequest(const std::string& path) {
+    QUrlQuery q;
+    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(auth::normalizePathForApi(path)));
+    return "/resources?" + q.query(QUrl::FullyEncoded).toStdString();
+}
+
+DiskResourceResult DiskResourceClient::createFolder(const std::string& path) {
+    return createFolderResult(path, api_.putNoBody(createFolderRequest(path)));
+}
+
+void DiskResourceClient::createFolderAsync(const std::string& path, std::function<void(DiskResourceResult)> cb) {
+    api_.putNoBodyAsync(createFolderRequest(path), [path, cb](auth::ApiResponse res) {
+        DiskResourceResult out = createFolderResult(path, res);
+        if (cb) cb(out);
+    });
+}
+
+static QString downloadHrefKey(const std::string& remotePath) {
+    return QStringLiteral("download:") + QString::fromStdString(auth::normalizePathForApi(remotePath));
+}
+
+static QString uploadHrefKey(const std::string& remotePath) {
+    return QStringLiteral("upload:") + QString::fromStdString(auth::normalizePathForApi(remotePath));
+}
+
+void DiskResourceClient::resolveHrefAsync(const QString& key, HrefFetch fetch, HrefCallback cb) {
+    if (std::optional<QString> cached = hrefCache_.take(key)) {
+        DiskResourceResult out;
+        out.success = true;
+        cb(out, *cached);
+        return;
     }
-    f.write(step2.body.data(), static_cast<qint64>(step2.body.size()));
-    out.success = true;
-    return out;
+    const bool waiting = hrefCache_.addWaiter(key, [fetch, cb](const QString& href) {
+        if (href.isEmpty()) {
+            fetch(cb);
+            return;
+        }
+        DiskResourceResult out;
+        out.success = true;
+        cb(out, href);
+    });
+    if (!waiting) fetch(cb);
 }
 
-void DiskResourceClient::downloadFileAsync(const std::string& remotePath, const QString& localPath,
-                                           std::function<void(DiskResourceResult)> cb) {
+void DiskResourceClient::prefetchHref(const QString& key, HrefFetch fetch) {
+    if (!hrefCache_.beginPrefetch(key)) return;
+    fetch([this, key](DiskResourceResult r, QString href) {
+        hrefCache_.finishPrefetch(key, r.success ? href : QString());
+    });
+}
+
+void DiskResourceClient::prefetchDownloadHref(const std::string& remotePath) {
+    prefetchHref(downloadHrefKey(remotePath), [this, remotePath](HrefCallback cb) {
+        fetchDownloadHrefAsync(remotePath, std::move(cb));
+    });
+}
+
+void DiskResourceClient::prefetchUploadHref(const std::string& remotePath) {
+    prefetchHref(uploadHrefKey(remotePath), [this, remotePath](HrefCallback cb) {
+        fetchUploadHrefAsync(remotePath, std::move(cb));
+    });
+}
+
+void DiskResourceClient::resolveDownloadHrefAsync(const std::string& remotePath, HrefCallback cb) {
+    resolveHrefAsync(downloadHrefKey(remotePath), [this, remotePath](HrefCallback fetched) {
+        fetchDownloadHrefAsync(remotePath, std::move(fetched));
+    }, std::move(cb));
+}
+
+void DiskResourceClient::fetchDownloadHrefAsync(const std::string& remotePath, HrefCallback cb) {
     const QString pathQt = QString::fromStdString(remotePath);
     const std::string normPath = auth::normalizePathForApi(remotePath);
     const QByteArray pathEncoded = QUrl::toPercentEncoding(QString::fromStdString(normPath), QByteArray());
-    const QString fullUrl = QStringLiteral("https://cloud-api.yandex.net/v1/disk/resources/download?path=")
+    const QString fullUrl = api_.baseUrl() + QStringLiteral("/resources/download?path=")
                             + QString::fromUtf8(pathEncoded);
-    api_.getByFullUrlAsync(fullUrl, [this, pathQt, localPath, cb](auth::ApiResponse step1) {
+    api_.getByFullUrlAsync(fullUrl, [pathQt, cb](auth::ApiResponse step1) {
+        DiskResourceResult out;
         if (!step1.ok()) {
-            DiskResourceResult out;
             out.httpStatus = step1.statusCode;
             out.errorMessage = QStringLiteral("Requested path: %1. Yandex: %2")
-                                   .arg(pathQt, QString::fromStdString(step1.body));
+                                   .arg(pathQt, QString::fromUtf8(step1.body));
             ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-            if (cb) cb(out);
+            cb(out, QString());
             return;
         }
-        QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(step1.body));
+        QJsonDocument doc = QJsonDocument::fromJson(step1.body);
         if (!doc.isObject()) {
-            DiskResourceResult out;
             out.errorMessage = QStringLiteral("Requested path: %1. Invalid download response").arg(pathQt);
             ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-            if (cb) cb(out);
+            cb(out, QString());
             return;
         }
         QString href = doc.object().value(QStringLiteral("href")).toString();
         if (href.isEmpty()) {
-            DiskResourceResult out;
             out.errorMessage = QStringLiteral("Requested path: %1. No href in download response").arg(pathQt);
             ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-            if (cb) cb(out);
+            cb(out, QString());
             return;
         }
-        api_.getAbsoluteUrlAsync(href, [pathQt, href, localPath, cb](auth::ApiResponse step2) {
-        DiskResourceResult out;
-        if (!step2.ok()) {
-            out.httpStatus = step2.statusCode;
-            out.errorMessage = QStringLiteral("Requested path: %1. Download URL: %2. Yandex: %3")
-                                   .arg(pathQt, href, QString::fromStdString(step2.body));
-            ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
-            if (cb) cb(out);
+        out.success = true;
+        cb(out, href);
+    });
+}
+
+void DiskResourceClient::downloadFileAsync(const std::string& remotePath, const QString& localPath,
+                                           std::function<void(DiskResourceResult)> cb, qint64 resumeFrom) {
+    const QString pathQt = QString::fromStdString(remotePath);
+    const QString partPath = partialDownloadPath(localPath);
+    resumeFrom = usableResumeOffset(partPath, resumeFrom);
+    resolveDownloadHrefAsync(remotePath, [this, pathQt, localPath, partPath, resumeFrom, cb](DiskResourceResult step1, QString href) {
+        if (!step1.success) {
+            step1.partialBytes = resumeFrom;
+            if (cb) cb(step1);
             return;
         }
-        QFile f(localPath);
-        if (!f.open(QIODevice::WriteOnly)) {
-            out.errorMessage = f.errorString();
-            ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
+        api_.downloadToFileAsync(href, localPath, [pathQt, href, partPath, cb](auth::ApiResponse step2) {
+            if (!step2.ok()) {
+                DiskResourceResult out;
+                out.httpStatus = step2.statusCode;
+                out.partialBytes = partialBytesAfterFailure(partPath, step2.statusCode);
+                out.errorMessage = QStringLiteral("Requested path: %1. Download URL: %2. Yandex: %3")
+                                       .arg(pathQt, href, QString::fromUtf8(step2.body));
+                ydisquette::logToFile(QStringLiteral("[Sync] download ") + pathQt + QStringLiteral(" -> FAIL: ") + out.errorMessage);
+                if (cb) cb(out);
+                return;
+            }
+            DiskResourceResult out;
+            out.success = true;
             if (cb) cb(out);
+        }, resumeFrom, partPath);
+    });
+}
+
+void DiskResourceClient::downloadFileSegmentedAsync(const std::string& remotePath, const QString& localPath,
+                                                    qint64 size, std::function<void(DiskResourceResult)> cb) {
+    resolveDownloadHrefAsync(remotePath, [this, localPath, size, cb](DiskResourceResult step1, QString href) {
+        if (!step1.success) {
+            if (cb) cb(step1);
             return;
         }
-        f.write(step2.body.data(), static_cast<qint64>(step2.body.size()));
-        out.success = true;
-        if (cb) cb(out);
-    });
+        downloadHrefSegmentedAsync(href, localPath, size, kDownloadSegments, cb);
     });
 }
 
-DiskResourceResult DiskResourceClient::uploadFile(const std::string& remotePath, const QString& localPath) {
-    return uploadFile(remotePath, localPath, std::function<void(qint64)>());
+void DiskResourceClient::downloadHrefSegmentedAsync(const QString& href, const QString& localPath, qint64 size,
+                                                    int segments, std::function<void(DiskResourceResult)> cb) {
+    const QString partPath = partialDownloadPath(localPath);
+    QString allocError;
+    if (size <= 0 || !preallocateFile(partPath, size, &allocError)) {
+        DiskResourceResult out;
+        out.errorMessage = QStringLiteral("Cannot preallocate %1: %2").arg(partPath, allocError);
+        ydisquette::logToFile(QStringLiteral("[Sync] download ") + localPath + QStringLiteral(" -> FAIL: ") + out.errorMessage);
+        if (cb) cb(out);
+        return;
+    }
+    struct State {
+        std::vector<qint64> lengths;
+        std::vector<qint64> written;
+        int pending = 0;
+        DiskResourceResult failure;
+    };
+    auto st = std::make_shared<State>();
+    const qint64 segmentSize = (size + qMax(1, segments) - 1) / qMax(1, segments);
+    for (qint64 off = 0; off < size; off += segmentSize)
+        st->lengths.push_back(qMin(segmentSize, size - off));
+    st->written.assign(st->lengths.size(), 0);
+    st->pending = static_cast<int>(st->lengths.size());
+    for (std::size_t i = 0; i < st->lengths.size(); ++i) {
+        const qint64 offset = static_cast<qint64>(i) * segmentSize;
+        api_.downloadRangeToFileAsync(href, partPath, offset, st->lengths[i],
+            [st, i, href, localPath, partPath, size, cb](auth::ApiResponse res, qint64 bytesWritten) {
+                st->written[i] = bytesWritten;
+                if (!res.ok() && st->failure.errorMessage.isEmpty()) {
+                    st->failure.httpStatus = res.statusCode;
+                    st->failure.errorMessage = QStringLiteral("Download URL: %1. Segment %2: %3")
+                                                   .arg(href).arg(static_cast<int>(i)).arg(QString::fromUtf8(res.body));
+                }
+                if (--st->pending > 0) return;
+                if (st->failure.errorMessage.isEmpty()
+                    && (st->written != st->lengths
+                        || std::accumulate(st->written.begin(), st->written.end(), qint64(0)) != size))
+                    st->failure.errorMessage = QStringLiteral("Size mismatch after segmented download of %1").arg(localPath);
+                if (!st->failure.errorMessage.isEmpty()) {
+                    DiskResourceResult out = st->failure;
+                    for (std::size_t k = 0; k < st->lengths.size(); ++k) {
+                        out.partialBytes += st->written[k];
+                        if (st->written[k] != st->lengths[k]) break;
+                    }
+                    if (out.partialBytes == 0) QFile::remove(partPath);
+                    ydisquette::logToFile(QStringLiteral("[Sync] download ") + localPath + QStringLiteral(" -> FAIL: ") + out.errorMessage);
+                    if (cb) cb(out);
+                    return;
+                }
+                DiskResourceResult out = commitPartialDownload(partPath, localPath, localPath);
+                if (cb) cb(out);
+            });
+    }
 }
 
-DiskResourceResult DiskResourceClient::uploadFile(const std::string& remotePath, const QString& localPath,
-                                                 std::function<void(qint64 bytesPerSecond)> onProgress) {
-    QFile f(localPath);
-    if (!f.open(QIODevice::ReadOnly)) {
+void DiskResourceClient::uploadFileAsync(const std::string& remotePath, const QString& localPath,
+                                         std::function<void(qint64 bytesPerSecond)> onProgress,
+                                         std::function<void(DiskResourceResult)> cb) {
+    auto f = std::make_shared<HashingFileDevice>(localPath);
+    if (!f->open(QIODevice::ReadOnly)) {
         DiskResourceResult out;
-        out.errorMessage = f.errorString();
-        ydisquette::logToFile(QStringLiteral("[Sync] upload ") + QString::fromStdString(remotePath) + QStringLiteral(" FAIL open: ") + f.errorString());
-        return out;
+        out.errorMessage = f->fileErrorString();
+        ydisquette::logToFile(QStringLiteral("[Sync] upload ") + QString::fromStdString(remotePath) + QStringLiteral(" FAIL open: ") + out.errorMessage);
+        if (cb) cb(out);
+        return;
     }
-    QByteArray data = f.readAll();
-    f.close();
 
+    resolveHrefAsync(uploadHrefKey(remotePath), [this, remotePath](HrefCallback fetched) {
+        fetchUploadHrefAsync(remotePath, std::move(fetched));
+    }, [this, remotePath, f, onProgress, cb](DiskResourceResult step1, QString href) {
+        if (!step1.success) {
+            if (cb) cb(step1);
+            return;
+        }
+        api_.putFromDeviceAsync(href, f, onProgress, [remotePath, f, cb](auth::ApiResponse step2) {
+            DiskResourceResult out;
+            out.success = step2.ok();
+            out.httpStatus = step2.statusCode;
+            out.md5 = f->md5();
+            if (!step2.ok()) {
+                out.errorMessage = QString::fromUtf8(step2.body);
+                ydisquette::logToFile(QStringLiteral("[Sync] upload ") + QString::fromStdString(remotePath) + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
+            }
+            if (cb) cb(out);
+        });
+    });
+}
+
+void DiskResourceClient::fetchUploadHrefAsync(const std::string& remotePath, HrefCallback cb) {
     const std::string normPath = auth::normalizePathForApi(remotePath);
     const QByteArray pathEncoded = QUrl::toPercentEncoding(QString::fromStdString(normPath), QByteArray());
-    const QString fullUrl = QStringLiteral("https://cloud-api.yandex.net/v1/disk/resources/upload?path=")
+    const QString fullUrl = api_.baseUrl() + QStringLiteral("/resources/upload?path=")
         + QString::fromUtf8(pathEncoded) + QStringLiteral("&overwrite=true");
-    auth::ApiResponse step1 = api_.getByFullUrl(fullUrl);
-    DiskResourceResult out;
-    if (!step1.ok()) {
-        out.httpStatus = step1.statusCode;
-        out.errorMessage = QString::fromStdString(step1.body);
-        ydisquette::logToFile(QStringLiteral("[Sync] upload ") + QString::fromStdString(remotePath) + QStringLiteral(" FAIL: ") + QString::number(step1.statusCode) + QChar(' ') + out.errorMessage);
-        return out;
-    }
-    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(step1.body));
-    if (!doc.isObject()) {
-        out.errorMessage = QStringLiteral("Invalid upload response");
-        return out;
-    }
-    QString href = doc.object().value(QStringLiteral("href")).toString();
-    if (href.isEmpty()) {
-        out.errorMessage = QStringLiteral("No href in upload response");
-        return out;
-    }
-    auth::ApiResponse step2 = onProgress ? api_.putToAbsoluteUrl(href, data, onProgress) : api_.putToAbsoluteUrl(href, data);
-    out.success = step2.ok();
-    out.httpStatus = step2.statusCode;
-    if (!step2.ok()) {
-        out.errorMessage = QString::fromStdString(step2.body);
-        ydisquette::logToFile(QStringLiteral("[Sync] upload ") + QString::fromStdString(remotePath) + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
-    }
-    return out;
+    api_.getByFullUrlAsync(fullUrl, [remotePath, cb](auth::ApiResponse step1) {
+        DiskResourceResult out;
+        if (!step1.ok()) {
+            out.httpStatus = step1.statusCode;
+            out.errorMessage = QString::fromUtf8(step1.body);
+            ydisquette::logToFile(QStringLiteral("[Sync] upload ") + QString::fromStdString(remotePath) + QStringLiteral(" FAIL: ") + QString::number(step1.statusCode) + QChar(' ') + out.errorMessage);
+            cb(out, QString());
+            return;
+        }
+        QJsonDocument doc = QJsonDocument::fromJson(step1.body);
+        if (!doc.isObject()) {
+            out.errorMessage = QStringLiteral("Invalid upload response");
+            cb(out, QString());
+            return;
+        }
+        QString href = doc.object().value(QStringLiteral("href")).toString();
+        if (href.isEmpty()) {
+            out.errorMessage = QStringLiteral("No href in upload response");
+            cb(out, QString());
+            return;
+        }
+        out.success = true;
+        cb(out, href);
+    });
 }
 
 DiskResourceResult DiskResourceClient::deleteResource(const std::string& path) {
-    const std::string norm = auth::normalizePathForApi(path);
-    QUrlQuery q;
-    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(norm));
-    auth::ApiResponse res = api_.deleteResource("/resources?" + q.query(QUrl::FullyEncoded).toStdString());
-    DiskResourceResult out;
-    out.httpStatus = res.statusCode;
-    if (res.ok() || res.statusCode == 202) {
-        out.success = true;
-    } else if (res.statusCode == 404) {
-        out.success = true;
-    } else {
-        out.success = false;
-        out.errorMessage = QString::fromStdString(res.body);
-        ydisquette::logToFile(QStringLiteral("[Sync] delete ") + QString::fromStdString(path)
-            + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
-    }
-    return out;
+    return deleteResult(path, api_.deleteResource(deleteRequest(path)));
 }
 
 DiskResourceResult DiskResourceClient::moveResource(const std::string& fromPath, const std::string& toPath) {
@@ -211,7 +392,7 @@ DiskResourceResult DiskResourceClient::moveResource(const std::string& fromPath,
     out.success = res.ok();
     out.httpStatus = res.statusCode;
     if (!out.success) {
-        out.errorMessage = QString::fromStdString(res.body);
+        out.errorMessage = QString::fromUtf8(res.body);
         ydisquette::logToFile(QStringLiteral("[Sync] move ") + QString::fromStdString(fromPath)
             + QStringLiteral(" -> ") + QString::fromStdString(toPath)
             + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
@@ -219,20 +400,128 @@ DiskResourceResult DiskResourceClient::moveResource(const std::string& fromPath,
     return out;
 }
 
+void DiskResourceClient::moveResourceAsync(const std::string& fromPath, const std::string& toPath,
+                                           std::function<void(DiskResourceResult)> cb) {
+    const std::string normFrom = auth::normalizePathForApi(fromPath);
+    const std::string normTo = auth::normalizePathForApi(toPath);
+    QUrlQuery q;
+    q.addQueryItem(QStringLiteral("from"), QString::fromStdString(normFrom));
+    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(normTo));
+    q.addQueryItem(QStringLiteral("overwrite"), QStringLiteral("true"));
+    api_.postNoBodyAsync("/resources/move?" + q.query(QUrl::FullyEncoded).toStdString(),
+        [fromPath, toPath, cb](auth::ApiResponse res) {
+            DiskResourceResult out;
+            out.success = res.ok();
+            out.httpStatus = res.statusCode;
+            if (!out.success) {
+                out.errorMessage = QString::fromUtf8(res.body);
+                ydisquette::logToFile(QStringLiteral("[Sync] move ") + QString::fromStdString(fromPath)
+                    + QStringLiteral(" -> ") + QString::fromStdString(toPath)
+                    + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
+            }
+            if (cb) cb(out);
+        });
+}
+
 void DiskResourceClient::deleteResourceAsync(const std::string& path,
                                              std::function<void(DiskResourceResult)> cb) {
-    const std::string norm = auth::normalizePathForApi(path);
+    api_.deleteResourceAsync(deleteRequest(path), [path, cb](auth::ApiResponse res) {
+        DiskResourceResult out = deleteResult(path, res);
+        if (cb) cb(out);
+    });
+}
+
+void DiskResourceClient::statFileAsync(const std::string& path,
+                                       std::function<void(DiskResourceResult, RemoteFileInfo)> cb) {
     QUrlQuery q;
-    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(norm));
-    std::string apiPath = "/resources?" + q.query(QUrl::FullyEncoded).toStdString();
-    api_.deleteResourceAsync(apiPath, [cb](auth::ApiResponse res) {
+    q.addQueryItem(QStringLiteral("path"), QString::fromStdString(auth::normalizePathForApi(path)));
+    auth::YandexDiskApiClient::project(q, auth::YandexDiskApiClient::kStatFields);
+    api_.getAsync("/resources", q, [path, cb](auth::ApiResponse res) {
         DiskResourceResult out;
-        out.success = res.ok() || res.statusCode == 202;
+        RemoteFileInfo info;
         out.httpStatus = res.statusCode;
-        if (!out.success) out.errorMessage = QString::fromStdString(res.body);
-        if (cb) cb(out);
+        if (!res.ok()) {
+            out.errorMessage = QString::fromUtf8(res.body);
+            ydisquette::logToFile(QStringLiteral("[Sync] stat ") + QString::fromStdString(path)
+                + QStringLiteral(" FAIL: ") + QString::number(out.httpStatus) + QChar(' ') + out.errorMessage);
+            if (cb) cb(out, info);
+            return;
+        }
+        QJsonDocument doc = QJsonDocument::fromJson(res.body);
+        if (!doc.isObject()) {
+            out.errorMessage = QStringLiteral("Invalid resource response");
+            if (cb) cb(out, info);
+            return;
+        }
+        const QJsonObject o = doc.object();
+        info.size = o.value(QStringLiteral("size")).toInteger(-1);
+        info.md5 = o.value(QStringLiteral("md5")).toString();
+        out.success = true;
+        if (cb) cb(out, info);
     });
 }
 
+static QUrlQuery filesPageQuery(int limit, int offset, const char* fields) {
+    QUrlQuery q;
+    q.addQueryItem(QStringLiteral("limit"), QString::number(limit));
+    q.addQueryItem(QStringLiteral("offset"), QString::number(offset));
+    auth::YandexDiskApiClient::project(q, fields);
+    return q;
+}
+
+static DiskResourceResult filesPageResult(const auth::ApiResponse& res, QJsonArray& items) {
+    DiskResourceResult out;
+    out.httpStatus = res.statusCode;
+    if (!res.ok()) {
+        out.errorMessage = QString::fromUtf8(res.body);
+        ydisquette::logToFile(QStringLiteral("[Sync] list files FAIL: ") + QString::number(out.httpStatus)
+            + QChar(' ') + out.errorMessage);
+        return out;
+    }
+    QJsonDocument doc = QJsonDocument::fromJson(res.body);
+    if (!doc.isObject()) {
+        out.errorMessage = QStringLiteral("Invalid files response");
+        return out;
+    }
+    items = doc.object().value(QStringLiteral("items")).toArray();
+    out.success = true;
+    return out;
+}
+
+DiskResourceResult DiskResourceClient::listFiles(int limit, int offset, const char* fields, QJsonArray& items) {
+    return filesPageResult(api_.get("/resources/files", filesPageQuery(limit, offset, fields)), items);
+}
+
+void DiskResourceClient::listFilePathsPageAsync(int limit, int offset, FilePathsPageCallback cb) {
+    api_.getAsync("/resources/files", filesPageQuery(limit, offset, auth::YandexDiskApiClient::kFilePathFields),
+                  [cb](auth::ApiResponse res) {
+        QJsonArray items;
+        DiskResourceResult out = filesPageResult(res, items);
+        std::vector<std::string> paths;
+        paths.reserve(static_cast<size_t>(items.size()));
+        for (const QJsonValue& v : items)
+            paths.push_back(v.toObject().value(QStringLiteral("path")).toString().toStdString());
+        if (cb) cb(out, std::move(paths), static_cast<int>(items.size()));
+    });
+}
+
+DiskResourceResult DiskResourceClient::listFilesPage(int limit, int offset, std::vector<RemoteFileEntry>& files,
+                                                     int& itemCount) {
+    QJsonArray items;
+    DiskResourceResult out = listFiles(limit, offset, auth::YandexDiskApiClient::kFileEntryFields, items);
+    itemCount = static_cast<int>(items.size());
+    for (const QJsonValue& v : items) {
+        const QJsonObject o = v.toObject();
+        RemoteFileEntry entry;
+        entry.path = o.value(QStringLiteral("path")).toString().toStdString();
+        entry.size = o.value(QStringLiteral("size")).toInteger(0);
+        const QByteArray modified = o.value(QStringLiteral("modified")).toString().toUtf8();
+        entry.modifiedSec = parseCloudModifiedToSec(std::string_view(modified.constData(), static_cast<size_t>(modified.size())));
+        files.push_back(std::move(entry));
+    }
+    return out;
+}
+
 }  // namespace sync
 }  // namespace ydisquette
+
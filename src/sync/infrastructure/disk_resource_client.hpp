@@ -1,8 +1,12 @@
 #pragma once
 
+#include "sync/infrastructure/href_cache.hpp"
 #include <QString>
 #include <functional>
 #include <string>
+#include <vector>
+
+class QJsonArray;
 
 namespace ydisquette {
 namespace auth {
@@ -14,25 +18,66 @@ struct DiskResourceResult {
     bool success{};
     int httpStatus{};
     QString errorMessage;
+    qint64 partialBytes{};
+    QString md5;
+};
+
+struct RemoteFileInfo {
+    qint64 size = -1;
+    QString md5;
+};
+
+struct RemoteFileEntry {
+    std::string path;
+    qint64 size = 0;
+    qint64 modifiedSec = 0;
 };
 
 class DiskResourceClient {
 public:
+    using FilePathsPageCallback = std::function<void(DiskResourceResult, std::vector<std::string> paths, int itemCount)>;
+
     explicit DiskResourceClient(auth::YandexDiskApiClient const& api);
     DiskResourceResult createFolder(const std::string& path);
-    DiskResourceResult downloadFile(const std::string& remotePath, const QString& localPath);
+    void createFolderAsync(const std::string& path, std::function<void(DiskResourceResult)> cb);
     void downloadFileAsync(const std::string& remotePath, const QString& localPath,
-                          std::function<void(DiskResourceResult)> cb);
-    DiskResourceResult uploadFile(const std::string& remotePath, const QString& localPath);
-    DiskResourceResult uploadFile(const std::string& remotePath, const QString& localPath,
-                                 std::function<void(qint64 bytesPerSecond)> onProgress);
+                          std::function<void(DiskResourceResult)> cb, qint64 resumeFrom = 0);
+    void downloadFileSegmentedAsync(const std::string& remotePath, const QString& localPath, qint64 size,
+                                    std::function<void(DiskResourceResult)> cb);
+    void downloadHrefSegmentedAsync(const QString& href, const QString& localPath, qint64 size, int segments,
+                                    std::function<void(DiskResourceResult)> cb);
+    void uploadFileAsync(const std::string& remotePath, const QString& localPath,
+                         std::function<void(qint64 bytesPerSecond)> onProgress,
+                         std::function<void(DiskResourceResult)> cb);
     DiskResourceResult deleteResource(const std::string& path);
     DiskResourceResult moveResource(const std::string& fromPath, const std::string& toPath);
+    void moveResourceAsync(const std::string& fromPath, const std::string& toPath,
+                           std::function<void(DiskResourceResult)> cb);
     void deleteResourceAsync(const std::string& path,
                              std::function<void(DiskResourceResult)> cb);
+    void statFileAsync(const std::string& path,
+                       std::function<void(DiskResourceResult, RemoteFileInfo)> cb);
+    void listFilePathsPageAsync(int limit, int offset, FilePathsPageCallback cb);
+    DiskResourceResult listFilesPage(int limit, int offset, std::vector<RemoteFileEntry>& files, int& itemCount);
+    void prefetchDownloadHref(const std::string& remotePath);
+    void prefetchUploadHref(const std::string& remotePath);
+
+    static const qint64 kSegmentedDownloadThreshold;
+    static const int kDownloadSegments;
 
 private:
+    using HrefCallback = std::function<void(DiskResourceResult, QString href)>;
+    using HrefFetch = std::function<void(HrefCallback)>;
+
+    void resolveDownloadHrefAsync(const std::string& remotePath, HrefCallback cb);
+    void fetchDownloadHrefAsync(const std::string& remotePath, HrefCallback cb);
+    void fetchUploadHrefAsync(const std::string& remotePath, HrefCallback cb);
+    void resolveHrefAsync(const QString& key, HrefFetch fetch, HrefCallback cb);
+    void prefetchHref(const QString& key, HrefFetch fetch);
+    DiskResourceResult listFiles(int limit, int offset, const char* fields, QJsonArray& items);
+
     auth::YandexDiskApiClient const& api_;
+    HrefCache hrefCache_;
 };
 
 }  // namespace sync
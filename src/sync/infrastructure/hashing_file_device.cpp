@@ -0,0 +1,46 @@
+#include "sync/infrastructure/hashing_file_device.hpp"
+#include <QByteArray>
+
+namespace ydisquette {
+namespace sync {
+
+HashingFileDevice::HashingFileDevice(const QString& path) : file_(path), hash_(QCryptographicHash::Md5) {}
+
+bool HashingFileDevice::open(OpenMode mode) {
+    if (mode & WriteOnly) return false;
+    if (!file_.open(QIODevice::ReadOnly)) {
+        setErrorString(file_.errorString());
+        return false;
+    }
+    hash_.reset();
+    hashed_ = 0;
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void HashingFileDevice::close() {
+    QIODevice::close();
+    file_.close();
+}
+
+bool HashingFileDevice::seek(qint64 pos) {
+    return QIODevice::seek(pos) && file_.seek(pos);
+}
+
+QString HashingFileDevice::md5() const {
+    if (hashed_ != file_.size()) return QString();
+    return QString::fromLatin1(hash_.result().toHex());
+}
+
+qint64 HashingFileDevice::readData(char* data, qint64 maxSize) {
+    const qint64 at = file_.pos();
+    const qint64 n = file_.read(data, maxSize);
+    if (n > 0 && at <= hashed_ && at + n > hashed_) {
+        const qint64 skip = hashed_ - at;
+        hash_.addData(QByteArray::fromRawData(data + skip, static_cast<int>(n - skip)));
+        hashed_ = at + n;
+    }
+    return n;
+}
+
+}  // namespace sync
+}  // namespace ydisquette
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+
+namespace ydisquette {
+namespace sync {
+
+// Read-only file device that computes the MD5 of the file while it is being read, so an upload can be
+// verified without reading the file a second time. Bytes re-read after a seek back are hashed only once.
+class HashingFileDevice : public QIODevice {
+public:
+    explicit HashingFileDevice(const QString& path);
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return false; }
+    qint64 size() const override { return file_.size(); }
+    bool seek(qint64 pos) override;
+
+    QString fileErrorString() const { return file_.errorString(); }
+    // Hex MD5 of the whole file, or empty if not every byte has been read yet.
+    QString md5() const;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char*, qint64) override { return -1; }
+
+private:
+    QFile file_;
+    QCryptographicHash hash_;
+    qint64 hashed_ = 0;
+};
+
+}  // namespace sync
+}  // namespace ydisquette
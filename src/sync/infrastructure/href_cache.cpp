@@ -0,0 +1,74 @@
+#include "sync/infrastructure/href_cache.hpp"
+#include <QDateTime>
+
+namespace ydisquette {
+namespace sync {
+
+const qint64 HrefCache::kDefaultTtlMs = 10 * 60 * 1000;
+const int HrefCache::kDefaultCapacity = 256;
+
+HrefCache::HrefCache(qint64 ttlMs, int capacity) : ttlMs_(ttlMs), capacity_(qMax(1, capacity)) {}
+
+std::optional<QString> HrefCache::take(const QString& key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return std::nullopt;
+    Entry e = it.value();
+    entries_.erase(it);
+    if (QDateTime::currentMSecsSinceEpoch() >= e.expiresAtMs) return std::nullopt;
+    return e.href;
+}
+
+void HrefCache::put(const QString& key, const QString& href) {
+    if (href.isEmpty()) return;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    evictExpired(now);
+    if (!entries_.contains(key) && entries_.size() >= capacity_) {
+        auto oldest = entries_.begin();
+        for (auto it = entries_.begin(); it != entries_.end(); ++it)
+            if (it.value().expiresAtMs < oldest.value().expiresAtMs) oldest = it;
+        entries_.erase(oldest);
+    }
+    entries_.insert(key, Entry{href, now + ttlMs_});
+}
+
+bool HrefCache::isKnown(const QString& key) const {
+    if (pending_.contains(key)) return true;
+    auto it = entries_.constFind(key);
+    return it != entries_.constEnd() && QDateTime::currentMSecsSinceEpoch() < it.value().expiresAtMs;
+}
+
+bool HrefCache::beginPrefetch(const QString& key) {
+    if (isKnown(key)) return false;
+    pending_.insert(key, {});
+    return true;
+}
+
+bool HrefCache::addWaiter(const QString& key, Waiter waiter) {
+    auto it = pending_.find(key);
+    if (it == pending_.end()) return false;
+    it.value().push_back(std::move(waiter));
+    return true;
+}
+
+void HrefCache::finishPrefetch(const QString& key, const QString& href) {
+    std::vector<Waiter> waiters = pending_.take(key);
+    if (waiters.empty()) {
+        put(key, href);
+        return;
+    }
+    waiters.front()(href);
+    for (std::size_t i = 1; i < waiters.size(); ++i)
+        waiters[i](QString());
+}
+
+void HrefCache::evictExpired(qint64 nowMs) {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (nowMs >= it.value().expiresAtMs)
+            it = entries_.erase(it);
+        else
+            ++it;
+    }
+}
+
+}  // namespace sync
+}  // namespace ydisquette
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace ydisquette {
+namespace sync {
+
+class HrefCache {
+public:
+    using Waiter = std::function<void(const QString& href)>;
+
+    explicit HrefCache(qint64 ttlMs = kDefaultTtlMs, int capacity = kDefaultCapacity);
+
+    std::optional<QString> take(const QString& key);
+    void put(const QString& key, const QString& href);
+    bool isKnown(const QString& key) const;
+    bool beginPrefetch(const QString& key);
+    bool addWaiter(const QString& key, Waiter waiter);
+    void finishPrefetch(const QString& key, const QString& href);
+    int size() const { return static_cast<int>(entries_.size()); }
+
+    static const qint64 kDefaultTtlMs;
+    static const int kDefaultCapacity;
+
+private:
+    struct Entry {
+        QString href;
+        qint64 expiresAtMs = 0;
+    };
+
+    void evictExpired(qint64 nowMs);
+
+    qint64 ttlMs_;
+    int capacity_;
+    QHash<QString, Entry> entries_;
+    QHash<QString, std::vector<Waiter>> pending_;
+};
+
+}  // namespace sync
+}  // namespace ydisquette
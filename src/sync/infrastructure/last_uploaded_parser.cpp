@@ -1,32 +1,55 @@
 #include "sync/infrastructure/last_uploaded_parser.hpp"
 #include "shared/cloud_path_util.hpp"
+#include "shared/json_reader.hpp"
 #include "sync/domain/cloud_datetime.hpp"
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
 
 namespace ydisquette {
 namespace sync {
 
-QVector<LastUploadedItem> parseLastUploadedJson(const std::string& body) {
+QVector<LastUploadedItem> parseLastUploadedJson(std::string_view body) {
     QVector<LastUploadedItem> out;
-    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body));
-    if (!doc.isObject()) return out;
-    QJsonArray items = doc.object().value(QStringLiteral("items")).toArray();
-    for (const QJsonValue& v : items) {
-        QJsonObject o = v.toObject();
-        QString path = o.value(QStringLiteral("path")).toString();
-        QString modified = o.value(QStringLiteral("modified")).toString();
-        qint64 size = o.value(QStringLiteral("size")).toInteger(0);
-        QString type = o.value(QStringLiteral("type")).toString();
-        LastUploadedItem item;
-        item.relativePath = ydisquette::cloudPathToRelativeQString(path.toStdString());
-        item.modifiedSec = parseCloudModifiedToSec(modified.toStdString());
-        item.size = size;
-        item.type = type;
-        if (item.relativePath.isEmpty()) continue;
-        out.append(item);
+    JsonReader r(body);
+    std::string_view key;
+    std::string path, modified, type;
+    if (!r.beginObject()) return out;
+    while (r.nextKey(key)) {
+        if (key != "items" || !r.isArray()) {
+            r.skipValue();
+            continue;
+        }
+        r.beginArray();
+        while (r.nextElement()) {
+            if (!r.isObject()) {
+                r.skipValue();
+                continue;
+            }
+            path.clear();
+            modified.clear();
+            type.clear();
+            qint64 size = 0;
+            r.beginObject();
+            while (r.nextKey(key)) {
+                if (key == "path")
+                    r.readString(path);
+                else if (key == "modified")
+                    r.readString(modified);
+                else if (key == "size")
+                    size = r.readInteger(0);
+                else if (key == "type")
+                    r.readString(type);
+                else
+                    r.skipValue();
+            }
+            LastUploadedItem item;
+            item.relativePath = ydisquette::cloudPathToRelativeQString(path);
+            item.modifiedSec = parseCloudModifiedToSec(modified);
+            item.size = size;
+            item.type = QString::fromStdString(type);
+            if (item.relativePath.isEmpty()) continue;
+            out.append(item);
+        }
     }
+    if (!r.atEnd()) out.clear();
     return out;
 }
 
@@ -3,11 +3,12 @@
 #include "sync/domain/last_uploaded_item.hpp"
 #include <QVector>
 #include <string>
+#include <string_view>
 
 namespace ydisquette {
 namespace sync {
 
-QVector<LastUploadedItem> parseLastUploadedJson(const std::string& body);
+QVector<LastUploadedItem> parseLastUploadedJson(std::string_view body);
 
 }  // namespace sync
 }  // namespace ydisquette
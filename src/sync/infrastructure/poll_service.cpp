@@ -17,6 +17,7 @@ PollService::PollService(auth::ITokenProvider const& tokenProvider, QObject* par
     connect(worker_, &PollWorker::pollFailed, this, &PollService::onPollFailed, Qt::QueuedConnection);
     connect(worker_, &PollWorker::pollLog, this, &PollService::onPollLog, Qt::QueuedConnection);
     connect(worker_, &PollWorker::tokenExpired, this, &PollService::onTokenExpired, Qt::QueuedConnection);
+    connect(this, &PollService::stopRequested, worker_, &PollWorker::requestStop, Qt::QueuedConnection);
     thread_->start();
 }
 
@@ -35,6 +36,11 @@ void PollService::startPoll(const QString& syncRoot, const QString& indexDbPath,
     emit startPollRequested(syncRoot, indexDbPath, QString::fromStdString(*token), pollTimeSec, maxRetries);
 }
 
+void PollService::stopPoll() {
+    if (status_ == PollStatus::Polling)
+        emit stopRequested();
+}
+
 PollStatus PollService::getStatus() const {
     return status_;
 }
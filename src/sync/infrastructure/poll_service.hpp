@@ -23,11 +23,13 @@ public:
     ~PollService() override;
 
     void startPoll(const QString& syncRoot, const QString& indexDbPath, int pollTimeSec, int maxRetries);
+    void stopPoll();
     PollStatus getStatus() const;
 
 signals:
     void startPollRequested(const QString& syncRoot, const QString& indexDbPath,
                             const QString& accessToken, int pollTimeSec, int maxRetries);
+    void stopRequested();
     void pollCompleted(int changesCount);
     void pollFailed(QString errorMessage);
     void pollLog(QString message);
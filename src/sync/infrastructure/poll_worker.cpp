@@ -4,14 +4,12 @@
 #include "sync/infrastructure/disk_resource_client.hpp"
 #include "sync/infrastructure/last_uploaded_parser.hpp"
 #include "sync/infrastructure/trash_parser.hpp"
+#include "sync/infrastructure/transfer_pool.hpp"
 #include "sync/domain/sync_file_status.hpp"
 #include "shared/cloud_path_util.hpp"
-#include "auth/infrastructure/token_holder.hpp"
 #include "auth/infrastructure/yandex_disk_api_client.hpp"
-#include "auth/infrastructure/ssl_ignoring_network_access_manager.hpp"
 #include "shared/app_log.hpp"
 #include <QDateTime>
-#include <QNetworkAccessManager>
 #include <QDir>
 #include <QFileInfo>
 #include <QUrl>
@@ -20,6 +18,8 @@
 namespace ydisquette {
 namespace sync {
 
+static const int kPollParallelTransfers = 4;
+
 static bool isPathUnderSynced(const SyncIndex& index, const QString& syncRoot, const QString& rel) {
     QString path = rel.trimmed();
     while (path.startsWith(QLatin1Char('/'))) path = path.mid(1);
@@ -40,23 +40,26 @@ static std::string relativeToApiPath(const QString& rel) {
     return "/" + r.toStdString();
 }
 
-PollWorker::PollWorker(QObject* parent) : QObject(parent) {}
+PollWorker::PollWorker(QObject* parent) : QObject(parent), cancel_(new auth::CancellationToken(this)) {}
+
+void PollWorker::requestStop() {
+    stopRequested_ = true;
+    cancel_->cancel();
+}
 
 void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
                         const QString& accessToken, int pollTimeSec, int maxRetries) {
     stopRequested_ = false;
+    cancel_->reset();
     std::string accessTokenStr = accessToken.trimmed().toStdString();
     if (syncRoot.isEmpty() || indexDbPath.isEmpty() || accessTokenStr.empty() || pollTimeSec < 60) {
         emit pollFailed(QStringLiteral("Invalid poll parameters"));
         return;
     }
-    auth::TokenHolder holder;
-    holder.token = accessTokenStr;
-    QNetworkAccessManager* nam = new auth::SslIgnoringNetworkAccessManager(this);
-    auth::YandexDiskApiClient* apiClient = new auth::YandexDiskApiClient(holder, nam, this);
-    QUrlQuery probeQuery;
-    probeQuery.addQueryItem(QStringLiteral("path"), QStringLiteral("/"));
-    auth::ApiResponse probe = apiClient->get("/resources", probeQuery);
+    SyncInfrastructure& infra = SyncInfrastructureFactory::ensure(infra_, accessTokenStr);
+    auth::YandexDiskApiClient* apiClient = infra.apiClient.get();
+    apiClient->setCancellationToken(cancel_);
+    auth::ApiResponse probe = apiClient->probe();
     if (probe.statusCode == 401) {
         emit tokenExpired();
         return;
@@ -85,9 +88,10 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
 
     QUrlQuery lastQuery;
     lastQuery.addQueryItem(QStringLiteral("limit"), QString::number(300));
+    auth::YandexDiskApiClient::project(lastQuery, auth::YandexDiskApiClient::kLastUploadedFields);
     auth::ApiResponse lastRes = apiClient->get("/resources/last-uploaded", lastQuery);
     if (!lastRes.ok()) {
-        QString err = QString::fromStdString(lastRes.body);
+        QString err = QString::fromUtf8(lastRes.body);
         if (err.isEmpty()) err = QStringLiteral("HTTP %1").arg(lastRes.statusCode);
         pollRepo.updateRun(runId, QStringLiteral("failed"), nowSec, 0, err);
         pollRepo.close();
@@ -95,21 +99,49 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
         emit pollFailed(err);
         return;
     }
-    QVector<LastUploadedItem> items = parseLastUploadedJson(lastRes.body);
-    DiskResourceClient client(*apiClient);
+    QVector<LastUploadedItem> items = parseLastUploadedJson(lastRes.bodyView());
+    DiskResourceClient& client = *infra.diskClient;
     QString localRoot = QDir::cleanPath(syncRoot + QLatin1Char('/')) + QLatin1Char('/');
     int changesCount = 0;
-    if (!index.beginTransaction()) {
+    if (!index.beginBatch()) {
         pollRepo.updateRun(runId, QStringLiteral("failed"), nowSec, 0, QStringLiteral("Index transaction failed"));
         index.close();
         pollRepo.close();
         emit pollFailed(QStringLiteral("Index transaction failed"));
         return;
     }
-    auto flushIndex = [&]() {
-        index.commit();
-        index.beginTransaction();
+    auto flushIndex = [&]() { index.flushBatched(); };
+    TransferPool pool(kPollParallelTransfers);
+    auto stopRequested = [this]() { return stopRequested_.load(); };
+    auto enqueueDownload = [&](const LastUploadedItem& item, const std::optional<SyncIndexEntry>& entry,
+                               const QString& localPath, const std::string& apiPath, bool countRetries) {
+        index.setStatus(syncRoot, item.relativePath, FileStatus::DOWNLOADING, 0);
+        flushIndex();
+        const qint64 resumeFrom = (entry && entry->part_remote_size == item.size && entry->part_offset < item.size)
+            ? entry->part_offset : 0;
+        const int retries = entry ? entry->retries : 0;
+        pool.enqueue([&, item, localPath, apiPath, resumeFrom, retries, countRetries](TransferPool::Done done) {
+            client.downloadFileAsync(apiPath, localPath,
+                [&, item, localPath, retries, countRetries, done](DiskResourceResult dr) {
+                    if (dr.success) {
+                        QFileInfo fi2(localPath);
+                        index.set(syncRoot, item.relativePath, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
+                                  FileStatus::SYNCED, 0);
+                        ++changesCount;
+                    } else {
+                        index.setPartial(syncRoot, item.relativePath, dr.partialBytes,
+                                         dr.partialBytes > 0 ? item.size : 0);
+                        if (countRetries && !stopRequested_) {
+                            FileStatus newStatus = (retries + 1 >= maxRetries) ? FileStatus::FAILED : FileStatus::TO_DOWNLOAD;
+                            index.setStatus(syncRoot, item.relativePath, newStatus, 1);
+                        }
+                    }
+                    flushIndex();
+                    done();
+                }, resumeFrom);
+        }, [&client, apiPath]() { client.prefetchDownloadHref(apiPath); });
     };
+
     for (const LastUploadedItem& item : items) {
         if (stopRequested_) break;
         if (item.modifiedSec < sinceSec) continue;
@@ -118,7 +150,7 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
         QString localPath = localRoot + item.relativePath;
         std::string apiPath = relativeToApiPath(item.relativePath);
         auto entry = index.get(syncRoot, item.relativePath);
-        if (entry && entry->status == QLatin1String(FileStatus::TO_DELETE)) continue;
+        if (entry && entry->status == FileStatus::TO_DELETE) continue;
         qint64 localMtime = 0;
         qint64 localSize = 0;
         QFileInfo fi(localPath);
@@ -128,66 +160,57 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
         }
         bool cloudNewer = item.modifiedSec > localMtime;
         bool localNewer = localMtime > item.modifiedSec;
-        bool alreadySynced = entry && entry->status == QLatin1String(FileStatus::SYNCED)
+        bool alreadySynced = entry && entry->status == FileStatus::SYNCED
                             && entry->size == item.size;
         if (cloudNewer && !alreadySynced) {
             logToFile(QStringLiteral("[Poll] cloud newer: ") + item.relativePath + QStringLiteral(" — downloading"));
             if (!QDir().mkpath(fi.absolutePath())) continue;
             if (!entry) index.upsertNew(syncRoot, item.relativePath, 0, 0);
-            index.setStatus(syncRoot, item.relativePath, QString::fromUtf8(FileStatus::DOWNLOADING), 0);
-            flushIndex();
-            DiskResourceResult dr = client.downloadFile(apiPath, localPath);
-            if (dr.success) {
-                QFileInfo fi2(localPath);
-                index.set(syncRoot, item.relativePath, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
-                         QString::fromUtf8(FileStatus::SYNCED), 0);
-                flushIndex();
-                ++changesCount;
-            } else {
-                int newRetries = (entry ? entry->retries : 0) + 1;
-                QString newStatus = (newRetries >= maxRetries)
-                    ? QString::fromUtf8(FileStatus::FAILED)
-                    : QString::fromUtf8(FileStatus::TO_DOWNLOAD);
-                index.setStatus(syncRoot, item.relativePath, newStatus, 1);
-                flushIndex();
-            }
+            enqueueDownload(item, entry, localPath, apiPath, true);
         } else if (localNewer && fi.exists() && fi.isFile()) {
             logToFile(QStringLiteral("[Poll] local newer: ") + item.relativePath + QStringLiteral(" — uploading"));
-            DiskResourceResult dr = client.uploadFile(apiPath, localPath);
-            if (dr.success) {
-                bool wrote = false;
-                if (!entry) {
-                    index.upsertNew(syncRoot, item.relativePath, localMtime, localSize);
-                    wrote = true;
-                } else if (entry->status != QLatin1String(FileStatus::SYNCED)
-                           || entry->mtime_sec != localMtime || entry->size != localSize) {
-                    index.set(syncRoot, item.relativePath, localMtime, localSize, QString::fromUtf8(FileStatus::SYNCED), 0);
-                    wrote = true;
-                }
-                if (wrote) { flushIndex(); ++changesCount; }
-            }
+            pool.enqueue([&, item, entry, localPath, apiPath, localMtime, localSize](TransferPool::Done done) {
+                client.uploadFileAsync(apiPath, localPath, {},
+                    [&, item, entry, localMtime, localSize, done](DiskResourceResult dr) {
+                        if (dr.success) {
+                            bool wrote = false;
+                            if (!entry) {
+                                index.upsertNew(syncRoot, item.relativePath, localMtime, localSize);
+                                wrote = true;
+                            } else if (entry->status != FileStatus::SYNCED
+                                       || entry->mtime_sec != localMtime || entry->size != localSize) {
+                                index.set(syncRoot, item.relativePath, localMtime, localSize,
+                                          FileStatus::SYNCED, 0);
+                                wrote = true;
+                            }
+                            if (wrote) { flushIndex(); ++changesCount; }
+                        }
+                        done();
+                    });
+            }, [&client, apiPath]() { client.prefetchUploadHref(apiPath); });
         } else if (item.modifiedSec == localMtime) {
             if (fi.exists() && fi.isFile() && localSize == item.size) {
             } else if (!fi.exists() || !fi.isFile()) {
                 logToFile(QStringLiteral("[Poll] missing locally: ") + item.relativePath + QStringLiteral(" — downloading"));
                 if (!QDir().mkpath(fi.absolutePath())) continue;
                 if (!entry) index.upsertNew(syncRoot, item.relativePath, 0, 0);
-                index.setStatus(syncRoot, item.relativePath, QString::fromUtf8(FileStatus::DOWNLOADING), 0);
-                flushIndex();
-                DiskResourceResult dr = client.downloadFile(apiPath, localPath);
-                if (dr.success) {
-                    QFileInfo fi2(localPath);
-                    index.set(syncRoot, item.relativePath, fi2.lastModified().toSecsSinceEpoch(), fi2.size(),
-                             QString::fromUtf8(FileStatus::SYNCED), 0);
-                    flushIndex();
-                    ++changesCount;
-                }
+                enqueueDownload(item, entry, localPath, apiPath, false);
             }
         }
     }
+    auto finishStopped = [&]() {
+        index.rollback();
+        index.close();
+        pollRepo.updateRun(runId, QStringLiteral("stopped"), std::nullopt, changesCount, QString());
+        pollRepo.close();
+        emit pollFailed(QStringLiteral("Poll stopped"));
+    };
+    if (!pool.waitForIdle(stopRequested) || stopRequested_) {
+        finishStopped();
+        return;
+    }
 
     const int trashLimit = 300;
-    const QString trashFields = QStringLiteral("path,origin_path,type,deleted,_embedded.items.path,_embedded.items.origin_path,_embedded.items.type,_embedded.items.deleted");
     int trashOffset = 0;
     for (;;) {
         if (stopRequested_) break;
@@ -196,16 +219,16 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
         trashQuery.addQueryItem(QStringLiteral("limit"), QString::number(trashLimit));
         trashQuery.addQueryItem(QStringLiteral("offset"), QString::number(trashOffset));
         trashQuery.addQueryItem(QStringLiteral("sort"), QStringLiteral("-deleted"));
-        trashQuery.addQueryItem(QStringLiteral("fields"), trashFields);
+        auth::YandexDiskApiClient::project(trashQuery, auth::YandexDiskApiClient::kTrashFields);
         auth::ApiResponse trashRes = apiClient->get("/trash/resources", trashQuery);
         QString trashUrl = QStringLiteral("/trash/resources");
         if (!trashQuery.isEmpty())
             trashUrl += QChar('?') + trashQuery.toString(QUrl::FullyEncoded);
         emit pollLog(QStringLiteral("[Poll] trash request: GET ") + trashUrl
                      + QStringLiteral(" → HTTP ") + QString::number(trashRes.statusCode));
-        emit pollLog(QStringLiteral("[Poll] trash body: ") + QString::fromStdString(trashRes.body));
+        emit pollLog(QStringLiteral("[Poll] trash body: ") + QString::fromUtf8(trashRes.body));
         if (!trashRes.ok()) break;
-        QVector<TrashItem> trashItems = parseTrashJson(trashRes.body);
+        QVector<TrashItem> trashItems = parseTrashJson(trashRes.bodyView());
         if (trashItems.isEmpty()) break;
         bool pastSince = false;
         for (const TrashItem& ti : trashItems) {
@@ -218,9 +241,9 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
             if (!isPathUnderSynced(index, syncRoot, rel)) continue;
             if (ti.type == QLatin1String("dir")) {
                 index.upsertNew(syncRoot, rel, 0, 0);
-                index.setStatusPrefix(syncRoot, rel, QString::fromUtf8(FileStatus::CLOUD_DELETED));
+                index.setStatusPrefix(syncRoot, rel, FileStatus::CLOUD_DELETED);
             } else {
-                index.setStatus(syncRoot, rel, QString::fromUtf8(FileStatus::CLOUD_DELETED), 0);
+                index.setStatus(syncRoot, rel, FileStatus::CLOUD_DELETED, 0);
             }
             flushIndex();
             ++changesCount;
@@ -229,12 +252,17 @@ void PollWorker::doPoll(const QString& syncRoot, const QString& indexDbPath,
         if (pastSince || trashItems.size() < trashLimit) break;
         trashOffset += trashLimit;
     }
+    if (stopRequested_) {
+        finishStopped();
+        return;
+    }
 
     index.commit();
     index.close();
     qint64 finishedAt = QDateTime::currentSecsSinceEpoch();
     pollRepo.updateRun(runId, QStringLiteral("completed"), finishedAt, changesCount, QString());
     pollRepo.close();
+    logToFile(QStringLiteral("[Poll] network ") + SyncInfrastructureFactory::connectionStats(infra));
     emit pollCompleted(changesCount);
 }
 
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "auth/infrastructure/cancellation_token.hpp"
+#include "sync/infrastructure/sync_infrastructure_factory.hpp"
 #include <QObject>
 #include <QString>
 #include <atomic>
+#include <memory>
 #include <string>
 
 namespace ydisquette {
@@ -16,6 +19,7 @@ public:
 public slots:
     void doPoll(const QString& syncRoot, const QString& indexDbPath,
                 const QString& accessToken, int pollTimeSec, int maxRetries);
+    void requestStop();
 
 signals:
     void pollCompleted(int changesCount);
@@ -25,6 +29,8 @@ signals:
 
 private:
     std::atomic<bool> stopRequested_{false};
+    auth::CancellationToken* cancel_;
+    std::unique_ptr<SyncInfrastructure> infra_;
 };
 
 }  // namespace sync
@@ -1,4 +1,5 @@
 #include "sync/infrastructure/sqlite_poll_run_repository.hpp"
+#include "shared/sqlite_database.hpp"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <optional>
@@ -14,9 +15,7 @@ bool SqlitePollRunRepository::open(const QString& dbPath) {
     if (!connectionName_.isEmpty())
         return true;
     connectionName_ = QStringLiteral("poll_run_") + QString::number(reinterpret_cast<quintptr>(this));
-    QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName_);
-    db.setDatabaseName(dbPath);
-    return db.open();
+    return openSqliteDatabase(connectionName_, dbPath);
 }
 
 void SqlitePollRunRepository::close() {
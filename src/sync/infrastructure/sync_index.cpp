@@ -1,9 +1,16 @@
 #include "sync/infrastructure/sync_index.hpp"
+#include "shared/app_log.hpp"
+#include "shared/sqlite_database.hpp"
 #include <QDateTime>
 #include <QDir>
 #include <QFileInfo>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QVariant>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <initializer_list>
 
 namespace ydisquette {
 namespace sync {
@@ -16,16 +23,16 @@ IndexState readIndexState(const QString& dbPath, const QString& syncRoot) {
         out.summary = QStringLiteral("(no file)");
         return out;
     }
-    QString connName = QStringLiteral("sync_index_read_") + QString::number(QDateTime::currentMSecsSinceEpoch());
+    static std::atomic<int> readSeq{0};
+    QString connName = QStringLiteral("sync_index_read_") + QString::number(QDateTime::currentMSecsSinceEpoch())
+        + QLatin1Char('_') + QString::number(++readSeq);
     {
-        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connName);
-        db.setDatabaseName(dbPath);
-        if (!db.open()) {
+        if (!openSqliteDatabase(connName, dbPath)) {
             out.summary = QStringLiteral("(open failed)");
             QSqlDatabase::removeDatabase(connName);
             return out;
         }
-        QSqlQuery q(db);
+        QSqlQuery q(QSqlDatabase::database(connName));
         if (!q.exec(QStringLiteral("SELECT COUNT(*) FROM sync_state"))) {
             out.summary = QStringLiteral("(query failed)");
             QSqlDatabase::removeDatabase(connName);
@@ -35,30 +42,27 @@ IndexState readIndexState(const QString& dbPath, const QString& syncRoot) {
             out.totalEntries = q.value(0).toInt();
         if (!syncRoot.trimmed().isEmpty()) {
             QString normRoot = normalizeSyncRoot(syncRoot);
-            if (!normRoot.isEmpty()) {
-                if (q.prepare(QStringLiteral("SELECT COUNT(*) FROM sync_state WHERE sync_root = ? AND status = ?"))) {
-                    q.addBindValue(normRoot);
-                    q.addBindValue(QStringLiteral("TO_DOWNLOAD"));
-                    if (q.exec() && q.next())
-                        out.toDownloadCount = q.value(0).toInt();
-                }
-                if (q.prepare(QStringLiteral("SELECT COUNT(*) FROM sync_state WHERE sync_root = ? AND status = ?"))) {
-                    q.addBindValue(normRoot);
-                    q.addBindValue(QStringLiteral("DOWNLOADING"));
-                    if (q.exec() && q.next())
-                        out.toDownloadCount += q.value(0).toInt();
-                }
-                if (q.prepare(QStringLiteral("SELECT COUNT(*) FROM sync_state WHERE sync_root = ? AND status = ?"))) {
-                    q.addBindValue(normRoot);
-                    q.addBindValue(QStringLiteral("CLOUD_DELETED"));
-                    if (q.exec() && q.next())
-                        out.cloudDeletedCount = q.value(0).toInt();
-                }
-                if (q.prepare(QStringLiteral("SELECT COUNT(*) FROM sync_state WHERE sync_root = ? AND status = ?"))) {
-                    q.addBindValue(normRoot);
-                    q.addBindValue(QStringLiteral("TO_DELETE"));
-                    if (q.exec() && q.next())
-                        out.toDeleteCount = q.value(0).toInt();
+            if (!normRoot.isEmpty()
+                && q.prepare(QStringLiteral("SELECT status, COUNT(*) FROM sync_state WHERE sync_root = ? GROUP BY status"))) {
+                q.addBindValue(normRoot);
+                if (q.exec()) {
+                    while (q.next()) {
+                        const int count = q.value(1).toInt();
+                        switch (fileStatusFromCode(q.value(0).toInt())) {
+                        case FileStatus::TO_DOWNLOAD:
+                        case FileStatus::DOWNLOADING:
+                            out.toDownloadCount += count;
+                            break;
+                        case FileStatus::CLOUD_DELETED:
+                            out.cloudDeletedCount += count;
+                            break;
+                        case FileStatus::TO_DELETE:
+                            out.toDeleteCount += count;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
                 }
             }
         }
@@ -89,47 +93,129 @@ static QString normalizeRelativePath(QString path) {
     return path;
 }
 
+struct PrefixRange {
+    QString exact;
+    QString dirStart;
+    QString end;
+};
+
+static PrefixRange prefixRange(const QString& prefix) {
+    PrefixRange r;
+    r.exact = prefix;
+    r.dirStart = prefix.endsWith(QLatin1Char('/')) ? prefix : prefix + QLatin1Char('/');
+    r.end = r.dirStart;
+    r.end.back() = QLatin1Char('/' + 1);
+    return r;
+}
+
+static QString underPrefixSql() {
+    return QStringLiteral("(relative_path >= ? AND relative_path < ? AND (relative_path = ? OR relative_path >= ?))");
+}
+
+static QVariantList underPrefixBinds(const QString& prefix) {
+    const PrefixRange r = prefixRange(prefix);
+    return {r.exact, r.end, r.exact, r.dirStart};
+}
+
+static std::atomic<int> g_commitRows{SyncIndexCommitPolicy().maxPendingRows};
+static std::atomic<int> g_commitDelayMs{SyncIndexCommitPolicy().maxDelayMs};
+
+void SyncIndex::setDefaultCommitPolicy(const SyncIndexCommitPolicy& policy) {
+    g_commitRows = policy.maxPendingRows;
+    g_commitDelayMs = policy.maxDelayMs;
+}
+
+SyncIndexCommitPolicy SyncIndex::defaultCommitPolicy() {
+    return {g_commitRows.load(), g_commitDelayMs.load()};
+}
+
 SyncIndex::~SyncIndex() {
     close();
 }
 
-static bool ensureStatusColumns(QSqlQuery& q) {
+static bool ensureStatusColumns(QSqlQuery& q, bool& textStatus) {
+    textStatus = false;
     if (!q.exec(QStringLiteral("PRAGMA table_info(sync_state)"))) return false;
     bool hasStatus = false;
     bool hasRetries = false;
+    bool hasPartOffset = false;
+    bool hasPartRemoteSize = false;
     while (q.next()) {
         QString name = q.value(1).toString();
-        if (name == QLatin1String("status")) hasStatus = true;
+        if (name == QLatin1String("status")) {
+            hasStatus = true;
+            textStatus = q.value(2).toString().compare(QLatin1String("TEXT"), Qt::CaseInsensitive) == 0;
+        }
         if (name == QLatin1String("retries")) hasRetries = true;
+        if (name == QLatin1String("part_offset")) hasPartOffset = true;
+        if (name == QLatin1String("part_remote_size")) hasPartRemoteSize = true;
     }
-    if (!hasStatus && !q.exec(QStringLiteral("ALTER TABLE sync_state ADD COLUMN status TEXT NOT NULL DEFAULT 'SYNCED'")))
+    if (!hasStatus && !q.exec(QStringLiteral("ALTER TABLE sync_state ADD COLUMN status INTEGER NOT NULL DEFAULT 0")))
         return false;
     if (!hasRetries && !q.exec(QStringLiteral("ALTER TABLE sync_state ADD COLUMN retries INTEGER NOT NULL DEFAULT 0")))
         return false;
+    if (!hasPartOffset && !q.exec(QStringLiteral("ALTER TABLE sync_state ADD COLUMN part_offset INTEGER NOT NULL DEFAULT 0")))
+        return false;
+    if (!hasPartRemoteSize && !q.exec(QStringLiteral("ALTER TABLE sync_state ADD COLUMN part_remote_size INTEGER NOT NULL DEFAULT 0")))
+        return false;
+    return true;
+}
+
+static const char kSyncStateColumns[] =
+    "sync_root TEXT NOT NULL, relative_path TEXT NOT NULL,"
+    "mtime_sec INTEGER NOT NULL, size INTEGER NOT NULL, updated_at INTEGER,"
+    "status INTEGER NOT NULL DEFAULT 0, retries INTEGER NOT NULL DEFAULT 0,"
+    "part_offset INTEGER NOT NULL DEFAULT 0, part_remote_size INTEGER NOT NULL DEFAULT 0,"
+    "PRIMARY KEY (sync_root, relative_path)";
+
+static bool migrateTextStatus(QSqlQuery& q) {
+    if (!q.exec(QStringLiteral("BEGIN IMMEDIATE"))) return false;
+    bool textStatus = false;
+    if (!ensureStatusColumns(q, textStatus)) {
+        q.exec(QStringLiteral("ROLLBACK"));
+        return false;
+    }
+    if (!textStatus) return q.exec(QStringLiteral("COMMIT"));
+    QString statusCase = QStringLiteral("CASE status");
+    for (int i = 0; i < kFileStatusCount; ++i)
+        statusCase += QStringLiteral(" WHEN '%1' THEN %2").arg(QLatin1String(kFileStatusNames[i])).arg(i);
+    statusCase += QStringLiteral(" ELSE %1 END").arg(static_cast<int>(FileStatus::SYNCED));
+    const bool migrated =
+        q.exec(QStringLiteral("CREATE TABLE sync_state_migrated (") + QLatin1String(kSyncStateColumns) + QLatin1Char(')'))
+        && q.exec(QStringLiteral(
+               "INSERT INTO sync_state_migrated (sync_root, relative_path, mtime_sec, size, updated_at, status, retries, part_offset, part_remote_size) "
+               "SELECT sync_root, relative_path, mtime_sec, size, updated_at, ") + statusCase
+               + QStringLiteral(", retries, part_offset, part_remote_size FROM sync_state"))
+        && q.exec(QStringLiteral("DROP TABLE sync_state"))
+        && q.exec(QStringLiteral("ALTER TABLE sync_state_migrated RENAME TO sync_state"));
+    if (!migrated || !q.exec(QStringLiteral("COMMIT"))) {
+        q.exec(QStringLiteral("ROLLBACK"));
+        ydisquette::logToFile(QStringLiteral("[Sync] index status migration failed"));
+        return false;
+    }
+    ydisquette::logToFile(QStringLiteral("[Sync] index status column migrated to integer codes"));
     return true;
 }
 
 bool SyncIndex::open(const QString& dbPath) {
     if (!connectionName_.isEmpty())
         return true;
+    policy_ = defaultCommitPolicy();
+    pending_ = 0;
+    batching_ = grouped_ = writing_ = savepoint_ = false;
     QFileInfo fi(dbPath);
     QDir().mkpath(fi.absolutePath());
     connectionName_ = QStringLiteral("sync_index_") + QString::number(reinterpret_cast<quintptr>(this));
-    {
-        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), connectionName_);
-        db.setDatabaseName(dbPath);
-        if (!db.open())
-            return false;
-    }
+    if (!openSqliteDatabase(connectionName_, dbPath))
+        return false;
     QSqlQuery q(queryDb());
-    if (!q.exec(QStringLiteral(
-            "CREATE TABLE IF NOT EXISTS sync_state ("
-            "sync_root TEXT NOT NULL, relative_path TEXT NOT NULL,"
-            "mtime_sec INTEGER NOT NULL, size INTEGER NOT NULL, updated_at INTEGER,"
-            "status TEXT NOT NULL DEFAULT 'SYNCED', retries INTEGER NOT NULL DEFAULT 0,"
-            "PRIMARY KEY (sync_root, relative_path))")))
+    if (!q.exec(QStringLiteral("CREATE TABLE IF NOT EXISTS sync_state (") + QLatin1String(kSyncStateColumns) + QLatin1Char(')')))
+        return false;
+    bool textStatus = false;
+    if (!ensureStatusColumns(q, textStatus)) return false;
+    if (textStatus && !migrateTextStatus(q)) return false;
+    if (!q.exec(QStringLiteral("CREATE INDEX IF NOT EXISTS idx_sync_state_status ON sync_state(sync_root, status)")))
         return false;
-    if (!ensureStatusColumns(q)) return false;
     if (!q.exec(QStringLiteral(
             "CREATE TABLE IF NOT EXISTS poll_run ("
             "id INTEGER PRIMARY KEY AUTOINCREMENT, started_at INTEGER NOT NULL,"
@@ -144,6 +230,9 @@ bool SyncIndex::open(const QString& dbPath) {
 
 void SyncIndex::close() {
     if (connectionName_.isEmpty()) return;
+    if (writing_) rollback();
+    commitTimer_.reset();
+    statements_.clear();
     QSqlDatabase::removeDatabase(connectionName_);
     connectionName_.clear();
 }
@@ -152,22 +241,56 @@ QSqlDatabase SyncIndex::queryDb() const {
     return QSqlDatabase::database(connectionName_);
 }
 
+QSqlQuery* SyncIndex::statement(const QString& sql) const {
+    auto it = statements_.find(sql);
+    if (it != statements_.end()) return &it.value();
+    QSqlQuery q(queryDb());
+    q.setForwardOnly(true);
+    if (!q.prepare(sql)) return nullptr;
+    return &statements_.insert(sql, q).value();
+}
+
+static bool execBound(QSqlQuery* q, std::initializer_list<QVariant> values, const QVariantList& extra = QVariantList()) {
+    if (!q) return false;
+    int i = 0;
+    for (const QVariant& v : values)
+        q->bindValue(i++, v);
+    for (const QVariant& v : extra)
+        q->bindValue(i++, v);
+    return q->exec();
+}
+
+static bool firstRowExists(QSqlQuery* q, std::initializer_list<QVariant> values, const QVariantList& extra = QVariantList()) {
+    const bool found = execBound(q, values, extra) && q->next();
+    if (q) q->finish();
+    return found;
+}
+
+static QStringList firstColumn(QSqlQuery* q) {
+    QStringList out;
+    while (q->next())
+        out.append(q->value(0).toString().trimmed());
+    q->finish();
+    return out;
+}
+
 std::optional<SyncIndexEntry> SyncIndex::get(const QString& syncRoot, const QString& relativePath) const {
     if (connectionName_.isEmpty()) return std::nullopt;
     QString rel = normalizeRelativePath(relativePath);
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral("SELECT mtime_sec, size, status, retries, updated_at FROM sync_state WHERE sync_root = ? AND relative_path = ?"));
-    q.addBindValue(syncRoot);
-    q.addBindValue(rel);
-    if (!q.exec() || !q.next())
+    QSqlQuery* q = statement(QStringLiteral("SELECT mtime_sec, size, status, retries, updated_at, part_offset, part_remote_size FROM sync_state WHERE sync_root = ? AND relative_path = ?"));
+    if (!execBound(q, {syncRoot, rel}) || !q->next()) {
+        if (q) q->finish();
         return std::nullopt;
+    }
     SyncIndexEntry e;
-    e.mtime_sec = q.value(0).toLongLong();
-    e.size = q.value(1).toLongLong();
-    e.status = q.value(2).toString();
-    if (e.status.isEmpty()) e.status = QStringLiteral("SYNCED");
-    e.retries = q.value(3).toInt();
-    e.updated_at_sec = q.value(4).toLongLong();
+    e.mtime_sec = q->value(0).toLongLong();
+    e.size = q->value(1).toLongLong();
+    e.status = fileStatusFromCode(q->value(2).toInt());
+    e.retries = q->value(3).toInt();
+    e.updated_at_sec = q->value(4).toLongLong();
+    e.part_offset = q->value(5).toLongLong();
+    e.part_remote_size = q->value(6).toLongLong();
+    q->finish();
     return e;
 }
 
@@ -175,140 +298,149 @@ bool SyncIndex::hasAnyWithPrefix(const QString& syncRoot, const QString& relativ
     if (connectionName_.isEmpty()) return false;
     QString prefix = normalizeRelativePath(relativePathPrefix);
     if (prefix.isEmpty()) return true;
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral("SELECT 1 FROM sync_state WHERE sync_root = ? AND (relative_path = ? OR relative_path LIKE ?) LIMIT 1"));
-    q.addBindValue(syncRoot);
-    q.addBindValue(prefix);
-    q.addBindValue(prefix + QLatin1Char('/') + QLatin1Char('%'));
-    return q.exec() && q.next();
+    return firstRowExists(
+        statement(QStringLiteral("SELECT 1 FROM sync_state WHERE sync_root = ? AND ") + underPrefixSql() + QStringLiteral(" LIMIT 1")),
+        {syncRoot}, underPrefixBinds(prefix));
 }
 
 bool SyncIndex::hasAnyUnderPrefixWithStatus(const QString& syncRoot, const QString& relativePathPrefix,
-                                           const QStringList& statuses) const {
+                                           const QVector<FileStatus>& statuses) const {
     if (connectionName_.isEmpty() || statuses.isEmpty()) return false;
     QString prefix = normalizeRelativePath(relativePathPrefix);
     if (prefix.isEmpty()) return false;
-    QString likePrefix = prefix + QLatin1Char('/') + QLatin1Char('%');
     QString inPlaceholders;
-    for (int i = 0; i < statuses.size(); ++i)
+    QVariantList binds = underPrefixBinds(prefix);
+    for (int i = 0; i < statuses.size(); ++i) {
         inPlaceholders += (i > 0 ? QStringLiteral(",") : QString()) + QStringLiteral("?");
-    QSqlQuery q(queryDb());
-    if (!q.prepare(QStringLiteral("SELECT 1 FROM sync_state WHERE sync_root = ? AND (relative_path = ? OR relative_path LIKE ?) AND status IN (") + inPlaceholders + QStringLiteral(") LIMIT 1")))
-        return false;
-    q.addBindValue(syncRoot);
-    q.addBindValue(prefix);
-    q.addBindValue(likePrefix);
-    for (const QString& s : statuses)
-        q.addBindValue(s);
-    return q.exec() && q.next();
+        binds.append(static_cast<int>(statuses[i]));
+    }
+    return firstRowExists(
+        statement(QStringLiteral("SELECT 1 FROM sync_state WHERE sync_root = ? AND ") + underPrefixSql() + QStringLiteral(" AND status IN (") + inPlaceholders + QStringLiteral(") LIMIT 1")),
+        {syncRoot}, binds);
+}
+
+static const QString& allowedFromSql(FileStatus to) {
+    static const std::array<QString, kFileStatusCount> sql = [] {
+        std::array<QString, kFileStatusCount> out;
+        for (int t = 0; t < kFileStatusCount; ++t) {
+            QStringList codes;
+            for (int f = 0; f < kFileStatusCount; ++f)
+                if (canTransition(static_cast<FileStatus>(f), static_cast<FileStatus>(t))) codes.append(QString::number(f));
+            out[t] = QStringLiteral("sync_state.status IN (") + codes.join(QLatin1Char(',')) + QLatin1Char(')');
+        }
+        return out;
+    }();
+    return sql[static_cast<int>(to)];
+}
+
+bool SyncIndex::rejectedTransition(const QString& syncRoot, const QString& relativePath, FileStatus to) const {
+    auto entry = get(syncRoot, relativePath);
+    if (!entry || canTransition(entry->status, to)) return false;
+    ydisquette::logToFile(QStringLiteral("[Sync] index rejected ") + QLatin1String(fileStatusName(entry->status))
+        + QStringLiteral(" -> ") + QLatin1String(fileStatusName(to)) + QStringLiteral(" for ") + relativePath);
+    return true;
 }
 
 bool SyncIndex::set(const QString& syncRoot, const QString& relativePath, qint64 mtimeSec, qint64 size,
-                    const QString& status, int retries) {
-    if (connectionName_.isEmpty()) return false;
+                    FileStatus status, int retries) {
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
     QString rel = normalizeRelativePath(relativePath);
     qint64 now = QDateTime::currentSecsSinceEpoch();
-    QString st = status.isEmpty() ? QStringLiteral("SYNCED") : status;
     int r = (retries >= 0) ? retries : 0;
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral(
-            "INSERT OR REPLACE INTO sync_state (sync_root, relative_path, mtime_sec, size, updated_at, status, retries) VALUES (?, ?, ?, ?, ?, ?, ?)"));
-    q.addBindValue(syncRoot);
-    q.addBindValue(rel);
-    q.addBindValue(mtimeSec);
-    q.addBindValue(size);
-    q.addBindValue(now);
-    q.addBindValue(st);
-    q.addBindValue(r);
-    return q.exec();
-}
-
-bool SyncIndex::setStatus(const QString& syncRoot, const QString& relativePath, const QString& status,
+    if (!isRestrictedTarget(status))
+        return execBound(statement(QStringLiteral(
+                             "INSERT OR REPLACE INTO sync_state (sync_root, relative_path, mtime_sec, size, updated_at, status, retries) VALUES (?, ?, ?, ?, ?, ?, ?)")),
+                         {syncRoot, rel, mtimeSec, size, now, static_cast<int>(status), r});
+    QSqlQuery* q = statement(QStringLiteral(
+        "INSERT INTO sync_state (sync_root, relative_path, mtime_sec, size, updated_at, status, retries) VALUES (?, ?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT (sync_root, relative_path) DO UPDATE SET mtime_sec = excluded.mtime_sec, size = excluded.size, "
+        "updated_at = excluded.updated_at, status = excluded.status, retries = excluded.retries, "
+        "part_offset = 0, part_remote_size = 0 WHERE ") + allowedFromSql(status));
+    if (!execBound(q, {syncRoot, rel, mtimeSec, size, now, static_cast<int>(status), r})) return false;
+    return q->numRowsAffected() > 0 || !rejectedTransition(syncRoot, rel, status);
+}
+
+bool SyncIndex::setStatus(const QString& syncRoot, const QString& relativePath, FileStatus status,
                           int retriesDelta) {
-    if (connectionName_.isEmpty()) return false;
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
     QString rel = normalizeRelativePath(relativePath);
     qint64 now = QDateTime::currentSecsSinceEpoch();
-    QSqlQuery q(queryDb());
+    const QString guard = isRestrictedTarget(status) ? QStringLiteral(" AND ") + allowedFromSql(status) : QString();
+    QSqlQuery* q = nullptr;
+    bool ok = false;
     if (retriesDelta != 0) {
-        q.prepare(QStringLiteral(
-                "UPDATE sync_state SET status = ?, retries = retries + ?, updated_at = ? WHERE sync_root = ? AND relative_path = ?"));
-        q.addBindValue(status);
-        q.addBindValue(retriesDelta);
-        q.addBindValue(now);
-        q.addBindValue(syncRoot);
-        q.addBindValue(rel);
+        q = statement(QStringLiteral(
+                "UPDATE sync_state SET status = ?, retries = retries + ?, updated_at = ? WHERE sync_root = ? AND relative_path = ?") + guard);
+        ok = execBound(q, {static_cast<int>(status), retriesDelta, now, syncRoot, rel});
     } else {
-        q.prepare(QStringLiteral(
-                "UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ? AND relative_path = ?"));
-        q.addBindValue(status);
-        q.addBindValue(now);
-        q.addBindValue(syncRoot);
-        q.addBindValue(rel);
+        q = statement(QStringLiteral(
+                "UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ? AND relative_path = ?") + guard);
+        ok = execBound(q, {static_cast<int>(status), now, syncRoot, rel});
     }
-    return q.exec();
+    if (!ok) return false;
+    return guard.isEmpty() || q->numRowsAffected() > 0 || !rejectedTransition(syncRoot, rel, status);
 }
 
-bool SyncIndex::setStatusPrefix(const QString& syncRoot, const QString& relativePathPrefix, const QString& status) {
-    if (connectionName_.isEmpty()) return false;
+bool SyncIndex::setStatusPrefix(const QString& syncRoot, const QString& relativePathPrefix, FileStatus status) {
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
     QString prefix = normalizeRelativePath(relativePathPrefix);
     qint64 now = QDateTime::currentSecsSinceEpoch();
-    QString st = status.isEmpty() ? QStringLiteral("SYNCED") : status;
-    QSqlQuery q(queryDb());
-    if (prefix.isEmpty()) {
-        q.prepare(QStringLiteral("UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ?"));
-        q.addBindValue(st);
-        q.addBindValue(now);
-        q.addBindValue(syncRoot);
-    } else {
-        QString likePrefix = prefix.endsWith(QLatin1Char('/')) ? prefix : prefix + QLatin1Char('/');
-        q.prepare(QStringLiteral(
-                "UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ? AND (relative_path = ? OR relative_path LIKE ?)"));
-        q.addBindValue(st);
-        q.addBindValue(now);
-        q.addBindValue(syncRoot);
-        q.addBindValue(prefix);
-        q.addBindValue(likePrefix + QStringLiteral("%"));
-    }
-    return q.exec();
+    const int st = static_cast<int>(status);
+    if (prefix.isEmpty())
+        return execBound(statement(QStringLiteral("UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ?")),
+                         {st, now, syncRoot});
+    return execBound(statement(QStringLiteral("UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ? AND ") + underPrefixSql()),
+                     {st, now, syncRoot}, underPrefixBinds(prefix));
 }
 
-QStringList SyncIndex::getRelativePathsWithStatus(const QString& syncRoot, const QString& status) const {
-    QStringList out;
-    if (connectionName_.isEmpty() || status.isEmpty()) return out;
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral("SELECT relative_path FROM sync_state WHERE sync_root = ? AND status = ?"));
-    q.addBindValue(syncRoot);
-    q.addBindValue(status);
-    if (!q.exec()) return out;
-    while (q.next())
-        out.append(q.value(0).toString().trimmed());
-    return out;
+bool SyncIndex::setPartial(const QString& syncRoot, const QString& relativePath, qint64 offset, qint64 remoteSize) {
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
+    QString rel = normalizeRelativePath(relativePath);
+    return execBound(statement(QStringLiteral(
+                         "UPDATE sync_state SET part_offset = ?, part_remote_size = ?, updated_at = ? WHERE sync_root = ? AND relative_path = ?")),
+                     {offset, remoteSize, QDateTime::currentSecsSinceEpoch(), syncRoot, rel});
+}
+
+QStringList SyncIndex::getRelativePathsWithStatus(const QString& syncRoot, FileStatus status) const {
+    if (connectionName_.isEmpty()) return QStringList();
+    QSqlQuery* q = statement(QStringLiteral("SELECT relative_path FROM sync_state WHERE sync_root = ? AND status = ?"));
+    if (!execBound(q, {syncRoot, static_cast<int>(status)})) return QStringList();
+    return firstColumn(q);
 }
 
 bool SyncIndex::upsertNew(const QString& syncRoot, const QString& relativePath, qint64 mtimeSec, qint64 size) {
-    return set(syncRoot, relativePath, mtimeSec, size, QStringLiteral("NEW"), 0);
+    return set(syncRoot, relativePath, mtimeSec, size, FileStatus::NEW, 0);
+}
+
+bool SyncIndex::insertMissing(const QString& syncRoot, const QVector<SyncIndexRow>& rows, FileStatus status) {
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
+    if (rows.isEmpty()) return true;
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    const int st = static_cast<int>(status);
+    QSqlQuery* q = statement(QStringLiteral(
+            "INSERT OR IGNORE INTO sync_state (sync_root, relative_path, mtime_sec, size, updated_at, status, retries) VALUES (?, ?, ?, ?, ?, ?, 0)"));
+    if (!q) return false;
+    for (const SyncIndexRow& row : rows) {
+        if (!execBound(q, {syncRoot, normalizeRelativePath(row.relativePath), row.mtimeSec, row.size, now, st}))
+            return false;
+    }
+    return true;
 }
 
 bool SyncIndex::remove(const QString& syncRoot, const QString& relativePath) {
-    if (connectionName_.isEmpty()) return false;
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
     QString rel = normalizeRelativePath(relativePath);
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral("DELETE FROM sync_state WHERE sync_root = ? AND relative_path = ?"));
-    q.addBindValue(syncRoot);
-    q.addBindValue(rel);
-    return q.exec();
+    return execBound(statement(QStringLiteral("DELETE FROM sync_state WHERE sync_root = ? AND relative_path = ?")),
+                     {syncRoot, rel});
 }
 
 bool SyncIndex::removePrefix(const QString& syncRoot, const QString& relativePathPrefix) {
-    if (connectionName_.isEmpty()) return false;
+    if (connectionName_.isEmpty() || !beginWrite()) return false;
     QString prefix = normalizeRelativePath(relativePathPrefix);
-    QString likePrefix = prefix.isEmpty() || prefix.endsWith(QLatin1Char('/')) ? prefix : prefix + QLatin1Char('/');
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral("DELETE FROM sync_state WHERE sync_root = ? AND (relative_path = ? OR relative_path LIKE ?)"));
-    q.addBindValue(syncRoot);
-    q.addBindValue(prefix);
-    q.addBindValue(likePrefix + QStringLiteral("%"));
-    return q.exec();
+    if (prefix.isEmpty())
+        return execBound(statement(QStringLiteral("DELETE FROM sync_state WHERE sync_root = ?")), {syncRoot});
+    return execBound(statement(QStringLiteral("DELETE FROM sync_state WHERE sync_root = ? AND ") + underPrefixSql()),
+                     {syncRoot}, underPrefixBinds(prefix));
 }
 
 QStringList SyncIndex::getRelativePathsUnderPrefixExcept(const QString& syncRoot, const QString& prefixToRemove,
@@ -317,64 +449,113 @@ QStringList SyncIndex::getRelativePathsUnderPrefixExcept(const QString& syncRoot
     if (connectionName_.isEmpty()) return out;
     QString prefix = normalizeRelativePath(prefixToRemove);
     if (prefix.isEmpty()) return out;
-    QString likePrefix = prefix + QLatin1Char('/') + QLatin1Char('%');
-    QString sql = QStringLiteral("SELECT relative_path FROM sync_state WHERE sync_root = ? AND (relative_path = ? OR relative_path LIKE ?)");
-    QVector<QString> keepNorm;
+    QString sql = QStringLiteral("SELECT relative_path FROM sync_state WHERE sync_root = ? AND ") + underPrefixSql();
+    QVariantList binds = underPrefixBinds(prefix);
+    int keepCount = 0;
     for (const QString& k : keepPrefixes) {
         QString kn = normalizeRelativePath(k);
-        if (!kn.isEmpty()) keepNorm.append(kn);
+        if (kn.isEmpty()) continue;
+        binds += underPrefixBinds(kn);
+        ++keepCount;
     }
-    if (!keepNorm.isEmpty()) {
+    if (keepCount > 0) {
         sql += QStringLiteral(" AND NOT (");
-        for (int i = 0; i < keepNorm.size(); ++i) {
+        for (int i = 0; i < keepCount; ++i) {
             if (i > 0) sql += QLatin1String(" OR ");
-            sql += QStringLiteral("(relative_path = ? OR relative_path LIKE ?)");
+            sql += underPrefixSql();
         }
         sql += QLatin1Char(')');
     }
-    QSqlQuery q(queryDb());
-    if (!q.prepare(sql)) return out;
-    q.addBindValue(syncRoot);
-    q.addBindValue(prefix);
-    q.addBindValue(likePrefix);
-    for (const QString& kn : keepNorm) {
-        q.addBindValue(kn);
-        q.addBindValue(kn + QLatin1Char('/') + QLatin1Char('%'));
-    }
-    if (!q.exec()) return out;
-    while (q.next())
-        out.append(q.value(0).toString().trimmed());
-    return out;
+    QSqlQuery* q = statement(sql);
+    if (!execBound(q, {syncRoot}, binds)) return out;
+    return firstColumn(q);
 }
 
 QStringList SyncIndex::getTopLevelRelativePaths(const QString& syncRoot) const {
     QStringList out;
     if (connectionName_.isEmpty()) return out;
-    QSqlQuery q(queryDb());
-    q.prepare(QStringLiteral(
+    QSqlQuery* q = statement(QStringLiteral(
             "SELECT DISTINCT CASE WHEN instr(relative_path, '/') > 0 THEN substr(relative_path, 1, instr(relative_path, '/') - 1) ELSE relative_path END FROM sync_state WHERE sync_root = ?"));
-    q.addBindValue(syncRoot);
-    if (!q.exec()) return out;
-    while (q.next()) {
-        QString part = q.value(0).toString().trimmed();
+    if (!execBound(q, {syncRoot})) return out;
+    for (const QString& part : firstColumn(q))
         if (!part.isEmpty()) out.append(part);
-    }
     return out;
 }
 
 bool SyncIndex::beginTransaction() {
     if (connectionName_.isEmpty()) return false;
-    return queryDb().transaction();
+    batching_ = true;
+    grouped_ = false;
+    return true;
+}
+
+bool SyncIndex::beginBatch() {
+    if (!beginTransaction()) return false;
+    grouped_ = true;
+    if (!commitTimer_) {
+        commitTimer_ = std::make_unique<QTimer>();
+        commitTimer_->setSingleShot(true);
+        QObject::connect(commitTimer_.get(), &QTimer::timeout, [this]() {
+            if (grouped_ && writing_ && !commitWrite())
+                ydisquette::logToFile(QStringLiteral("[Sync] index batch commit failed"));
+        });
+    }
+    return true;
+}
+
+bool SyncIndex::beginWrite() {
+    if (!batching_ || writing_) return true;
+    if (!execBound(statement(QStringLiteral("BEGIN IMMEDIATE")), {})) return false;
+    writing_ = true;
+    writeSince_.start();
+    if (grouped_ && commitTimer_)
+        commitTimer_->start(std::max(policy_.maxDelayMs, 0));
+    return true;
+}
+
+bool SyncIndex::commitWrite() {
+    pending_ = 0;
+    savepoint_ = false;
+    if (commitTimer_) commitTimer_->stop();
+    if (!writing_) return true;
+    if (!execBound(statement(QStringLiteral("COMMIT")), {})) return false;
+    writing_ = false;
+    return true;
 }
 
 bool SyncIndex::commit() {
     if (connectionName_.isEmpty()) return false;
-    return queryDb().commit();
+    batching_ = false;
+    grouped_ = false;
+    return commitWrite();
 }
 
 bool SyncIndex::rollback() {
     if (connectionName_.isEmpty()) return false;
-    return queryDb().rollback();
+    const bool keepFlushed = grouped_ && savepoint_;
+    batching_ = false;
+    grouped_ = false;
+    pending_ = 0;
+    savepoint_ = false;
+    if (commitTimer_) commitTimer_->stop();
+    if (!writing_) return true;
+    writing_ = false;
+    if (keepFlushed && execBound(statement(QStringLiteral("ROLLBACK TO SAVEPOINT flushed")), {})
+        && execBound(statement(QStringLiteral("COMMIT")), {}))
+        return true;
+    return execBound(statement(QStringLiteral("ROLLBACK")), {});
+}
+
+bool SyncIndex::flushBatched() {
+    if (connectionName_.isEmpty()) return false;
+    if (!writing_) return true;
+    ++pending_;
+    if (pending_ >= policy_.maxPendingRows || writeSince_.elapsed() >= policy_.maxDelayMs)
+        return commitWrite();
+    if (savepoint_ && !execBound(statement(QStringLiteral("RELEASE SAVEPOINT flushed")), {}))
+        return false;
+    savepoint_ = execBound(statement(QStringLiteral("SAVEPOINT flushed")), {});
+    return savepoint_;
 }
 
 }  // namespace sync
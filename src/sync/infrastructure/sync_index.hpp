@@ -1,8 +1,14 @@
 #pragma once
 
 #include "sync/domain/sync_file_status.hpp"
+#include <QElapsedTimer>
+#include <QHash>
 #include <QString>
+#include <QVector>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTimer>
+#include <memory>
 #include <optional>
 
 namespace ydisquette {
@@ -11,9 +17,22 @@ namespace sync {
 struct SyncIndexEntry {
     qint64 mtime_sec = 0;
     qint64 size = 0;
-    QString status = FileStatus::SYNCED;
+    FileStatus status = FileStatus::SYNCED;
     int retries = 0;
     qint64 updated_at_sec = 0;
+    qint64 part_offset = 0;
+    qint64 part_remote_size = 0;
+};
+
+struct SyncIndexRow {
+    QString relativePath;
+    qint64 mtimeSec = 0;
+    qint64 size = 0;
+};
+
+struct SyncIndexCommitPolicy {
+    int maxPendingRows = 64;
+    int maxDelayMs = 1000;
 };
 
 struct IndexState {
@@ -38,14 +57,16 @@ public:
     std::optional<SyncIndexEntry> get(const QString& syncRoot, const QString& relativePath) const;
     bool hasAnyWithPrefix(const QString& syncRoot, const QString& relativePathPrefix) const;
     bool hasAnyUnderPrefixWithStatus(const QString& syncRoot, const QString& relativePathPrefix,
-                                    const QStringList& statuses) const;
+                                    const QVector<FileStatus>& statuses) const;
     bool set(const QString& syncRoot, const QString& relativePath, qint64 mtimeSec, qint64 size,
-             const QString& status = QString(), int retries = -1);
-    bool setStatus(const QString& syncRoot, const QString& relativePath, const QString& status,
+             FileStatus status = FileStatus::SYNCED, int retries = -1);
+    bool setStatus(const QString& syncRoot, const QString& relativePath, FileStatus status,
                    int retriesDelta = 0);
-    bool setStatusPrefix(const QString& syncRoot, const QString& relativePathPrefix, const QString& status);
-    QStringList getRelativePathsWithStatus(const QString& syncRoot, const QString& status) const;
+    bool setStatusPrefix(const QString& syncRoot, const QString& relativePathPrefix, FileStatus status);
+    bool setPartial(const QString& syncRoot, const QString& relativePath, qint64 offset, qint64 remoteSize);
+    QStringList getRelativePathsWithStatus(const QString& syncRoot, FileStatus status) const;
     bool upsertNew(const QString& syncRoot, const QString& relativePath, qint64 mtimeSec, qint64 size);
+    bool insertMissing(const QString& syncRoot, const QVector<SyncIndexRow>& rows, FileStatus status);
     bool remove(const QString& syncRoot, const QString& relativePath);
     bool removePrefix(const QString& syncRoot, const QString& relativePathPrefix);
 
@@ -55,13 +76,37 @@ public:
     QStringList getTopLevelRelativePaths(const QString& syncRoot) const;
 
     bool beginTransaction();
+    // Like beginTransaction(), for the sync loops: flushBatched() groups completed changes, and the open
+    // write transaction is committed by a timer on this thread's event loop once maxDelayMs has passed,
+    // so the write lock is not held while the loop waits on transfers.
+    bool beginBatch();
     bool commit();
+    // Discards everything since the last commit. In a batch (beginBatch()), changes completed with
+    // flushBatched() and writes already committed by the batch timer are kept.
     bool rollback();
+    bool flushBatched();
+
+    void setCommitPolicy(const SyncIndexCommitPolicy& policy) { policy_ = policy; }
+    static void setDefaultCommitPolicy(const SyncIndexCommitPolicy& policy);
+    static SyncIndexCommitPolicy defaultCommitPolicy();
 
 private:
     QSqlDatabase queryDb() const;
+    QSqlQuery* statement(const QString& sql) const;
+    bool beginWrite();
+    bool commitWrite();
+    bool rejectedTransition(const QString& syncRoot, const QString& relativePath, FileStatus to) const;
 
     QString connectionName_;
+    mutable QHash<QString, QSqlQuery> statements_;
+    SyncIndexCommitPolicy policy_ = defaultCommitPolicy();
+    int pending_ = 0;
+    bool batching_ = false;
+    bool grouped_ = false;
+    bool writing_ = false;
+    bool savepoint_ = false;
+    QElapsedTimer writeSince_;
+    std::unique_ptr<QTimer> commitTimer_;
 };
 
 }  // namespace sync
@@ -9,7 +9,31 @@ void SyncInfrastructureFactory::create(const std::string& accessToken, SyncInfra
     out.apiClient = std::make_unique<auth::YandexDiskApiClient>(
         out.tokenHolder, out.nam.get(), nullptr);
     out.diskClient = std::make_unique<DiskResourceClient>(*out.apiClient);
-    out.treeRepo = std::make_unique<disk_tree::ApiTreeRepository>(*out.apiClient);
+    out.apiTreeRepo = std::make_unique<disk_tree::ApiTreeRepository>(*out.apiClient);
+    out.treeCache = std::make_unique<disk_tree::TreeCacheStore>();
+    out.treeRepo = std::make_unique<disk_tree::CachingTreeRepository>(*out.apiTreeRepo, out.treeCache.get(), 0);
+}
+
+SyncInfrastructure& SyncInfrastructureFactory::ensure(std::unique_ptr<SyncInfrastructure>& infra,
+                                                      const std::string& accessToken,
+                                                      const QString& treeCacheDbPath) {
+    if (!infra) {
+        infra = std::make_unique<SyncInfrastructure>();
+        create(accessToken, *infra);
+    }
+    infra->tokenHolder.token = accessToken;
+    if (!treeCacheDbPath.isEmpty() && !infra->treeCache->isOpen())
+        infra->treeCache->open(treeCacheDbPath);
+    return *infra;
+}
+
+QString SyncInfrastructureFactory::connectionStats(const SyncInfrastructure& infra) {
+    if (!infra.nam) return QString();
+    return QStringLiteral("requests=%1 new_connections=%2 reused_connections=%3 coalesced_listings=%4")
+        .arg(infra.nam->requestCount())
+        .arg(infra.nam->newConnectionCount())
+        .arg(infra.nam->reusedConnectionCount())
+        .arg(infra.apiTreeRepo ? infra.apiTreeRepo->coalescedCount() : 0);
 }
 
 }  // namespace sync
@@ -4,7 +4,10 @@
 #include "auth/infrastructure/ssl_ignoring_network_access_manager.hpp"
 #include "auth/infrastructure/yandex_disk_api_client.hpp"
 #include "disk_tree/infrastructure/api_tree_repository.hpp"
+#include "disk_tree/infrastructure/caching_tree_repository.hpp"
+#include "disk_tree/infrastructure/tree_cache_store.hpp"
 #include "sync/infrastructure/disk_resource_client.hpp"
+#include <QString>
 #include <memory>
 #include <string>
 
@@ -16,11 +19,16 @@ struct SyncInfrastructure {
     std::unique_ptr<auth::SslIgnoringNetworkAccessManager> nam;
     std::unique_ptr<auth::YandexDiskApiClient> apiClient;
     std::unique_ptr<DiskResourceClient> diskClient;
-    std::unique_ptr<disk_tree::ApiTreeRepository> treeRepo;
+    std::unique_ptr<disk_tree::ApiTreeRepository> apiTreeRepo;
+    std::unique_ptr<disk_tree::TreeCacheStore> treeCache;
+    std::unique_ptr<disk_tree::CachingTreeRepository> treeRepo;
 };
 
 struct SyncInfrastructureFactory {
     static void create(const std::string& accessToken, SyncInfrastructure& out);
+    static SyncInfrastructure& ensure(std::unique_ptr<SyncInfrastructure>& infra, const std::string& accessToken,
+                                      const QString& treeCacheDbPath = QString());
+    static QString connectionStats(const SyncInfrastructure& infra);
 };
 
 }  // namespace sync
@@ -59,20 +59,23 @@ void SyncService::startScanPathAndFillIndex(const std::vector<std::string>& sele
 void SyncService::startSync(const std::vector<std::string>& selectedPaths,
                             const std::string& syncPath,
                             const QString& indexDbPath,
-                            int maxRetries) {
+                            int maxRetries,
+                            int maxParallelDownloads) {
     if (status_ == SyncStatus::Syncing) return;
     lastMaxRetries_ = maxRetries;
     status_ = SyncStatus::Syncing;
     emit statusChanged(SyncStatus::Syncing);
     auto token = tokenProvider_.getAccessToken();
     std::string tokenStr = (token && !token->empty()) ? *token : std::string();
-    emit startSyncRequested(selectedPaths, syncPath, tokenStr, indexDbPath, maxRetries);
+    emit startSyncRequested(selectedPaths, syncPath, tokenStr, indexDbPath, maxRetries, maxParallelDownloads);
 }
 
 void SyncService::startSyncLocalToCloud(const std::vector<std::string>& selectedPaths,
                                          const std::string& syncPath,
                                          const QString& indexDbPath,
-                                         int maxRetries) {
+                                         int maxRetries,
+                                         int maxParallelUploads,
+                                         bool directUploads) {
     if (selectedPaths.empty() || syncPath.empty()) return;
     if (status_ == SyncStatus::Syncing) return;
     lastIndexDbPath_ = indexDbPath;
@@ -86,7 +89,8 @@ void SyncService::startSyncLocalToCloud(const std::vector<std::string>& selected
         emit statusChanged(SyncStatus::Idle);
         return;
     }
-    emit startSyncLocalToCloudRequested(selectedPaths, syncPath, tokenStr, indexDbPath, maxRetries);
+    emit startSyncLocalToCloudRequested(selectedPaths, syncPath, tokenStr, indexDbPath, maxRetries, maxParallelUploads,
+                                        directUploads);
 }
 
 void SyncService::startLoadIndexState(const QString& indexDbPath, const QString& syncRoot) {
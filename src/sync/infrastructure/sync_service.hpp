@@ -26,7 +26,8 @@ public:
     void startSync(const std::vector<std::string>& selectedPaths,
                    const std::string& syncPath,
                    const QString& indexDbPath = QString(),
-                   int maxRetries = 3) override;
+                   int maxRetries = 3,
+                   int maxParallelDownloads = 4) override;
     void startScanPathAndFillIndex(const std::vector<std::string>& selectedPaths,
                                    const std::string& syncPath,
                                    const QString& indexDbPath,
@@ -34,7 +35,9 @@ public:
     void startSyncLocalToCloud(const std::vector<std::string>& selectedPaths,
                                const std::string& syncPath,
                                const QString& indexDbPath,
-                               int maxRetries = 3);
+                               int maxRetries = 3,
+                               int maxParallelUploads = 4,
+                               bool directUploads = true);
     void stopSync() override;
     SyncStatus getStatus() const override;
 
@@ -50,12 +53,15 @@ signals:
                             const std::string& syncPath,
                             const std::string& accessToken,
                             const QString& indexDbPath,
-                            int maxRetries);
+                            int maxRetries,
+                            int maxParallelDownloads);
     void startSyncLocalToCloudRequested(const std::vector<std::string>& selectedPaths,
                                         const std::string& syncPath,
                                         const std::string& accessToken,
                                         const QString& indexDbPath,
-                                        int maxRetries);
+                                        int maxRetries,
+                                        int maxParallelUploads,
+                                        bool directUploads);
     void     statusChanged(SyncStatus status);
     void tokenExpired();
     void syncError(QString message);
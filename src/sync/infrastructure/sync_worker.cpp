@@ -2,6 +2,7 @@
 #include "sync/application/scan_and_fill_index_use_case.hpp"
 #include "sync/application/sync_cloud_to_local_use_case.hpp"
 #include "sync/application/sync_local_to_cloud_use_case.hpp"
+#include "sync/application/temp_upload_janitor.hpp"
 #include "auth/infrastructure/yandex_disk_api_client.hpp"
 #include "sync/infrastructure/sync_infrastructure_factory.hpp"
 #include "sync/infrastructure/sync_index.hpp"
@@ -16,24 +17,28 @@
 namespace ydisquette {
 namespace sync {
 
-SyncWorker::SyncWorker(QObject* parent) : QObject(parent) {}
+static QString treeCachePathFor(const QString& indexDbPath) {
+    return indexDbPath.isEmpty() ? QString() : disk_tree::TreeCacheStore::pathNextTo(indexDbPath);
+}
+
+SyncWorker::SyncWorker(QObject* parent) : QObject(parent), cancel_(new auth::CancellationToken(this)) {}
 
 void SyncWorker::requestStop() {
     stopRequested_ = true;
+    cancel_->cancel();
 }
 
 void SyncWorker::doScanPathAndFillIndex(const std::vector<std::string>& selectedPaths, const std::string& syncPath,
                                         const std::string& accessToken, const QString& indexDbPath) {
     stopRequested_ = false;
+    cancel_->reset();
     if (selectedPaths.empty() || syncPath.empty() || indexDbPath.isEmpty() || accessToken.empty()) {
         emit scanCompleted();
         return;
     }
-    SyncInfrastructure infra;
-    SyncInfrastructureFactory::create(accessToken, infra);
-    QUrlQuery probeQuery;
-    probeQuery.addQueryItem(QStringLiteral("path"), QStringLiteral("/"));
-    auth::ApiResponse probe = infra.apiClient->get("/resources", probeQuery);
+    SyncInfrastructure& infra = SyncInfrastructureFactory::ensure(infra_, accessToken, treeCachePathFor(indexDbPath));
+    infra.apiClient->setCancellationToken(cancel_);
+    auth::ApiResponse probe = infra.apiClient->probe();
     if (probe.statusCode == 401) {
         emit tokenExpired();
         emit scanCompleted();
@@ -49,7 +54,7 @@ void SyncWorker::doScanPathAndFillIndex(const std::vector<std::string>& selected
         return;
     }
     auto result = ScanAndFillIndexUseCase::run(
-        *infra.treeRepo, index, syncRoot, selectedPaths,
+        *infra.treeRepo, infra.diskClient.get(), index, syncRoot, selectedPaths,
         [this]() { return stopRequested_.load(); });
     index.close();
     if (result == ScanAndFillIndexUseCase::Result::IndexError)
@@ -58,8 +63,10 @@ void SyncWorker::doScanPathAndFillIndex(const std::vector<std::string>& selected
 }
 
 void SyncWorker::doSync(const std::vector<std::string>& selectedPaths, const std::string& syncPath,
-                        const std::string& accessToken, const QString& indexDbPath, int maxRetries) {
+                        const std::string& accessToken, const QString& indexDbPath, int maxRetries,
+                        int maxParallelDownloads) {
     stopRequested_ = false;
+    cancel_->reset();
     ydisquette::log(ydisquette::LogLevel::Normal, QStringLiteral("[Sync] sync started paths=") + QString::number(selectedPaths.size())
         + QStringLiteral(" syncPath=") + (syncPath.empty() ? QStringLiteral("(empty)") : QString::fromStdString(syncPath)));
 
@@ -86,14 +93,14 @@ void SyncWorker::doSync(const std::vector<std::string>& selectedPaths, const std
     QString indexPath = indexDbPath.isEmpty() ? QString() : QFileInfo(indexDbPath).absoluteFilePath();
     bool useIndex = !indexPath.isEmpty() && index.open(indexPath);
     if (useIndex) {
-        if (!index.beginTransaction()) {
+        if (!index.beginBatch()) {
             useIndex = false;
             index.close();
         } else {
-            QStringList toDownload = index.getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::TO_DOWNLOAD));
-            toDownload.append(index.getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::DOWNLOADING)));
+            QStringList toDownload = index.getRelativePathsWithStatus(syncRoot, FileStatus::TO_DOWNLOAD);
+            toDownload.append(index.getRelativePathsWithStatus(syncRoot, FileStatus::DOWNLOADING));
             toDownload.removeDuplicates();
-            QStringList cloudDeleted = index.getRelativePathsWithStatus(syncRoot, QString::fromUtf8(FileStatus::CLOUD_DELETED));
+            QStringList cloudDeleted = index.getRelativePathsWithStatus(syncRoot, FileStatus::CLOUD_DELETED);
             if (toDownload.isEmpty() && cloudDeleted.isEmpty()) {
                 index.rollback();
                 index.close();
@@ -104,13 +111,11 @@ void SyncWorker::doSync(const std::vector<std::string>& selectedPaths, const std
         }
     }
     if (!indexDbPath.isEmpty() && !useIndex)
-        ydisquette::logToFile(QStringLiteral("[Sync] cloud→local index not used: open or beginTransaction failed ") + indexPath);
+        ydisquette::logToFile(QStringLiteral("[Sync] cloud→local index not used: open or beginBatch failed ") + indexPath);
 
-    SyncInfrastructure infra;
-    SyncInfrastructureFactory::create(accessToken, infra);
-    QUrlQuery probeQuery;
-    probeQuery.addQueryItem(QStringLiteral("path"), QStringLiteral("/"));
-    auth::ApiResponse probe = infra.apiClient->get("/resources", probeQuery);
+    SyncInfrastructure& infra = SyncInfrastructureFactory::ensure(infra_, accessToken, treeCachePathFor(indexDbPath));
+    infra.apiClient->setCancellationToken(cancel_);
+    auth::ApiResponse probe = infra.apiClient->probe();
     if (probe.statusCode == 401) {
         if (useIndex) { index.rollback(); index.close(); }
         emit tokenExpired();
@@ -132,6 +137,7 @@ void SyncWorker::doSync(const std::vector<std::string>& selectedPaths, const std
         localRoot,
         selectedPaths,
         maxRetries,
+        maxParallelDownloads,
         [this]() { return stopRequested_.load(); },
         callbacks);
 
@@ -140,6 +146,7 @@ void SyncWorker::doSync(const std::vector<std::string>& selectedPaths, const std
             index.rollback();
         index.close();
     }
+    ydisquette::logToFile(QStringLiteral("[Sync] cloud→local network ") + SyncInfrastructureFactory::connectionStats(infra));
     emit syncThroughput(0);
     if (result == SyncCloudToLocalUseCase::Result::Error)
         emit statusChanged(SyncStatus::Error);
@@ -148,16 +155,16 @@ void SyncWorker::doSync(const std::vector<std::string>& selectedPaths, const std
 }
 
 void SyncWorker::doSyncLocalToCloud(const std::vector<std::string>& selectedPaths, const std::string& syncPath,
-                                    const std::string& accessToken, const QString& indexDbPath, int maxRetries) {
+                                    const std::string& accessToken, const QString& indexDbPath, int maxRetries,
+                                    int maxParallelUploads, bool directUploads) {
     stopRequested_ = false;
+    cancel_->reset();
     if (selectedPaths.empty() || syncPath.empty() || accessToken.empty()) {
         return;
     }
-    SyncInfrastructure infra;
-    SyncInfrastructureFactory::create(accessToken, infra);
-    QUrlQuery probeQuery;
-    probeQuery.addQueryItem(QStringLiteral("path"), QStringLiteral("/"));
-    auth::ApiResponse probe = infra.apiClient->get("/resources", probeQuery);
+    SyncInfrastructure& infra = SyncInfrastructureFactory::ensure(infra_, accessToken, treeCachePathFor(indexDbPath));
+    infra.apiClient->setCancellationToken(cancel_);
+    auth::ApiResponse probe = infra.apiClient->probe();
     if (probe.statusCode == 401) {
         emit tokenExpired();
         emit syncThroughput(0);
@@ -174,7 +181,7 @@ void SyncWorker::doSyncLocalToCloud(const std::vector<std::string>& selectedPath
     if (!indexDbPath.isEmpty() && !useIndex)
         ydisquette::logToFile(QStringLiteral("[Sync] index open FAIL ") + indexDbPath);
 
-    if (useIndex && !index.beginTransaction()) {
+    if (useIndex && !index.beginBatch()) {
         index.close();
         useIndex = false;
     }
@@ -193,6 +200,8 @@ void SyncWorker::doSyncLocalToCloud(const std::vector<std::string>& selectedPath
         localRoot,
         selectedPaths,
         maxRetries,
+        maxParallelUploads,
+        directUploads,
         [this]() { return stopRequested_.load(); },
         callbacks);
 
@@ -203,6 +212,15 @@ void SyncWorker::doSyncLocalToCloud(const std::vector<std::string>& selectedPath
             index.rollback();
         index.close();
     }
+    if (!directUploads) {
+        if (result == SyncLocalToCloudUseCase::Result::Stopped)
+            tempUploadsSweptRoots_.clear();
+        else if (tempUploadsSweptRoots_ != selectedPaths && !stopRequested_
+                 && TempUploadJanitor::run(*infra.diskClient, selectedPaths,
+                                           [this]() { return stopRequested_.load(); }).complete)
+            tempUploadsSweptRoots_ = selectedPaths;
+    }
+    ydisquette::logToFile(QStringLiteral("[Sync] local→cloud network ") + SyncInfrastructureFactory::connectionStats(infra));
     emit syncThroughput(0);
     if (result == SyncLocalToCloudUseCase::Result::Error)
         emit statusChanged(SyncStatus::Error);
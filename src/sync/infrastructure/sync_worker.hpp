@@ -1,9 +1,12 @@
 #pragma once
 
+#include "auth/infrastructure/cancellation_token.hpp"
 #include "sync/domain/sync_status.hpp"
 #include "sync/infrastructure/sync_index.hpp"
+#include "sync/infrastructure/sync_infrastructure_factory.hpp"
 #include <QObject>
 #include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -19,9 +22,11 @@ public slots:
     void doScanPathAndFillIndex(const std::vector<std::string>& selectedPaths, const std::string& syncPath,
                                 const std::string& accessToken, const QString& indexDbPath);
     void doSync(const std::vector<std::string>& selectedPaths, const std::string& syncPath,
-               const std::string& accessToken, const QString& indexDbPath = QString(), int maxRetries = 3);
+               const std::string& accessToken, const QString& indexDbPath = QString(), int maxRetries = 3,
+               int maxParallelDownloads = 4);
     void doSyncLocalToCloud(const std::vector<std::string>& selectedPaths, const std::string& syncPath,
-                            const std::string& accessToken, const QString& indexDbPath, int maxRetries = 3);
+                            const std::string& accessToken, const QString& indexDbPath, int maxRetries = 3,
+                            int maxParallelUploads = 4, bool directUploads = true);
     void loadIndexState(const QString& indexDbPath, const QString& syncRoot = QString());
     void requestStop();
 
@@ -40,6 +45,9 @@ signals:
 
 private:
     std::atomic<bool> stopRequested_{false};
+    auth::CancellationToken* cancel_;
+    std::vector<std::string> tempUploadsSweptRoots_;
+    std::unique_ptr<SyncInfrastructure> infra_;
 };
 
 }  // namespace sync
@@ -0,0 +1,95 @@
+#include "sync/infrastructure/transfer_pool.hpp"
+#include <QDateTime>
+#include <QEventLoop>
+#include <QTimer>
+#include <memory>
+
+namespace ydisquette {
+namespace sync {
+
+static const int kStopPollIntervalMs = 100;
+
+TransferPool::TransferPool(int maxParallel)
+    : maxParallel_(qBound(1, maxParallel, 64)), prefetchDepth_(maxParallel_) {}
+
+TransferPool::~TransferPool() {
+    pending_.clear();
+}
+
+void TransferPool::enqueue(Job job, Prefetch prefetch) {
+    if (stopping_ || !job) return;
+    if (startedMs_ == 0) startedMs_ = QDateTime::currentMSecsSinceEpoch();
+    pending_.push_back(Pending{std::move(job), std::move(prefetch)});
+    pump();
+}
+
+void TransferPool::pump() {
+    if (pumping_) return;
+    pumping_ = true;
+    while (!stopping_ && inFlight_ < maxParallel_ && !pending_.empty()) {
+        Job job = std::move(pending_.front().job);
+        pending_.pop_front();
+        ++inFlight_;
+        auto called = std::make_shared<bool>(false);
+        job([this, called]() {
+            if (*called) return;
+            *called = true;
+            onJobDone();
+        });
+    }
+    prefetchAhead();
+    pumping_ = false;
+    if (isIdle() && idleLoop_) idleLoop_->quit();
+}
+
+void TransferPool::prefetchAhead() {
+    const int depth = qMin<int>(prefetchDepth_, static_cast<int>(pending_.size()));
+    for (int i = 0; i < depth && !stopping_; ++i) {
+        Prefetch prefetch = std::move(pending_[i].prefetch);
+        pending_[i].prefetch = Prefetch();
+        if (prefetch) prefetch();
+    }
+}
+
+void TransferPool::onJobDone() {
+    --inFlight_;
+    pump();
+}
+
+bool TransferPool::waitForIdle(const std::function<bool()>& stopRequested) {
+    if (stopRequested && stopRequested()) {
+        stopping_ = true;
+        pending_.clear();
+    }
+    if (!isIdle()) {
+        QEventLoop loop;
+        QTimer stopPoll;
+        QObject::connect(&stopPoll, &QTimer::timeout, &loop, [this, &stopRequested]() {
+            if (!stopping_ && stopRequested && stopRequested()) {
+                stopping_ = true;
+                pending_.clear();
+            }
+            if (isIdle() && idleLoop_) idleLoop_->quit();
+        });
+        stopPoll.start(kStopPollIntervalMs);
+        idleLoop_ = &loop;
+        loop.exec();
+        idleLoop_ = nullptr;
+    }
+    const bool stopped = stopping_;
+    stopping_ = false;
+    return !stopped;
+}
+
+void TransferPool::recordTransferred(qint64 bytes) {
+    transferredBytes_ += bytes;
+}
+
+qint64 TransferPool::bytesPerSecond() const {
+    if (startedMs_ == 0) return 0;
+    const qint64 elapsed = qMax(qint64(1), QDateTime::currentMSecsSinceEpoch() - startedMs_);
+    return transferredBytes_ * 1000 / elapsed;
+}
+
+}  // namespace sync
+}  // namespace ydisquette
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QtGlobal>
+#include <deque>
+#include <functional>
+
+class QEventLoop;
+
+namespace ydisquette {
+namespace sync {
+
+class TransferPool {
+public:
+    using Done = std::function<void()>;
+    using Job = std::function<void(Done done)>;
+    using Prefetch = std::function<void()>;
+
+    explicit TransferPool(int maxParallel);
+    ~TransferPool();
+
+    void enqueue(Job job, Prefetch prefetch = Prefetch());
+    void setPrefetchDepth(int depth) { prefetchDepth_ = qMax(0, depth); }
+    bool waitForIdle(const std::function<bool()>& stopRequested);
+    void recordTransferred(qint64 bytes);
+    qint64 bytesPerSecond() const;
+    int maxParallel() const { return maxParallel_; }
+    bool isIdle() const { return inFlight_ == 0 && pending_.empty(); }
+
+private:
+    struct Pending {
+        Job job;
+        Prefetch prefetch;
+    };
+
+    void pump();
+    void prefetchAhead();
+    void onJobDone();
+
+    int maxParallel_;
+    int prefetchDepth_;
+    int inFlight_ = 0;
+    bool pumping_ = false;
+    bool stopping_ = false;
+    std::deque<Pending> pending_;
+    QEventLoop* idleLoop_ = nullptr;
+    qint64 startedMs_ = 0;
+    qint64 transferredBytes_ = 0;
+};
+
+}  // namespace sync
+}  // namespace ydisquette
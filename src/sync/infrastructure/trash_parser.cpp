@@ -1,36 +1,77 @@
 #include "sync/infrastructure/trash_parser.hpp"
 #include "shared/cloud_path_util.hpp"
+#include "shared/json_reader.hpp"
 #include "sync/domain/cloud_datetime.hpp"
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
 
 namespace ydisquette {
 namespace sync {
 
-QVector<TrashItem> parseTrashJson(const std::string& body) {
-    QVector<TrashItem> out;
-    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body));
-    if (!doc.isObject()) return out;
-    QJsonObject root = doc.object();
-    QJsonArray items = root.value(QStringLiteral("_embedded")).toObject().value(QStringLiteral("items")).toArray();
-    if (items.isEmpty())
-        items = root.value(QStringLiteral("items")).toArray();
-    for (const QJsonValue& v : items) {
-        QJsonObject o = v.toObject();
-        QString path = o.value(QStringLiteral("path")).toString();
-        QString originPath = o.value(QStringLiteral("origin_path")).toString();
-        QString deletedStr = o.value(QStringLiteral("deleted")).toString();
-        if (deletedStr.isEmpty()) deletedStr = o.value(QStringLiteral("modified")).toString();
-        QString type = o.value(QStringLiteral("type")).toString();
-        if (originPath.isEmpty()) continue;
+namespace {
+
+int readTrashItems(JsonReader& r, QVector<TrashItem>& out) {
+    int count = 0;
+    std::string_view key;
+    std::string originPath, deleted, modified, type;
+    r.beginArray();
+    while (r.nextElement()) {
+        ++count;
+        if (!r.isObject()) {
+            r.skipValue();
+            continue;
+        }
+        originPath.clear();
+        deleted.clear();
+        modified.clear();
+        type.clear();
+        r.beginObject();
+        while (r.nextKey(key)) {
+            if (key == "origin_path")
+                r.readString(originPath);
+            else if (key == "deleted")
+                r.readString(deleted);
+            else if (key == "modified")
+                r.readString(modified);
+            else if (key == "type")
+                r.readString(type);
+            else
+                r.skipValue();
+        }
+        if (originPath.empty()) continue;
         TrashItem item;
-        item.originPath = originPath;
-        item.deletedSec = parseCloudModifiedToSec(deletedStr.toStdString());
-        item.type = type;
+        item.originPath = QString::fromStdString(originPath);
+        item.deletedSec = parseCloudModifiedToSec(deleted.empty() ? modified : deleted);
+        item.type = QString::fromStdString(type);
         out.append(item);
     }
-    return out;
+    return count;
+}
+
+}  // namespace
+
+QVector<TrashItem> parseTrashJson(std::string_view body) {
+    QVector<TrashItem> embedded;
+    QVector<TrashItem> plain;
+    int embeddedCount = 0;
+    JsonReader r(body);
+    std::string_view key;
+    if (!r.beginObject()) return {};
+    while (r.nextKey(key)) {
+        if (key == "_embedded" && r.isObject()) {
+            r.beginObject();
+            while (r.nextKey(key)) {
+                if (key == "items" && r.isArray())
+                    embeddedCount = readTrashItems(r, embedded);
+                else
+                    r.skipValue();
+            }
+        } else if (key == "items" && r.isArray()) {
+            readTrashItems(r, plain);
+        } else {
+            r.skipValue();
+        }
+    }
+    if (!r.atEnd()) return {};
+    return embeddedCount > 0 ? embedded : plain;
 }
 
 }  // namespace sync
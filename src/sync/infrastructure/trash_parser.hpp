@@ -3,11 +3,12 @@
 #include "sync/domain/trash_item.hpp"
 #include <QVector>
 #include <string>
+#include <string_view>
 
 namespace ydisquette {
 namespace sync {
 
-QVector<TrashItem> parseTrashJson(const std::string& body);
+QVector<TrashItem> parseTrashJson(std::string_view body);
 
 }  // namespace sync
 }  // namespace ydisquette
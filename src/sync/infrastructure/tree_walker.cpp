@@ -0,0 +1,137 @@
+#include "sync/infrastructure/tree_walker.hpp"
+#include <QEventLoop>
+#include <QTimer>
+
+namespace ydisquette {
+namespace sync {
+
+const int TreeWalker::kDefaultMaxInFlight = 4;
+static const int kStopPollIntervalMs = 100;
+
+TreeWalker::TreeWalker(disk_tree::ITreeRepository& repo, int maxInFlight)
+    : repo_(repo), maxInFlight_(qBound(1, maxInFlight, 32)), alive_(std::make_shared<bool>(true)) {}
+
+void TreeWalker::add(const std::string& path) {
+    addAfter(path, Step());
+}
+
+void TreeWalker::addAfter(const std::string& path, Step step) {
+    if (aborted_) return;
+    pending_.push_back({path, std::move(step)});
+    if (visit_) pump();
+}
+
+void TreeWalker::pump() {
+    if (pumping_) return;
+    pumping_ = true;
+    while (!aborted_ && inFlight_ < maxInFlight_ && !pending_.empty()) {
+        if (stopRequested_ && stopRequested_()) {
+            abort();
+            break;
+        }
+        Pending next = std::move(pending_.front());
+        pending_.pop_front();
+        ++inFlight_;
+        if (!next.before) {
+            list(next.path);
+            continue;
+        }
+        std::weak_ptr<bool> alive = alive_;
+        const std::string path = next.path;
+        next.before([this, alive, path](bool proceed) {
+            if (alive.expired()) return;
+            --inFlight_;
+            if (proceed && !aborted_) pending_.push_front({path, Step()});
+            pump();
+        });
+    }
+    pumping_ = false;
+    quitIfDone();
+}
+
+void TreeWalker::list(const std::string& path) {
+    auto listing = std::make_shared<Listing>();
+    listing->path = path;
+    std::weak_ptr<bool> alive = alive_;
+    repo_.getChildrenPagedAsync(path, [this, alive, listing](disk_tree::ChildrenPage page) {
+        if (alive.expired()) return;
+        if (descendIntoDirs_ && !aborted_) {
+            for (disk_tree::NodeRef node : page.items)
+                if (node.isDir()) pending_.push_back({node.path(), Step()});
+        }
+        if (listing->children.empty())
+            listing->children = std::move(page.items);
+        else
+            listing->children.append(page.items);
+        if (!page.last) {
+            pump();
+            return;
+        }
+        listing->ok = page.ok;
+        --inFlight_;
+        onListed(std::move(*listing));
+    });
+}
+
+void TreeWalker::onListed(Listing listing) {
+    ++listed_;
+    if (!aborted_) ready_.push_back(std::move(listing));
+    drain();
+    pump();
+}
+
+void TreeWalker::drain() {
+    if (visiting_) return;
+    visiting_ = true;
+    while (!aborted_ && !ready_.empty()) {
+        Listing listing = std::move(ready_.front());
+        ready_.pop_front();
+        if (!visit_(listing.path, listing.children, listing.ok))
+            abort();
+    }
+    visiting_ = false;
+    quitIfDone();
+}
+
+void TreeWalker::abort() {
+    aborted_ = true;
+    pending_.clear();
+    ready_.clear();
+}
+
+bool TreeWalker::isDone() const {
+    if (visiting_ || inFlight_ > 0) return false;
+    return aborted_ || (pending_.empty() && ready_.empty());
+}
+
+void TreeWalker::quitIfDone() {
+    if (loop_ && isDone()) loop_->quit();
+}
+
+bool TreeWalker::run(Visitor visit, const std::function<bool()>& stopRequested) {
+    if (stopRequested && stopRequested()) return false;
+    visit_ = std::move(visit);
+    stopRequested_ = stopRequested;
+    aborted_ = false;
+    pump();
+    if (!isDone()) {
+        QEventLoop loop;
+        QTimer stopPoll;
+        QObject::connect(&stopPoll, &QTimer::timeout, &loop, [this]() {
+            if (!aborted_ && stopRequested_ && stopRequested_()) abort();
+            quitIfDone();
+        });
+        stopPoll.start(kStopPollIntervalMs);
+        loop_ = &loop;
+        loop.exec();
+        loop_ = nullptr;
+    }
+    visit_ = Visitor();
+    stopRequested_ = std::function<bool()>();
+    const bool completed = !aborted_;
+    if (stopRequested && stopRequested()) return false;
+    return completed;
+}
+
+}  // namespace sync
+}  // namespace ydisquette
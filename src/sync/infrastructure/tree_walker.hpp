@@ -0,0 +1,70 @@
+#pragma once
+
+#include <disk_tree/application/itree_repository.hpp>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+class QEventLoop;
+
+namespace ydisquette {
+namespace sync {
+
+class TreeWalker {
+public:
+    using Children = disk_tree::NodeList;
+    using Visitor = std::function<bool(const std::string& path, const Children& children, bool ok)>;
+    using Step = std::function<void(std::function<void(bool proceed)> done)>;
+
+    explicit TreeWalker(disk_tree::ITreeRepository& repo, int maxInFlight = kDefaultMaxInFlight);
+
+    void add(const std::string& path);
+    // Runs the async step in one of the in-flight slots and lists the path only if it reports proceed.
+    void addAfter(const std::string& path, Step step);
+    void setDescendIntoDirs(bool descend) { descendIntoDirs_ = descend; }
+    bool run(Visitor visit, const std::function<bool()>& stopRequested);
+    int listedCount() const { return listed_; }
+    int maxInFlight() const { return maxInFlight_; }
+
+    static const int kDefaultMaxInFlight;
+
+private:
+    struct Pending {
+        std::string path;
+        Step before;
+    };
+
+    struct Listing {
+        std::string path;
+        Children children;
+        bool ok = true;
+    };
+
+    void pump();
+    void list(const std::string& path);
+    void drain();
+    void onListed(Listing listing);
+    void abort();
+    bool isDone() const;
+    void quitIfDone();
+
+    disk_tree::ITreeRepository& repo_;
+    int maxInFlight_;
+    bool descendIntoDirs_ = true;
+    int inFlight_ = 0;
+    int listed_ = 0;
+    bool pumping_ = false;
+    bool visiting_ = false;
+    bool aborted_ = false;
+    std::shared_ptr<bool> alive_;
+    std::deque<Pending> pending_;
+    std::deque<Listing> ready_;
+    Visitor visit_;
+    std::function<bool()> stopRequested_;
+    QEventLoop* loop_ = nullptr;
+};
+
+}  // namespace sync
+}  // namespace ydisquette
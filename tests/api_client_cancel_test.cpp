@@ -0,0 +1,119 @@
+#include <catch2/catch_test_macros.hpp>
+#include "auth/infrastructure/cancellation_token.hpp"
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QEventLoop>
+#include <QNetworkAccessManager>
+#include <QTemporaryDir>
+#include <QTimer>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+}  // namespace
+
+TEST_CASE("Cancelling the token aborts an in-flight download") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QByteArray data(4 * 1024 * 1024, 'x');
+    test::LocalHttpServer server([&data](const test::LocalHttpServer::Request& req) {
+        return test::LocalHttpServer::serveBytes(data, req);
+    }, 256 * 1024);
+    REQUIRE(server.isListening());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    auth::CancellationToken token;
+    api.setCancellationToken(&token);
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QTimer::singleShot(100, &token, &auth::CancellationToken::cancel);
+    auth::ApiResponse res = api.downloadToFile(server.baseUrl() + QStringLiteral("/file"),
+                                               dir.filePath(QStringLiteral("out.bin")));
+    REQUIRE_FALSE(res.ok());
+    REQUIRE(token.isCancelled());
+    REQUIRE(elapsed.elapsed() < 5000);
+}
+
+TEST_CASE("An interrupted download leaves the existing target untouched") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QByteArray data(4 * 1024 * 1024, 'x');
+    test::LocalHttpServer server([&data](const test::LocalHttpServer::Request& req) {
+        return test::LocalHttpServer::serveBytes(data, req);
+    }, 256 * 1024);
+    REQUIRE(server.isListening());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString localPath = dir.filePath(QStringLiteral("out.bin"));
+    {
+        QFile existing(localPath);
+        REQUIRE(existing.open(QIODevice::WriteOnly));
+        existing.write("previous contents");
+    }
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    auth::CancellationToken token;
+    api.setCancellationToken(&token);
+
+    QTimer::singleShot(100, &token, &auth::CancellationToken::cancel);
+    REQUIRE_FALSE(api.downloadToFile(server.baseUrl() + QStringLiteral("/file"), localPath).ok());
+    QFile target(localPath);
+    REQUIRE(target.open(QIODevice::ReadOnly));
+    REQUIRE(target.readAll() == QByteArray("previous contents"));
+    REQUIRE_FALSE(QFile::exists(localPath + QLatin1String(auth::YandexDiskApiClient::kTempDownloadSuffix)));
+
+    token.reset();
+    test::LocalHttpServer fast([&data](const test::LocalHttpServer::Request& req) {
+        return test::LocalHttpServer::serveBytes(data, req);
+    });
+    REQUIRE(api.downloadToFile(fast.baseUrl() + QStringLiteral("/file"), localPath).ok());
+    REQUIRE(QFileInfo(localPath).size() == data.size());
+}
+
+TEST_CASE("Requests issued after cancellation fail without blocking") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    test::LocalHttpServer server([](const test::LocalHttpServer::Request&) {
+        test::LocalHttpServer::Response r;
+        r.body = "{}";
+        return r;
+    });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    auth::CancellationToken token;
+    api.setCancellationToken(&token);
+
+    REQUIRE(api.getByFullUrl(server.baseUrl() + QStringLiteral("/ok")).ok());
+    token.cancel();
+    int completed = 0;
+    QEventLoop loop;
+    for (int i = 0; i < 3; ++i) {
+        api.getByFullUrlAsync(server.baseUrl() + QStringLiteral("/ok"), [&](auth::ApiResponse res) {
+            REQUIRE(res.statusCode == 0);
+            if (++completed == 3) loop.quit();
+        });
+    }
+    loop.exec();
+    REQUIRE(completed == 3);
+    token.reset();
+    REQUIRE(api.getByFullUrl(server.baseUrl() + QStringLiteral("/ok")).ok());
+}
@@ -64,3 +64,10 @@ TEST_CASE("parseResourcesJson returns empty on 500-style body") {
     auto nodes = parseResourcesJson(R"({"error": "Internal Server Error"})");
     REQUIRE(nodes.empty());
 }
+
+TEST_CASE("parseResourcesPageJson reads _embedded.total") {
+    auto page = parseResourcesPageJson(R"({"_embedded": {"items": [{"type": "dir", "path": "/a", "name": "a"}], "total": 2500}})");
+    REQUIRE(page.items.size() == 1);
+    REQUIRE(page.total == 2500);
+    REQUIRE(parseResourcesPageJson(R"({"_embedded": {"items": []}})").total == -1);
+}
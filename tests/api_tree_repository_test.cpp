@@ -0,0 +1,137 @@
+#include <catch2/catch_test_macros.hpp>
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "disk_tree/infrastructure/api_tree_repository.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QNetworkAccessManager>
+#include <QUrl>
+#include <QUrlQuery>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+test::LocalHttpServer::Response listingPage(const test::LocalHttpServer::Request& req, int total, int failAtOffset = -1) {
+    const QUrlQuery q(QUrl(QString::fromUtf8(req.target)));
+    const int limit = q.queryItemValue(QStringLiteral("limit")).toInt();
+    const int offset = q.queryItemValue(QStringLiteral("offset")).toInt();
+    test::LocalHttpServer::Response r;
+    if (offset == failAtOffset) {
+        r.status = 503;
+        r.body = R"({"error":"unavailable"})";
+        return r;
+    }
+    QByteArray items;
+    for (int i = offset; i < qMin(offset + limit, total); ++i) {
+        if (!items.isEmpty()) items += ',';
+        const QByteArray name = "f" + QByteArray::number(i);
+        items += R"({"type":"file","path":"disk:/big/)" + name + R"(","name":")" + name + R"(","size":1})";
+    }
+    r.body = R"({"_embedded":{"items":[)" + items + R"(],"limit":)" + QByteArray::number(limit)
+             + R"(,"offset":)" + QByteArray::number(offset) + R"(,"total":)" + QByteArray::number(total) + "}}";
+    return r;
+}
+
+}  // namespace
+
+TEST_CASE("ApiTreeRepository follows offset past the first page") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    test::LocalHttpServer server([](const test::LocalHttpServer::Request& req) { return listingPage(req, 5); });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+    disk_tree::ApiTreeRepository repo(api, 2);
+
+    auto children = repo.getChildren("/big");
+    REQUIRE(children.size() == 5);
+    for (int i = 0; i < 5; ++i)
+        REQUIRE(children[i].name() == "f" + std::to_string(i));
+    REQUIRE(server.requestCount() == 3);
+}
+
+TEST_CASE("ApiTreeRepository streams pages and marks only the final one last") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    test::LocalHttpServer server([](const test::LocalHttpServer::Request& req) { return listingPage(req, 4); });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+    disk_tree::ApiTreeRepository repo(api, 2);
+
+    std::vector<disk_tree::ChildrenPage> pages;
+    QEventLoop loop;
+    repo.getChildrenPagedAsync("/big", [&](disk_tree::ChildrenPage page) {
+        pages.push_back(page);
+        if (page.last) loop.quit();
+    });
+    loop.exec();
+    REQUIRE(pages.size() == 2);
+    REQUIRE(pages[0].items.size() == 2);
+    REQUIRE_FALSE(pages[0].last);
+    REQUIRE(pages[1].items.size() == 2);
+    REQUIRE(pages[1].last);
+    REQUIRE(pages[1].ok);
+    REQUIRE(server.requestCount() == 2);
+}
+
+TEST_CASE("ApiTreeRepository returns nothing when a later page fails") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    test::LocalHttpServer server([](const test::LocalHttpServer::Request& req) { return listingPage(req, 5, 4); });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+    disk_tree::ApiTreeRepository repo(api, 2);
+
+    REQUIRE(repo.getChildren("/big").empty());
+}
+
+TEST_CASE("ApiTreeRepository coalesces concurrent listings of one folder") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    test::LocalHttpServer server([](const test::LocalHttpServer::Request& req) { return listingPage(req, 5); });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+    disk_tree::ApiTreeRepository repo(api, 2);
+
+    std::vector<size_t> sizes;
+    QEventLoop loop;
+    auto collect = [&](disk_tree::NodeList children) {
+        sizes.push_back(children.size());
+        if (sizes.size() == 3) loop.quit();
+    };
+    bool joined = false;
+    repo.getChildrenAsync("/big", collect);
+    repo.getChildrenAsync("disk:/big", collect);
+    repo.getChildrenPagedAsync("/big", [&](disk_tree::ChildrenPage) {
+        if (joined) return;
+        joined = true;
+        repo.getChildrenAsync("/big", collect);
+    });
+    loop.exec();
+    REQUIRE(sizes == std::vector<size_t>{5, 5, 5});
+    REQUIRE(server.requestCount() == 3);
+    REQUIRE(repo.coalescedCount() == 3);
+
+    REQUIRE(repo.getChildren("/big").size() == 5);
+    REQUIRE(server.requestCount() == 6);
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "shared/iso_datetime.hpp"
+#include "sync/domain/cloud_datetime.hpp"
+#include <string>
+#include <vector>
+
+using namespace ydisquette;
+
+namespace {
+
+qint64 viaQDateTime(const std::string& s) {
+    QDateTime dt = sync::parseCloudModified(s);
+    return dt.isValid() ? dt.toSecsSinceEpoch() : 0;
+}
+
+std::vector<std::string> sampleTimestamps(int count) {
+    std::vector<std::string> out;
+    out.reserve(count);
+    const QDateTime base = QDateTime::fromSecsSinceEpoch(1600000000).toUTC();
+    for (int i = 0; i < count; ++i)
+        out.push_back(base.addSecs(static_cast<qint64>(i) * 7919).toString(Qt::ISODate).toStdString());
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("parseIsoDateTimeToSec matches the QDateTime parser") {
+    const std::vector<std::string> inputs = {
+        "2024-01-15T12:00:00+00:00", "2024-01-15T12:00:01Z",     "2024-01-15T12:00:00",
+        "2024-01-15T15:00:00+03:00", "2023-06-30T23:30:00-05:30", "2024-02-29T00:00:00Z",
+        "2000-03-01T00:00:00Z",      " 2024-01-15T12:00:00Z ",    "2024-01-15T12:00:00.250+00:00",
+        "1970-01-01T00:00:00Z",      "2100-12-31T23:59:59+00:00",
+    };
+    for (const std::string& s : inputs) {
+        INFO(s);
+        REQUIRE(parseIsoDateTimeToSec(s) == viaQDateTime(s));
+    }
+    for (const std::string& s : sampleTimestamps(2000))
+        REQUIRE(parseIsoDateTimeToSec(s) == viaQDateTime(s));
+}
+
+TEST_CASE("parseIsoDateTimeToSec returns 0 for malformed timestamps") {
+    REQUIRE(parseIsoDateTimeToSec("") == 0);
+    REQUIRE(parseIsoDateTimeToSec("yesterday") == 0);
+    REQUIRE(parseIsoDateTimeToSec("2024-02-30T00:00:00Z") == 0);
+    REQUIRE(parseIsoDateTimeToSec("2023-02-29T00:00:00Z") == 0);
+    REQUIRE(parseIsoDateTimeToSec("2024-13-01T00:00:00Z") == 0);
+    REQUIRE(parseIsoDateTimeToSec("2024-01-01T00:00:00+0a:00") == 0);
+    REQUIRE(parseIsoDateTimeToSec("2024-01-01T00:00:00 trailing") == 0);
+    REQUIRE(sync::parseCloudModifiedToSec("2024-01-15T12:00:00+00:00") == 1705320000);
+}
+
+TEST_CASE("Cloud timestamp parsing", "[.][benchmark]") {
+    const std::vector<std::string> stamps = sampleTimestamps(10000);
+
+    BENCHMARK("QDateTime::fromString") {
+        qint64 total = 0;
+        for (const std::string& s : stamps) total += viaQDateTime(s);
+        return total;
+    };
+    BENCHMARK("parseIsoDateTimeToSec") {
+        int64_t total = 0;
+        for (const std::string& s : stamps) total += parseIsoDateTimeToSec(s);
+        return total;
+    };
+}
@@ -0,0 +1,41 @@
+#include <catch2/catch_test_macros.hpp>
+#include "auth/infrastructure/ssl_ignoring_network_access_manager.hpp"
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+}  // namespace
+
+TEST_CASE("Sequential requests through one network manager reuse a single connection") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    test::LocalHttpServer server([](const test::LocalHttpServer::Request&) {
+        test::LocalHttpServer::Response r;
+        r.body = "{}";
+        return r;
+    });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    auth::SslIgnoringNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    const int kRequests = 5;
+    for (int i = 0; i < kRequests; ++i)
+        REQUIRE(api.getByFullUrl(server.baseUrl() + QStringLiteral("/resources")).statusCode == 200);
+
+    REQUIRE(server.requestCount() == kRequests);
+    REQUIRE(server.connectionCount() == 1);
+    REQUIRE(nam.requestCount() == kRequests);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    REQUIRE(nam.newConnectionCount() == 1);
+    REQUIRE(nam.reusedConnectionCount() == kRequests - 1);
+#endif
+}
@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <disk_tree/domain/node.hpp>
 #include <disk_tree/domain/quota.hpp>
+#include <sync/domain/sync_file_status.hpp>
 #include <sync/domain/sync_status.hpp>
 #include <settings/domain/app_settings.hpp>
 
@@ -42,6 +43,35 @@ TEST_CASE("SyncStatus is enum") {
     REQUIRE(static_cast<int>(sync::SyncStatus::Idle) != static_cast<int>(sync::SyncStatus::Syncing));
 }
 
+TEST_CASE("FileStatus codes, names and transitions") {
+    using sync::FileStatus;
+    static_assert(sync::fileStatusFromName("CLOUD_DELETED") == FileStatus::CLOUD_DELETED);
+    static_assert(sync::needsDownload(FileStatus::DOWNLOADING) && !sync::needsUpload(FileStatus::DOWNLOADING));
+    for (int code = 0; code < sync::kFileStatusCount; ++code) {
+        const FileStatus s = sync::fileStatusFromCode(code);
+        REQUIRE(static_cast<int>(s) == code);
+        REQUIRE(sync::fileStatusFromName(sync::fileStatusName(s)) == s);
+        REQUIRE(sync::canTransition(s, FileStatus::SYNCED));
+        REQUIRE(sync::canTransition(s, FileStatus::NEW));
+        REQUIRE(sync::canTransition(s, FileStatus::FAILED));
+        REQUIRE(sync::canTransition(s, FileStatus::TO_DELETE));
+        REQUIRE(sync::canTransition(s, FileStatus::CLOUD_DELETED));
+    }
+    REQUIRE(sync::fileStatusFromCode(42) == FileStatus::SYNCED);
+    REQUIRE_FALSE(sync::fileStatusFromName("SYNCING").has_value());
+    REQUIRE(sync::canTransition(FileStatus::NEW, FileStatus::DOWNLOADING));
+    REQUIRE(sync::canTransition(FileStatus::SYNCED, FileStatus::UPLOADING));
+    REQUIRE(sync::canTransition(FileStatus::TO_DOWNLOAD, FileStatus::UPLOADING));
+    REQUIRE(sync::canTransition(FileStatus::DOWNLOADING, FileStatus::TO_DOWNLOAD));
+    REQUIRE(sync::canTransition(FileStatus::CLOUD_DELETED, FileStatus::DOWNLOADING));
+    REQUIRE_FALSE(sync::canTransition(FileStatus::TO_DELETE, FileStatus::DOWNLOADING));
+    REQUIRE_FALSE(sync::canTransition(FileStatus::TO_DELETE, FileStatus::UPLOADING));
+    REQUIRE_FALSE(sync::canTransition(FileStatus::CLOUD_DELETED, FileStatus::UPLOADING));
+    REQUIRE_FALSE(sync::canTransition(FileStatus::UPLOADING, FileStatus::TO_DOWNLOAD));
+    REQUIRE_FALSE(sync::isRestrictedTarget(FileStatus::SYNCED));
+    REQUIRE(sync::isRestrictedTarget(FileStatus::DOWNLOADING));
+}
+
 TEST_CASE("AppSettings default") {
     settings::AppSettings s;
     REQUIRE(s.syncPath.empty());
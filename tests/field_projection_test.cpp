@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "disk_tree/infrastructure/api_tree_repository.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QUrl>
+#include <QUrlQuery>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+const int kFolderSize = 10000;
+
+QByteArray fullItem(int i) {
+    const QByteArray n = QByteArray::number(i);
+    return R"({"antivirus_status":"clean","size":)" + QByteArray::number(1000 + i)
+        + R"(,"comment_ids":{"private_resource":"1:)" + n + R"(","public_resource":"1:)" + n + R"("},)"
+        + R"("name":"photo_)" + n + R"(.jpg","exif":{"date_time":"2024-01-15T12:00:00+00:00","gps_longitude":37.6,"gps_latitude":55.7},)"
+        + R"("created":"2024-01-15T12:00:00+00:00","resource_id":"1:0123456789abcdef)" + n + R"(",)"
+        + R"("modified":"2024-01-15T12:00:00+00:00","mime_type":"image/jpeg",)"
+        + R"("preview":"https://downloader.disk.yandex.ru/preview/0123456789abcdef0123456789abcdef)" + n
+        + R"(?uid=1&filename=photo_)" + n + R"(.jpg&disposition=inline&hash=&limit=0&content_type=image%2Fjpeg&tknv=v2&size=S&crop=0",)"
+        + R"("file":"https://downloader.disk.yandex.ru/disk/0123456789abcdef0123456789abcdef)" + n
+        + R"(?uid=1&filename=photo_)" + n + R"(.jpg&disposition=attachment&hash=&limit=0&content_type=image%2Fjpeg&tknv=v2",)"
+        + R"("media_type":"image","path":"disk:/Photos/photo_)" + n + R"(.jpg","sha256":"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef",)"
+        + R"("type":"file","md5":"0123456789abcdef0123456789abcdef","revision":1705320000)" + n + "}";
+}
+
+QByteArray projectedItem(int i) {
+    const QByteArray n = QByteArray::number(i);
+    return R"({"type":"file","path":"disk:/Photos/photo_)" + n + R"(.jpg","name":"photo_)" + n
+        + R"(.jpg","modified":"2024-01-15T12:00:00+00:00","size":)" + QByteArray::number(1000 + i) + "}";
+}
+
+test::LocalHttpServer::Response syntheticFolder(const test::LocalHttpServer::Request& req) {
+    const QUrlQuery q(QUrl(QString::fromUtf8(req.target)));
+    const bool projected = q.hasQueryItem(QStringLiteral("fields"));
+    const int limit = q.hasQueryItem(QStringLiteral("limit")) ? q.queryItemValue(QStringLiteral("limit")).toInt() : 20;
+    const int offset = q.queryItemValue(QStringLiteral("offset")).toInt();
+    QByteArray items;
+    for (int i = offset; i < qMin(offset + limit, kFolderSize); ++i) {
+        if (!items.isEmpty()) items += ',';
+        items += projected ? projectedItem(i) : fullItem(i);
+    }
+    test::LocalHttpServer::Response r;
+    r.body = R"({"_embedded":{"items":[)" + items + R"(],"total":)" + QByteArray::number(kFolderSize) + "}}";
+    if (req.header("Accept-Encoding").contains("deflate")) {
+        r.body = test::LocalHttpServer::deflate(r.body);
+        r.headers.append({"Content-Encoding", "deflate"});
+    }
+    return r;
+}
+
+}  // namespace
+
+TEST_CASE("Listing requests project fields and accept compressed responses") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    QByteArray seenFields;
+    QByteArray seenEncoding;
+    test::LocalHttpServer server([&](const test::LocalHttpServer::Request& req) {
+        seenFields = QUrlQuery(QUrl(QString::fromUtf8(req.target))).queryItemValue(QStringLiteral("fields")).toUtf8();
+        seenEncoding = req.header("Accept-Encoding");
+        return syntheticFolder(req);
+    });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+    disk_tree::ApiTreeRepository repo(api, 5000);
+
+    auto children = repo.getChildren("/Photos");
+    REQUIRE(children.size() == kFolderSize);
+    REQUIRE(children[children.size() - 1].name() == "photo_9999.jpg");
+    REQUIRE(children[children.size() - 1].size() == 1000 + kFolderSize - 1);
+    REQUIRE(seenFields == auth::YandexDiskApiClient::kListingFields);
+    REQUIRE(seenEncoding.contains("deflate"));
+}
+
+TEST_CASE("Response bytes for a 10k-item folder: full vs projected vs compressed") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    bool compress = false;
+    test::LocalHttpServer server([&](const test::LocalHttpServer::Request& req) {
+        test::LocalHttpServer::Request r = req;
+        if (!compress) r.headers.clear();
+        return syntheticFolder(r);
+    });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+
+    QUrlQuery full;
+    full.addQueryItem(QStringLiteral("path"), QStringLiteral("/Photos"));
+    full.addQueryItem(QStringLiteral("limit"), QString::number(kFolderSize));
+    QUrlQuery projected = full;
+    auth::YandexDiskApiClient::project(projected, auth::YandexDiskApiClient::kListingFields);
+
+    REQUIRE(api.get("/resources", full).ok());
+    const qint64 fullBytes = server.bodyBytesSent();
+    REQUIRE(api.get("/resources", projected).ok());
+    const qint64 projectedBytes = server.bodyBytesSent() - fullBytes;
+    compress = true;
+    auth::ApiResponse res = api.get("/resources", projected);
+    REQUIRE(res.ok());
+    const qint64 compressedBytes = server.bodyBytesSent() - fullBytes - projectedBytes;
+
+    INFO("full=" << fullBytes << " projected=" << projectedBytes << " projected+deflate=" << compressedBytes);
+    REQUIRE(static_cast<qint64>(res.body.size()) == projectedBytes);
+    REQUIRE(projectedBytes * 4 < fullBytes);
+    REQUIRE(compressedBytes * 4 < projectedBytes);
+}
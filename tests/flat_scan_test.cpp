@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "disk_tree/infrastructure/api_tree_repository.hpp"
+#include "sync/application/flat_file_scan.hpp"
+#include "sync/application/scan_and_fill_index_use_case.hpp"
+#include "sync/infrastructure/sync_index.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+#include <QMap>
+#include <QNetworkAccessManager>
+#include <QTemporaryDir>
+#include <QUrl>
+#include <QUrlQuery>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+struct SyntheticDisk {
+    QMap<QByteArray, QList<QByteArray>> dirs;
+    QList<QByteArray> dirItems;
+    QList<QByteArray> files;
+
+    SyntheticDisk(int dirsPerRoot, int filesPerDir) {
+        for (const QByteArray root : {QByteArray("/A"), QByteArray("/B")}) {
+            dirs[root];
+            for (int d = 0; d < dirsPerRoot; ++d) {
+                const QByteArray dir = root + "/d" + QByteArray::number(d);
+                dirs[root].append(R"({"type":"dir","path":"disk:)" + dir + R"(","name":"d)" + QByteArray::number(d) + R"("})");
+                for (int f = 0; f < filesPerDir; ++f) {
+                    const QByteArray name = "f" + QByteArray::number(f) + ".txt";
+                    const QByteArray item = R"({"type":"file","path":"disk:)" + dir + '/' + name + R"(","name":")" + name
+                        + R"(","size":7,"modified":"2024-01-15T12:00:00+00:00"})";
+                    dirs[dir].append(item);
+                    files.append(item);
+                }
+            }
+        }
+    }
+
+    test::LocalHttpServer::Response serve(const test::LocalHttpServer::Request& req) const {
+        const QUrl url(QString::fromUtf8(req.target));
+        const QUrlQuery q(url);
+        const int limit = q.queryItemValue(QStringLiteral("limit")).toInt();
+        const int offset = q.queryItemValue(QStringLiteral("offset")).toInt();
+        test::LocalHttpServer::Response r;
+        if (url.path().endsWith(QLatin1String("/resources/files"))) {
+            r.body = R"({"items":[)" + join(files.mid(offset, limit)) + "]}";
+            return r;
+        }
+        QByteArray path = q.queryItemValue(QStringLiteral("path"), QUrl::FullyDecoded).toUtf8();
+        if (path.startsWith("disk:")) path = path.mid(5);
+        const QList<QByteArray> children = dirs.value(path);
+        r.body = R"({"_embedded":{"items":[)" + join(children.mid(offset, limit)) + R"(],"total":)"
+            + QByteArray::number(children.size()) + "}}";
+        return r;
+    }
+
+    static QByteArray join(const QList<QByteArray>& items) {
+        QByteArray out;
+        for (const QByteArray& i : items) {
+            if (!out.isEmpty()) out += ',';
+            out += i;
+        }
+        return out;
+    }
+};
+
+struct ScanFixture {
+    QTemporaryDir dir;
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api{tokens, &nam};
+    disk_tree::ApiTreeRepository repo{api};
+    sync::DiskResourceClient client{api};
+
+    explicit ScanFixture(const QString& baseUrl) { api.setBaseUrl(baseUrl); }
+
+    QStringList scan(const QString& name, sync::ScanAndFillIndexUseCase::Mode mode) {
+        const QString root = QStringLiteral("/sync");
+        sync::SyncIndex index;
+        REQUIRE(index.open(dir.filePath(name)));
+        REQUIRE(index.beginTransaction());
+        auto r = sync::ScanAndFillIndexUseCase::run(repo, &client, index, root, {"/A"}, {}, mode);
+        REQUIRE(r == sync::ScanAndFillIndexUseCase::Result::Success);
+        QStringList paths = index.getRelativePathsWithStatus(root, sync::FileStatus::TO_DOWNLOAD);
+        paths.sort();
+        index.close();
+        return paths;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("FlatFileScan root filter matches whole path segments") {
+    const QStringList roots{QStringLiteral("Photos")};
+    REQUIRE(sync::FlatFileScan::isUnderSelectedRoots(QStringLiteral("Photos/a.jpg"), roots));
+    REQUIRE(sync::FlatFileScan::isUnderSelectedRoots(QStringLiteral("Photos"), roots));
+    REQUIRE_FALSE(sync::FlatFileScan::isUnderSelectedRoots(QStringLiteral("Photos2/a.jpg"), roots));
+    REQUIRE(sync::FlatFileScan::isUnderSelectedRoots(QStringLiteral("any/file"), {QString()}));
+}
+
+TEST_CASE("Flat and recursive scans fill the index with the same files") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    SyntheticDisk disk(30, 5);
+    test::LocalHttpServer server([&disk](const test::LocalHttpServer::Request& req) { return disk.serve(req); });
+    REQUIRE(server.isListening());
+    ScanFixture fx(server.baseUrl());
+    REQUIRE(fx.dir.isValid());
+
+    const QStringList recursive = fx.scan(QStringLiteral("recursive.db"), sync::ScanAndFillIndexUseCase::Mode::Recursive);
+    const int recursiveRequests = server.requestCount();
+    const QStringList flat = fx.scan(QStringLiteral("flat.db"), sync::ScanAndFillIndexUseCase::Mode::Flat);
+    REQUIRE(recursive.size() == 150);
+    REQUIRE(flat == recursive);
+    REQUIRE(recursive.front().startsWith(QStringLiteral("A/")));
+    REQUIRE(server.requestCount() - recursiveRequests == 1);
+}
+
+TEST_CASE("Auto scan switches to the flat listing for large trees") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    SyntheticDisk disk(sync::ScanAndFillIndexUseCase::kFlatScanDirThreshold * 2, 2);
+    test::LocalHttpServer server([&disk](const test::LocalHttpServer::Request& req) { return disk.serve(req); });
+    REQUIRE(server.isListening());
+    ScanFixture fx(server.baseUrl());
+    REQUIRE(fx.dir.isValid());
+
+    const QStringList paths = fx.scan(QStringLiteral("auto.db"), sync::ScanAndFillIndexUseCase::Mode::Auto);
+    REQUIRE(paths.size() == sync::ScanAndFillIndexUseCase::kFlatScanDirThreshold * 2 * 2);
+    REQUIRE(server.requestCount() < sync::ScanAndFillIndexUseCase::kFlatScanDirThreshold + 10);
+}
+
+TEST_CASE("Recursive vs flat initial scan against a local server", "[.][benchmark]") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    SyntheticDisk disk(2000, 3);
+    test::LocalHttpServer server([&disk](const test::LocalHttpServer::Request& req) { return disk.serve(req); });
+    REQUIRE(server.isListening());
+    ScanFixture fx(server.baseUrl());
+    REQUIRE(fx.dir.isValid());
+    int run = 0;
+
+    BENCHMARK("recursive folder walk") {
+        return fx.scan(QStringLiteral("r%1.db").arg(++run), sync::ScanAndFillIndexUseCase::Mode::Recursive).size();
+    };
+    BENCHMARK("flat /resources/files") {
+        return fx.scan(QStringLiteral("f%1.db").arg(++run), sync::ScanAndFillIndexUseCase::Mode::Flat).size();
+    };
+}
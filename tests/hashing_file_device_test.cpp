@@ -0,0 +1,38 @@
+#include <catch2/catch_test_macros.hpp>
+#include "sync/infrastructure/hashing_file_device.hpp"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QTemporaryDir>
+
+using namespace ydisquette::sync;
+
+TEST_CASE("HashingFileDevice hashes the file as it is read, once per byte") {
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("upload.bin"));
+    QByteArray content;
+    for (int i = 0; i < 100000; ++i)
+        content.append(static_cast<char>(i * 31));
+    {
+        QFile f(path);
+        REQUIRE(f.open(QIODevice::WriteOnly));
+        REQUIRE(f.write(content) == content.size());
+    }
+    const QString expected = QString::fromLatin1(QCryptographicHash::hash(content, QCryptographicHash::Md5).toHex());
+
+    HashingFileDevice device(path);
+    REQUIRE(device.open(QIODevice::ReadOnly));
+    REQUIRE(device.size() == content.size());
+    REQUIRE(device.read(4096) == content.left(4096));
+    REQUIRE(device.md5().isEmpty());
+    REQUIRE(device.seek(1000));
+    REQUIRE(device.read(10000) == content.mid(1000, 10000));
+    REQUIRE(device.reset());
+    QByteArray all = device.readAll();
+    REQUIRE(all == content);
+    REQUIRE(device.md5() == expected);
+    device.close();
+
+    HashingFileDevice missing(dir.filePath(QStringLiteral("missing.bin")));
+    REQUIRE_FALSE(missing.open(QIODevice::ReadOnly));
+}
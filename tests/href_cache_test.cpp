@@ -0,0 +1,51 @@
+#include <catch2/catch_test_macros.hpp>
+#include "sync/infrastructure/href_cache.hpp"
+
+using namespace ydisquette::sync;
+
+TEST_CASE("HrefCache hands out a cached href once") {
+    HrefCache cache;
+    cache.put(QStringLiteral("download:/a.txt"), QStringLiteral("https://dl/a"));
+    REQUIRE(cache.isKnown(QStringLiteral("download:/a.txt")));
+    auto href = cache.take(QStringLiteral("download:/a.txt"));
+    REQUIRE(href.has_value());
+    REQUIRE(*href == QStringLiteral("https://dl/a"));
+    REQUIRE_FALSE(cache.take(QStringLiteral("download:/a.txt")).has_value());
+}
+
+TEST_CASE("HrefCache drops expired hrefs") {
+    HrefCache cache(0);
+    cache.put(QStringLiteral("upload:/a.txt"), QStringLiteral("https://up/a"));
+    REQUIRE_FALSE(cache.isKnown(QStringLiteral("upload:/a.txt")));
+    REQUIRE_FALSE(cache.take(QStringLiteral("upload:/a.txt")).has_value());
+}
+
+TEST_CASE("HrefCache evicts the oldest entry at capacity") {
+    HrefCache cache(HrefCache::kDefaultTtlMs, 2);
+    cache.put(QStringLiteral("a"), QStringLiteral("1"));
+    cache.put(QStringLiteral("b"), QStringLiteral("2"));
+    cache.put(QStringLiteral("c"), QStringLiteral("3"));
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.take(QStringLiteral("c")).has_value());
+}
+
+TEST_CASE("HrefCache passes a prefetched href to a waiter instead of caching it") {
+    HrefCache cache;
+    const QString key = QStringLiteral("download:/b.bin");
+    REQUIRE(cache.beginPrefetch(key));
+    REQUIRE_FALSE(cache.beginPrefetch(key));
+    QString received;
+    REQUIRE(cache.addWaiter(key, [&received](const QString& href) { received = href; }));
+    cache.finishPrefetch(key, QStringLiteral("https://dl/b"));
+    REQUIRE(received == QStringLiteral("https://dl/b"));
+    REQUIRE_FALSE(cache.isKnown(key));
+}
+
+TEST_CASE("HrefCache keeps a prefetched href nobody waited for") {
+    HrefCache cache;
+    const QString key = QStringLiteral("upload:/c.bin");
+    REQUIRE(cache.beginPrefetch(key));
+    REQUIRE_FALSE(cache.addWaiter(QStringLiteral("upload:/other"), [](const QString&) {}));
+    cache.finishPrefetch(key, QStringLiteral("https://up/c"));
+    REQUIRE(cache.take(key).value_or(QString()) == QStringLiteral("https://up/c"));
+}
@@ -16,6 +16,11 @@ TEST_CASE("JsonConfig save and load round-trip in temp dir") {
     JsonConfig c;
     c.syncFolder = QStringLiteral("/home/user/Sync");
     c.maxRetries = 5;
+    c.maxParallelDownloads = 8;
+    c.maxParallelUploads = 2;
+    c.indexCommitRows = 1;
+    c.indexCommitMs = 250;
+    c.directUploads = false;
     c.refreshIntervalSec = 120;
     c.pollTimeSec = 180;
     c.selectedNodePaths = { QStringLiteral("/Disk/Apps"), QStringLiteral("/Disk/Docs") };
@@ -25,6 +30,11 @@ TEST_CASE("JsonConfig save and load round-trip in temp dir") {
 
     REQUIRE(loaded.syncFolder == c.syncFolder);
     REQUIRE(loaded.maxRetries == c.maxRetries);
+    REQUIRE(loaded.maxParallelDownloads == c.maxParallelDownloads);
+    REQUIRE(loaded.maxParallelUploads == c.maxParallelUploads);
+    REQUIRE(loaded.indexCommitRows == 1);
+    REQUIRE(loaded.indexCommitMs == 250);
+    REQUIRE(loaded.directUploads == c.directUploads);
     REQUIRE(loaded.refreshIntervalSec == c.refreshIntervalSec);
     REQUIRE(loaded.pollTimeSec == c.pollTimeSec);
     REQUIRE(loaded.selectedNodePaths.size() == 2u);
@@ -45,6 +55,11 @@ TEST_CASE("JsonConfig load missing file returns defaults") {
     REQUIRE(loaded.syncFolder.isEmpty());
     REQUIRE(loaded.selectedNodePaths.isEmpty());
     REQUIRE(loaded.maxRetries == 3);
+    REQUIRE(loaded.maxParallelDownloads == 4);
+    REQUIRE(loaded.maxParallelUploads == 4);
+    REQUIRE(loaded.indexCommitRows == 64);
+    REQUIRE(loaded.indexCommitMs == 1000);
+    REQUIRE(loaded.directUploads);
     REQUIRE(loaded.refreshIntervalSec == 60);
     REQUIRE(loaded.pollTimeSec == 120);
 }
@@ -0,0 +1,124 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "disk_tree/infrastructure/api_parse.hpp"
+#include "shared/iso_datetime.hpp"
+#include "shared/json_reader.hpp"
+#include "sync/infrastructure/trash_parser.hpp"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <string>
+
+using namespace ydisquette;
+
+namespace {
+
+std::string resourcesPayload(int count) {
+    std::string out = R"({"_embedded":{"sort":"","path":"disk:/Photos/Camera Uploads","limit":)"
+        + std::to_string(count) + R"(,"offset":0,"items":[)";
+    for (int i = 0; i < count; ++i) {
+        if (i) out += ',';
+        const std::string name = "IMG_" + std::to_string(20240000 + i) + (i % 10 == 0 ? "" : ".jpg");
+        if (i % 10 == 0)
+            out += R"({"type":"dir","path":"disk:/Photos/Camera Uploads/)" + name + R"(","name":")" + name
+                + R"(","modified":"2024-01-15T12:00:00+00:00","created":"2024-01-15T12:00:00+00:00","resource_id":"12:ab"})";
+        else
+            out += R"({"type":"file","path":"disk:/Photos/Camera Uploads/)" + name + R"(","name":")" + name
+                + R"(","size":)" + std::to_string(1000000 + i) + R"(,"modified":"2024-01-15T12:00:00+00:00","mime_type":"image/jpeg","md5":"d41d8cd98f00b204e9800998ecf8427e"})";
+    }
+    out += R"(],"total":)" + std::to_string(count) + "}}";
+    return out;
+}
+
+size_t viaDom(const std::string& body) {
+    QJsonDocument doc = QJsonDocument::fromJson(QByteArray::fromStdString(body));
+    QJsonArray items = doc.object().value(QStringLiteral("_embedded")).toObject().value(QStringLiteral("items")).toArray();
+    disk_tree::NodeList out;
+    for (const QJsonValue& v : items) {
+        QJsonObject o = v.toObject();
+        const QByteArray path = o.value(QStringLiteral("path")).toString().toUtf8();
+        const QByteArray name = o.value(QStringLiteral("name")).toString().toUtf8();
+        const QByteArray modified = o.value(QStringLiteral("modified")).toString().toUtf8();
+        out.add(o.value(QStringLiteral("type")).toString() == QLatin1String("dir") ? disk_tree::NodeType::Dir
+                                                                                  : disk_tree::NodeType::File,
+                path.toStdString(), name.toStdString(), o.value(QStringLiteral("size")).toInteger(0),
+                modified.toStdString(), parseIsoDateTimeToSec(modified.toStdString()));
+    }
+    return out.size();
+}
+
+}  // namespace
+
+TEST_CASE("JsonReader decodes escapes and skips unknown values") {
+    JsonReader r(R"({"skip":{"a":[1,2.5e3,true,null,{"b":"\"}"}]},"name":"café 😀\n\/","n":-42,"f":1.5})");
+    std::string_view key;
+    std::string name;
+    int64_t n = 0;
+    int64_t f = 0;
+    REQUIRE(r.beginObject());
+    while (r.nextKey(key)) {
+        if (key == "name")
+            r.readString(name);
+        else if (key == "n")
+            n = r.readInteger(0);
+        else if (key == "f")
+            f = r.readInteger(7);
+        else
+            r.skipValue();
+    }
+    REQUIRE(r.atEnd());
+    REQUIRE(name == "caf\xc3\xa9 \xf0\x9f\x98\x80\n/");
+    REQUIRE(n == -42);
+    REQUIRE(f == 7);
+}
+
+TEST_CASE("JsonReader rejects malformed documents") {
+    for (const char* bad : {"", "{ invalid }", R"({"a":1,})", "[1,]", R"({"a":01})", R"({"a":"x)", R"({"a":1} x)"}) {
+        INFO(bad);
+        JsonReader r(bad);
+        r.skipValue();
+        REQUIRE_FALSE(r.atEnd());
+    }
+    JsonReader good(R"( {"a":[1,{"b":[]}]} )");
+    REQUIRE(good.skipValue());
+    REQUIRE(good.atEnd());
+}
+
+TEST_CASE("parseTrashJson prefers _embedded items and falls back to top-level items") {
+    auto embedded = sync::parseTrashJson(R"({"_embedded":{"items":[
+        {"path":"trash:/a","origin_path":"disk:/a.txt","deleted":"2024-01-15T12:00:00+00:00","type":"file"},
+        {"path":"trash:/b","type":"file"}]},"items":[{"origin_path":"disk:/ignored"}]})");
+    REQUIRE(embedded.size() == 1);
+    REQUIRE(embedded[0].originPath == QStringLiteral("disk:/a.txt"));
+    REQUIRE(embedded[0].deletedSec == 1705320000);
+
+    auto plain = sync::parseTrashJson(R"({"_embedded":{"items":[]},"items":[
+        {"origin_path":"disk:/b","modified":"2024-01-15T12:00:01Z","type":"dir"}]})");
+    REQUIRE(plain.size() == 1);
+    REQUIRE(plain[0].deletedSec == 1705320001);
+    REQUIRE(plain[0].type == QStringLiteral("dir"));
+    REQUIRE(sync::parseTrashJson("{ invalid }").empty());
+}
+
+TEST_CASE("Streaming and DOM parsing agree on a large listing") {
+    const std::string body = resourcesPayload(2000);
+    const disk_tree::ResourcesPage page = disk_tree::parseResourcesPageJson(body);
+    REQUIRE(page.total == 2000);
+    REQUIRE(page.items.size() == viaDom(body));
+    REQUIRE(page.items[0].isDir());
+    REQUIRE(page.items[1].size() == 1000001);
+    REQUIRE(page.items[1].path() == "disk:/Photos/Camera Uploads/IMG_20240001.jpg");
+    REQUIRE(page.items[1].modifiedSec() == 1705320000);
+}
+
+TEST_CASE("Listing JSON parsing", "[.][benchmark]") {
+    for (int count : {1000, 10000, 100000}) {
+        const std::string body = resourcesPayload(count);
+        BENCHMARK("QJsonDocument " + std::to_string(count) + " items") {
+            return viaDom(body);
+        };
+        BENCHMARK("JsonReader " + std::to_string(count) + " items") {
+            return disk_tree::parseResourcesPageJson(body).items.size();
+        };
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <functional>
+#include <memory>
+
+namespace ydisquette {
+namespace test {
+
+class LocalHttpServer {
+public:
+    struct Request {
+        QByteArray method;
+        QByteArray target;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QByteArray header(const QByteArray& name) const {
+            for (const auto& h : headers)
+                if (h.first.compare(name, Qt::CaseInsensitive) == 0) return h.second;
+            return QByteArray();
+        }
+    };
+    struct Response {
+        int status = 200;
+        QByteArray contentType = "application/json";
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QByteArray body;
+    };
+    using Handler = std::function<Response(const Request&)>;
+
+    explicit LocalHttpServer(Handler handler, qint64 perConnectionBytesPerSec = 0)
+        : handler_(std::move(handler)), bytesPerSec_(perConnectionBytesPerSec) {
+        QObject::connect(&server_, &QTcpServer::newConnection, &server_, [this]() {
+            while (QTcpSocket* socket = server_.nextPendingConnection())
+                serve(socket);
+        });
+        server_.listen(QHostAddress::LocalHost, 0);
+    }
+
+    bool isListening() const { return server_.isListening(); }
+    QString baseUrl() const { return QStringLiteral("http://127.0.0.1:%1").arg(server_.serverPort()); }
+    int requestCount() const { return requestCount_; }
+    int connectionCount() const { return connectionCount_; }
+    qint64 bodyBytesSent() const { return bodyBytesSent_; }
+
+    static QByteArray deflate(const QByteArray& data) { return qCompress(data).mid(4); }
+
+    static Response serveBytes(const QByteArray& data, const Request& req) {
+        Response r;
+        r.contentType = "application/octet-stream";
+        const QByteArray range = req.header("Range");
+        if (!range.startsWith("bytes=")) {
+            r.body = data;
+            return r;
+        }
+        const QList<QByteArray> parts = range.mid(6).split('-');
+        const qint64 from = parts.value(0).toLongLong();
+        qint64 to = parts.value(1).isEmpty() ? data.size() - 1 : parts.value(1).toLongLong();
+        to = qMin<qint64>(to, data.size() - 1);
+        if (from >= data.size() || from > to) {
+            r.status = 416;
+            r.headers.append({"Content-Range", "bytes */" + QByteArray::number(data.size())});
+            return r;
+        }
+        r.status = 206;
+        r.headers.append({"Content-Range", "bytes " + QByteArray::number(from) + '-' + QByteArray::number(to)
+                                               + '/' + QByteArray::number(data.size())});
+        r.body = data.mid(static_cast<int>(from), static_cast<int>(to - from + 1));
+        return r;
+    }
+
+private:
+    struct Connection {
+        QByteArray buffer;
+        QByteArray pendingOut;
+        QTimer* throttle = nullptr;
+    };
+
+    void serve(QTcpSocket* socket) {
+        ++connectionCount_;
+        auto conn = std::make_shared<Connection>();
+        QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        QObject::connect(socket, &QTcpSocket::readyRead, socket, [this, socket, conn]() {
+            conn->buffer += socket->readAll();
+            for (;;) {
+                const int end = conn->buffer.indexOf("\r\n\r\n");
+                if (end < 0) return;
+                Request req = parse(conn->buffer.left(end));
+                const qint64 contentLength = req.header("Content-Length").toLongLong();
+                if (conn->buffer.size() < end + 4 + contentLength) return;
+                conn->buffer.remove(0, static_cast<int>(end + 4 + contentLength));
+                ++requestCount_;
+                send(socket, conn, handler_(req));
+            }
+        });
+    }
+
+    static Request parse(const QByteArray& head) {
+        Request req;
+        const QList<QByteArray> lines = head.split('\n');
+        const QList<QByteArray> first = lines.value(0).trimmed().split(' ');
+        req.method = first.value(0);
+        req.target = first.value(1);
+        for (int i = 1; i < lines.size(); ++i) {
+            const int colon = lines[i].indexOf(':');
+            if (colon <= 0) continue;
+            req.headers.append({lines[i].left(colon).trimmed(), lines[i].mid(colon + 1).trimmed()});
+        }
+        return req;
+    }
+
+    static QByteArray reason(int status) {
+        switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 404: return "Not Found";
+        case 416: return "Range Not Satisfiable";
+        default: return "Status";
+        }
+    }
+
+    void send(QTcpSocket* socket, const std::shared_ptr<Connection>& conn, const Response& r) {
+        QByteArray out = "HTTP/1.1 " + QByteArray::number(r.status) + ' ' + reason(r.status) + "\r\n";
+        out += "Content-Type: " + r.contentType + "\r\n";
+        out += "Content-Length: " + QByteArray::number(r.body.size()) + "\r\n";
+        for (const auto& h : r.headers)
+            out += h.first + ": " + h.second + "\r\n";
+        out += "\r\n";
+        out += r.body;
+        bodyBytesSent_ += r.body.size();
+        if (bytesPerSec_ <= 0) {
+            socket->write(out);
+            return;
+        }
+        conn->pendingOut += out;
+        if (conn->throttle) return;
+        conn->throttle = new QTimer(socket);
+        const qint64 perTick = qMax<qint64>(1, bytesPerSec_ / 100);
+        QObject::connect(conn->throttle, &QTimer::timeout, socket, [socket, conn, perTick]() {
+            if (conn->pendingOut.isEmpty()) return;
+            const int n = static_cast<int>(qMin<qint64>(perTick, conn->pendingOut.size()));
+            socket->write(conn->pendingOut.constData(), n);
+            conn->pendingOut.remove(0, n);
+        });
+        conn->throttle->start(10);
+    }
+
+    QTcpServer server_;
+    Handler handler_;
+    qint64 bytesPerSec_;
+    int requestCount_ = 0;
+    int connectionCount_ = 0;
+    qint64 bodyBytesSent_ = 0;
+};
+
+}  // namespace test
+}  // namespace ydisquette
@@ -0,0 +1,121 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "disk_tree/domain/node_list.hpp"
+#include "disk_tree/infrastructure/api_parse.hpp"
+#include <string>
+
+using namespace ydisquette::disk_tree;
+
+namespace {
+
+std::string fileName(int i) {
+    return "IMG_" + std::to_string(100000 + i) + ".jpg";
+}
+
+const char kModified[] = "2024-01-15T12:00:00+00:00";
+
+size_t heapBytes(const std::string& s) {
+    return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+size_t nodeVectorBytes(const std::vector<std::shared_ptr<Node>>& nodes) {
+    size_t total = nodes.capacity() * sizeof(std::shared_ptr<Node>);
+    for (const auto& n : nodes)
+        total += sizeof(Node) + 16 + heapBytes(n->path) + heapBytes(n->name) + heapBytes(n->modified);
+    return total;
+}
+
+NodeList buildList(const std::string& parent, int count) {
+    NodeList list;
+    list.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const std::string name = fileName(i);
+        list.add(NodeType::File, parent + "/" + name, name, i, kModified, 1705320000);
+    }
+    return list;
+}
+
+std::vector<std::shared_ptr<Node>> buildNodes(const std::string& parent, int count) {
+    std::vector<std::shared_ptr<Node>> nodes;
+    nodes.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const std::string name = fileName(i);
+        nodes.push_back(Node::makeFile(parent + "/" + name, name, i, kModified));
+    }
+    return nodes;
+}
+
+}  // namespace
+
+TEST_CASE("NodeList stores names once and rebuilds paths from the parent") {
+    NodeList list;
+    list.add(NodeType::Dir, "disk:/Photos/2024", "2024", 0, "2024-01-15T12:00:00+00:00", 1705320000);
+    list.add(NodeType::File, "disk:/Photos/a.jpg", "a.jpg", 10);
+    list.add(NodeType::File, "disk:/Elsewhere/b.jpg", "b.jpg", 20);
+
+    REQUIRE(list.size() == 3);
+    REQUIRE(list[0].isDir());
+    REQUIRE(list[0].path() == "disk:/Photos/2024");
+    REQUIRE(list[0].name() == "2024");
+    REQUIRE(list[0].modified() == "2024-01-15T12:00:00+00:00");
+    REQUIRE(list[0].modifiedSec() == 1705320000);
+    REQUIRE(list[1].path() == "disk:/Photos/a.jpg");
+    REQUIRE(list[1].size() == 10);
+    REQUIRE(list[2].path() == "disk:/Elsewhere/b.jpg");
+
+    NodeList copy = NodeList::fromNodes(list.toNodes());
+    REQUIRE(copy.size() == 3);
+    REQUIRE(copy[2].path() == "disk:/Elsewhere/b.jpg");
+    REQUIRE(copy[0].modified() == list[0].modified());
+
+    NodeList joined = list;
+    joined.append(list);
+    REQUIRE(joined.size() == 6);
+    REQUIRE(joined[4].path() == "disk:/Photos/a.jpg");
+}
+
+TEST_CASE("parseResourcesPageJson fills the arena and parses modified once") {
+    const std::string json = R"({"_embedded":{"total":2,"items":[
+        {"type":"dir","path":"disk:/Photos/2024","name":"2024","modified":"2024-01-15T12:00:00+00:00"},
+        {"type":"file","path":"disk:/Photos/a.jpg","name":"a.jpg","size":7,"modified":"2024-01-15T12:00:01Z"}
+    ]}})";
+    ResourcesPage page = parseResourcesPageJson(json);
+    REQUIRE(page.total == 2);
+    REQUIRE(page.items.size() == 2);
+    REQUIRE(page.items[0].isDir());
+    REQUIRE(page.items[0].modifiedSec() == 1705320000);
+    REQUIRE(page.items[1].path() == "disk:/Photos/a.jpg");
+    REQUIRE(page.items[1].size() == 7);
+    REQUIRE(page.items[1].modifiedSec() == 1705320001);
+}
+
+TEST_CASE("NodeList uses a fraction of the memory of shared Node objects") {
+    const std::string parent = "disk:/Photos/Camera Uploads/2024";
+    const NodeList list = buildList(parent, 10000);
+    const auto nodes = buildNodes(parent, 10000);
+    REQUIRE(list.bytesUsed() * 2 < nodeVectorBytes(nodes));
+}
+
+TEST_CASE("NodeList vs shared Node listings", "[.][benchmark]") {
+    const std::string parent = "disk:/Photos/Camera Uploads/2024";
+    const int count = 100000;
+    const NodeList list = buildList(parent, count);
+    const auto nodes = buildNodes(parent, count);
+
+    BENCHMARK("build shared Nodes") {
+        return buildNodes(parent, count).size();
+    };
+    BENCHMARK("build NodeList") {
+        return buildList(parent, count).size();
+    };
+    BENCHMARK("sum sizes over shared Nodes") {
+        int64_t total = 0;
+        for (const auto& n : nodes) total += n->size;
+        return total;
+    };
+    BENCHMARK("sum sizes over NodeList") {
+        int64_t total = 0;
+        for (NodeRef n : list) total += n.size();
+        return total;
+    };
+}
@@ -0,0 +1,130 @@
+#include <catch2/catch_test_macros.hpp>
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "disk_tree/application/itree_repository.hpp"
+#include "disk_tree/infrastructure/api_parse.hpp"
+#include "shared/cloud_path_util.hpp"
+#include "sync/application/scan_and_fill_index_use_case.hpp"
+#include "sync/infrastructure/sync_index.hpp"
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace ydisquette;
+
+namespace {
+
+std::atomic<bool> g_tracking{false};
+std::atomic<size_t> g_allocations{0};
+std::atomic<size_t> g_largest{0};
+
+void* trackedAlloc(std::size_t size) {
+    if (g_tracking.load(std::memory_order_relaxed)) {
+        ++g_allocations;
+        size_t prev = g_largest.load();
+        while (size > prev && !g_largest.compare_exchange_weak(prev, size)) {}
+    }
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+struct AllocStats {
+    size_t count = 0;
+    size_t largest = 0;
+};
+
+template <class F>
+AllocStats measure(F&& f) {
+    g_allocations = 0;
+    g_largest = 0;
+    g_tracking = true;
+    f();
+    g_tracking = false;
+    return {g_allocations.load(), g_largest.load()};
+}
+
+QByteArray listingBody(int count) {
+    QByteArray out = R"({"_embedded":{"items":[)";
+    for (int i = 0; i < count; ++i) {
+        if (i) out += ',';
+        const QByteArray name = "IMG_" + QByteArray::number(20240000 + i) + ".jpg";
+        out += R"({"type":"file","path":"disk:/Photos/)" + name + R"(","name":")" + name
+            + R"(","size":123456,"modified":"2024-01-15T12:00:00+00:00","md5":"d41d8cd98f00b204e9800998ecf8427e"})";
+    }
+    out += R"(],"total":)" + QByteArray::number(count) + "}}";
+    return out;
+}
+
+struct StubListingRepository : disk_tree::ITreeRepository {
+    std::string listedPath;
+    auth::ApiResponse response;
+
+    std::shared_ptr<disk_tree::Node> getRoot() override { return disk_tree::Node::makeDir("/", ""); }
+    disk_tree::NodeList getChildren(const std::string& path) override {
+        if (normalizeCloudPath(path) != listedPath) return {};
+        return disk_tree::parseResourcesPageJson(response.bodyView()).items;
+    }
+    void getChildrenAsync(const std::string& path, std::function<void(disk_tree::NodeList)> cb) override {
+        cb(getChildren(path));
+    }
+};
+
+}  // namespace
+
+void* operator new(std::size_t size) { return trackedAlloc(size); }
+void* operator new[](std::size_t size) { return trackedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+TEST_CASE("Listing responses are parsed without copying the body") {
+    auth::ApiResponse res{200, listingBody(2000)};
+    const size_t bodySize = static_cast<size_t>(res.body.size());
+
+    AllocStats copied = measure([&] {
+        const std::string legacy = res.body.toStdString();
+        disk_tree::parseResourcesPageJson(QByteArray::fromStdString(legacy).toStdString());
+    });
+    REQUIRE(copied.largest >= bodySize);
+
+    size_t items = 0;
+    AllocStats inPlace = measure([&] {
+        auth::ApiResponse passed = res;
+        items = disk_tree::parseResourcesPageJson(passed.bodyView()).items.size();
+    });
+    REQUIRE(items == 2000);
+    REQUIRE(inPlace.largest < bodySize / 2);
+    REQUIRE(inPlace.count < copied.count);
+}
+
+TEST_CASE("A listing reaches the sync index without copying the body or allocating per field") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const int kItems = 2000;
+    StubListingRepository repo;
+    repo.listedPath = "/Photos";
+    repo.response = {200, listingBody(kItems)};
+    const size_t bodySize = static_cast<size_t>(repo.response.body.size());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    sync::SyncIndex index;
+    REQUIRE(index.open(dir.filePath(QStringLiteral("sync_index.db"))));
+    REQUIRE(index.beginTransaction());
+    const QString root = QStringLiteral("/home/sync");
+    const std::vector<std::string> selected{"/Photos"};
+
+    auto result = sync::ScanAndFillIndexUseCase::Result::IndexError;
+    AllocStats stats = measure([&] {
+        result = sync::ScanAndFillIndexUseCase::run(repo, nullptr, index, root, selected, std::function<bool()>(),
+                                                    sync::ScanAndFillIndexUseCase::Mode::Recursive);
+    });
+    REQUIRE(result == sync::ScanAndFillIndexUseCase::Result::Success);
+    REQUIRE(index.getRelativePathsWithStatus(root, sync::FileStatus::TO_DOWNLOAD).size() == kItems);
+    REQUIRE(stats.largest < bodySize / 2);
+    REQUIRE(stats.count < static_cast<size_t>(kItems) * 16);
+    index.close();
+}
@@ -0,0 +1,165 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "sync/application/sync_path_mapper.hpp"
+#include "sync/infrastructure/disk_resource_client.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QTemporaryDir>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+QByteArray patternBytes(int size) {
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i)
+        data[i] = static_cast<char>((i * 131 + i / 4093) & 0xff);
+    return data;
+}
+
+QByteArray readAll(const QString& path) {
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return QByteArray();
+    return f.readAll();
+}
+
+sync::DiskResourceResult downloadSegmented(sync::DiskResourceClient& client, const QString& url,
+                                           const QString& localPath, qint64 size, int segments) {
+    sync::DiskResourceResult result;
+    QEventLoop loop;
+    client.downloadHrefSegmentedAsync(url, localPath, size, segments, [&](sync::DiskResourceResult r) {
+        result = r;
+        loop.quit();
+    });
+    loop.exec();
+    return result;
+}
+
+}  // namespace
+
+TEST_CASE("Segmented download reassembles the file from byte ranges") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QByteArray data = patternBytes(3 * 1024 * 1024 + 17);
+    test::LocalHttpServer server([&data](const test::LocalHttpServer::Request& req) {
+        return test::LocalHttpServer::serveBytes(data, req);
+    });
+    REQUIRE(server.isListening());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    sync::DiskResourceClient client(api);
+
+    const QString localPath = dir.filePath(QStringLiteral("big.bin"));
+    {
+        QFile existing(localPath);
+        REQUIRE(existing.open(QIODevice::WriteOnly));
+        existing.write("previous version");
+    }
+    auto r = downloadSegmented(client, server.baseUrl() + QStringLiteral("/file"), localPath, data.size(), 4);
+    REQUIRE(r.success);
+    REQUIRE(server.requestCount() == 4);
+    REQUIRE(readAll(localPath) == data);
+    REQUIRE_FALSE(QFile::exists(sync::partialDownloadPath(localPath)));
+}
+
+TEST_CASE("Segmented download reports the contiguous prefix when a segment is short") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QByteArray data = patternBytes(1024 * 1024);
+    test::LocalHttpServer server([&data](const test::LocalHttpServer::Request& req) {
+        test::LocalHttpServer::Response r = test::LocalHttpServer::serveBytes(data, req);
+        if (req.header("Range").startsWith("bytes=524288-"))
+            r.body.chop(1000);
+        return r;
+    });
+    REQUIRE(server.isListening());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    sync::DiskResourceClient client(api);
+
+    const QString localPath = dir.filePath(QStringLiteral("big.bin"));
+    auto r = downloadSegmented(client, server.baseUrl() + QStringLiteral("/file"), localPath, data.size(), 4);
+    REQUIRE_FALSE(r.success);
+    REQUIRE(r.partialBytes == 3 * 256 * 1024 - 1000);
+    REQUIRE_FALSE(QFile::exists(localPath));
+}
+
+TEST_CASE("Segmented download does not commit when a segment ends short with a success status") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QByteArray data = patternBytes(1024 * 1024);
+    test::LocalHttpServer server([&data](const test::LocalHttpServer::Request& req) {
+        test::LocalHttpServer::Response r = test::LocalHttpServer::serveBytes(data, req);
+        if (req.header("Range").startsWith("bytes=262144-")) {
+            r.body.chop(4096);
+            r.headers = {{"Content-Range", "bytes 262144-" + QByteArray::number(262144 + r.body.size() - 1)
+                                               + '/' + QByteArray::number(data.size())}};
+        }
+        return r;
+    });
+    REQUIRE(server.isListening());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    sync::DiskResourceClient client(api);
+
+    const QString localPath = dir.filePath(QStringLiteral("big.bin"));
+    {
+        QFile existing(localPath);
+        REQUIRE(existing.open(QIODevice::WriteOnly));
+        existing.write("previous version");
+    }
+    auto r = downloadSegmented(client, server.baseUrl() + QStringLiteral("/file"), localPath, data.size(), 4);
+    REQUIRE_FALSE(r.success);
+    REQUIRE(r.partialBytes == 2 * 256 * 1024 - 4096);
+    REQUIRE(readAll(localPath) == QByteArray("previous version"));
+    REQUIRE(QFile::exists(sync::partialDownloadPath(localPath)));
+}
+
+TEST_CASE("Segmented vs single-stream download against a throttled local server", "[.][benchmark]") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QByteArray data = patternBytes(8 * 1024 * 1024);
+    test::LocalHttpServer server([&data](const test::LocalHttpServer::Request& req) {
+        return test::LocalHttpServer::serveBytes(data, req);
+    }, 32 * 1024 * 1024);
+    REQUIRE(server.isListening());
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    sync::DiskResourceClient client(api);
+    const QString url = server.baseUrl() + QStringLiteral("/file");
+    const QString localPath = dir.filePath(QStringLiteral("bench.bin"));
+
+    BENCHMARK("single stream") {
+        return api.downloadToFile(url, localPath).statusCode;
+    };
+    BENCHMARK("4 segments") {
+        return downloadSegmented(client, url, localPath, data.size(), 4).success;
+    };
+    BENCHMARK("8 segments") {
+        return downloadSegmented(client, url, localPath, data.size(), 8).success;
+    };
+}
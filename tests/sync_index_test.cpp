@@ -1,8 +1,18 @@
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <sync/infrastructure/sync_index.hpp>
 #include <sync/domain/sync_file_status.hpp>
 #include <QCoreApplication>
+#include <QEventLoop>
+#include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QTemporaryDir>
+#include <QTimer>
+#include <QVariant>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
 using namespace ydisquette::sync;
 
@@ -23,7 +33,7 @@ TEST_CASE("SyncIndex create table, set, get, remove, removePrefix") {
     REQUIRE(e.has_value());
     REQUIRE(e->mtime_sec == 1000);
     REQUIRE(e->size == 500);
-    REQUIRE(e->status == QLatin1String(FileStatus::SYNCED));
+    REQUIRE(e->status == FileStatus::SYNCED);
     REQUIRE(e->retries == 0);
     REQUIRE(index.get(QStringLiteral("/other"), QStringLiteral("a/file.txt")) == std::nullopt);
     index.commit();
@@ -59,23 +69,61 @@ TEST_CASE("SyncIndex status, retries, setStatus, upsertNew") {
     REQUIRE(index.upsertNew(QStringLiteral("/home/sync"), QStringLiteral("new.txt"), 100, 200));
     auto e = index.get(QStringLiteral("/home/sync"), QStringLiteral("new.txt"));
     REQUIRE(e.has_value());
-    REQUIRE(e->status == QLatin1String(FileStatus::NEW));
+    REQUIRE(e->status == FileStatus::NEW);
     REQUIRE(e->retries == 0);
     REQUIRE(e->mtime_sec == 100);
     REQUIRE(e->size == 200);
-    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("new.txt"), QString::fromUtf8(FileStatus::UPLOADING), 0));
+    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("new.txt"), FileStatus::UPLOADING, 0));
     e = index.get(QStringLiteral("/home/sync"), QStringLiteral("new.txt"));
     REQUIRE(e.has_value());
-    REQUIRE(e->status == QLatin1String(FileStatus::UPLOADING));
-    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("new.txt"), QString::fromUtf8(FileStatus::FAILED), 1));
+    REQUIRE(e->status == FileStatus::UPLOADING);
+    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("new.txt"), FileStatus::FAILED, 1));
     e = index.get(QStringLiteral("/home/sync"), QStringLiteral("new.txt"));
     REQUIRE(e.has_value());
-    REQUIRE(e->status == QLatin1String(FileStatus::FAILED));
+    REQUIRE(e->status == FileStatus::FAILED);
     REQUIRE(e->retries == 1);
     index.commit();
     index.close();
 }
 
+TEST_CASE("SyncIndex accepts the loop transitions and rejects illegal ones") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    SyncIndex index;
+    REQUIRE(index.open(dir.filePath(QStringLiteral("sync_index.db"))));
+    REQUIRE(index.beginTransaction());
+    const QString root = QStringLiteral("/home/sync");
+    auto statusOf = [&](const QString& rel) { return index.get(root, rel)->status; };
+
+    REQUIRE(index.upsertNew(root, QStringLiteral("down.txt"), 0, 0));
+    REQUIRE(index.setStatus(root, QStringLiteral("down.txt"), FileStatus::DOWNLOADING));
+    REQUIRE(index.setStatus(root, QStringLiteral("down.txt"), FileStatus::TO_DOWNLOAD, 1));
+    REQUIRE(index.setStatus(root, QStringLiteral("down.txt"), FileStatus::DOWNLOADING));
+    REQUIRE(index.set(root, QStringLiteral("down.txt"), 10, 20, FileStatus::SYNCED, 0));
+    REQUIRE(statusOf(QStringLiteral("down.txt")) == FileStatus::SYNCED);
+
+    REQUIRE(index.upsertNew(root, QStringLiteral("up.txt"), 10, 20));
+    REQUIRE(index.setStatus(root, QStringLiteral("up.txt"), FileStatus::UPLOADING));
+    REQUIRE(index.set(root, QStringLiteral("up.txt"), 10, 20, FileStatus::SYNCED, 0));
+    REQUIRE(index.setStatus(root, QStringLiteral("up.txt"), FileStatus::UPLOADING, 1));
+    REQUIRE_FALSE(index.setStatus(root, QStringLiteral("up.txt"), FileStatus::TO_DOWNLOAD, 1));
+    REQUIRE(statusOf(QStringLiteral("up.txt")) == FileStatus::UPLOADING);
+
+    REQUIRE(index.setStatus(root, QStringLiteral("down.txt"), FileStatus::TO_DELETE));
+    REQUIRE_FALSE(index.setStatus(root, QStringLiteral("down.txt"), FileStatus::DOWNLOADING));
+    REQUIRE_FALSE(index.set(root, QStringLiteral("down.txt"), 10, 20, FileStatus::UPLOADING, 0));
+    REQUIRE(statusOf(QStringLiteral("down.txt")) == FileStatus::TO_DELETE);
+
+    REQUIRE(index.setStatus(root, QStringLiteral("up.txt"), FileStatus::CLOUD_DELETED));
+    REQUIRE_FALSE(index.setStatus(root, QStringLiteral("up.txt"), FileStatus::UPLOADING, 1));
+    REQUIRE(index.setStatus(root, QStringLiteral("up.txt"), FileStatus::DOWNLOADING));
+    REQUIRE(statusOf(QStringLiteral("up.txt")) == FileStatus::DOWNLOADING);
+    index.commit();
+    index.close();
+}
+
 TEST_CASE("normalizeSyncRoot") {
     REQUIRE(normalizeSyncRoot(QStringLiteral("  /home/user/sync/  ")) == QStringLiteral("/home/user/sync"));
     REQUIRE(normalizeSyncRoot(QStringLiteral("/home/user/sync")) == QStringLiteral("/home/user/sync"));
@@ -136,16 +184,489 @@ TEST_CASE("SyncIndex getRelativePathsWithStatus and setStatusPrefix TO_DELETE")
     index.set(QStringLiteral("/home/sync"), QStringLiteral("Photos/2024/b.jpg"), 2, 20);
     index.set(QStringLiteral("/home/sync"), QStringLiteral("Docs/readme.txt"), 3, 30);
     index.commit();
-    REQUIRE(index.getRelativePathsWithStatus(QStringLiteral("/home/sync"), QString::fromUtf8(FileStatus::TO_DELETE)).isEmpty());
-    REQUIRE(index.setStatusPrefix(QStringLiteral("/home/sync"), QStringLiteral("Photos"), QString::fromUtf8(FileStatus::TO_DELETE)));
-    QStringList toDel = index.getRelativePathsWithStatus(QStringLiteral("/home/sync"), QString::fromUtf8(FileStatus::TO_DELETE));
+    REQUIRE(index.getRelativePathsWithStatus(QStringLiteral("/home/sync"), FileStatus::TO_DELETE).isEmpty());
+    REQUIRE(index.setStatusPrefix(QStringLiteral("/home/sync"), QStringLiteral("Photos"), FileStatus::TO_DELETE));
+    QStringList toDel = index.getRelativePathsWithStatus(QStringLiteral("/home/sync"), FileStatus::TO_DELETE);
     REQUIRE(toDel.size() == 2);
     REQUIRE(toDel.contains(QStringLiteral("Photos/a.jpg")));
     REQUIRE(toDel.contains(QStringLiteral("Photos/2024/b.jpg")));
-    REQUIRE(index.get(QStringLiteral("/home/sync"), QStringLiteral("Docs/readme.txt"))->status == QLatin1String(FileStatus::SYNCED));
-    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("Docs/readme.txt"), QString::fromUtf8(FileStatus::TO_DELETE), 0));
-    toDel = index.getRelativePathsWithStatus(QStringLiteral("/home/sync"), QString::fromUtf8(FileStatus::TO_DELETE));
+    REQUIRE(index.get(QStringLiteral("/home/sync"), QStringLiteral("Docs/readme.txt"))->status == FileStatus::SYNCED);
+    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("Docs/readme.txt"), FileStatus::TO_DELETE, 0));
+    toDel = index.getRelativePathsWithStatus(QStringLiteral("/home/sync"), FileStatus::TO_DELETE);
     REQUIRE(toDel.size() == 3);
     index.commit();
     index.close();
 }
+
+TEST_CASE("SyncIndex setPartial survives status changes and is cleared by set") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+    SyncIndex index;
+    REQUIRE(index.open(dbPath));
+    REQUIRE(index.beginTransaction());
+    REQUIRE(index.upsertNew(QStringLiteral("/home/sync"), QStringLiteral("big.iso"), 0, 0));
+    auto e = index.get(QStringLiteral("/home/sync"), QStringLiteral("big.iso"));
+    REQUIRE(e.has_value());
+    REQUIRE(e->part_offset == 0);
+    REQUIRE(e->part_remote_size == 0);
+    REQUIRE(index.setPartial(QStringLiteral("/home/sync"), QStringLiteral("big.iso"), 4096, 1 << 20));
+    REQUIRE(index.setStatus(QStringLiteral("/home/sync"), QStringLiteral("big.iso"), FileStatus::TO_DOWNLOAD, 1));
+    index.commit();
+    index.close();
+
+    REQUIRE(index.open(dbPath));
+    e = index.get(QStringLiteral("/home/sync"), QStringLiteral("big.iso"));
+    REQUIRE(e.has_value());
+    REQUIRE(e->part_offset == 4096);
+    REQUIRE(e->part_remote_size == (1 << 20));
+    REQUIRE(e->status == FileStatus::TO_DOWNLOAD);
+    REQUIRE(index.beginTransaction());
+    REQUIRE(index.set(QStringLiteral("/home/sync"), QStringLiteral("big.iso"), 10, 1 << 20,
+                      FileStatus::SYNCED, 0));
+    e = index.get(QStringLiteral("/home/sync"), QStringLiteral("big.iso"));
+    REQUIRE(e->part_offset == 0);
+    REQUIRE(e->part_remote_size == 0);
+    index.commit();
+    index.close();
+}
+
+TEST_CASE("SyncIndex insertMissing bulk-inserts rows and keeps existing ones") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    SyncIndex index;
+    REQUIRE(index.open(dir.filePath(QStringLiteral("sync_index.db"))));
+    REQUIRE(index.beginTransaction());
+    const QString root = QStringLiteral("/root");
+    REQUIRE(index.set(root, QStringLiteral("a/kept.txt"), 1, 10, FileStatus::SYNCED, 0));
+
+    QVector<SyncIndexRow> rows;
+    rows.append({QStringLiteral("a/kept.txt"), 99, 99});
+    rows.append({QStringLiteral("/a/new1.txt"), 2, 20});
+    rows.append({QStringLiteral("b/new2.txt"), 3, 30});
+    REQUIRE(index.insertMissing(root, rows, FileStatus::TO_DOWNLOAD));
+    REQUIRE(index.insertMissing(root, {}, FileStatus::TO_DOWNLOAD));
+    REQUIRE(index.commit());
+
+    auto kept = index.get(root, QStringLiteral("a/kept.txt"));
+    REQUIRE(kept.has_value());
+    REQUIRE(kept->size == 10);
+    REQUIRE(kept->status == FileStatus::SYNCED);
+    auto added = index.get(root, QStringLiteral("a/new1.txt"));
+    REQUIRE(added.has_value());
+    REQUIRE(added->mtime_sec == 2);
+    REQUIRE(added->status == FileStatus::TO_DOWNLOAD);
+    REQUIRE(index.getRelativePathsWithStatus(root, FileStatus::TO_DOWNLOAD).size() == 2);
+    index.close();
+}
+
+TEST_CASE("SyncIndex group commit batches flushes and keeps flushed rows on rollback") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+    const QString root = QStringLiteral("/root");
+    SyncIndex index;
+    REQUIRE(index.open(dbPath));
+    index.setCommitPolicy({3, 60000});
+    REQUIRE(index.beginBatch());
+
+    REQUIRE(index.set(root, QStringLiteral("a.txt"), 1, 1));
+    REQUIRE(index.flushBatched());
+    REQUIRE(index.set(root, QStringLiteral("b.txt"), 2, 2));
+    REQUIRE(index.flushBatched());
+    REQUIRE(readIndexState(dbPath).totalEntries == 0);
+    REQUIRE(index.set(root, QStringLiteral("c.txt"), 3, 3));
+    REQUIRE(index.flushBatched());
+    REQUIRE(readIndexState(dbPath).totalEntries == 3);
+
+    REQUIRE(index.set(root, QStringLiteral("d.txt"), 4, 4));
+    REQUIRE(index.flushBatched());
+    REQUIRE(index.set(root, QStringLiteral("unflushed.txt"), 5, 5));
+    REQUIRE(index.rollback());
+    REQUIRE(index.get(root, QStringLiteral("d.txt")).has_value());
+    REQUIRE_FALSE(index.get(root, QStringLiteral("unflushed.txt")).has_value());
+
+    index.setCommitPolicy({1, 0});
+    REQUIRE(index.beginBatch());
+    REQUIRE(index.set(root, QStringLiteral("e.txt"), 6, 6));
+    REQUIRE(index.flushBatched());
+    REQUIRE(readIndexState(dbPath).totalEntries == 5);
+    index.commit();
+    index.close();
+}
+
+TEST_CASE("SyncIndex batch timer commits an open batch while the loop waits") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+    const QString root = QStringLiteral("/root");
+    SyncIndex index;
+    REQUIRE(index.open(dbPath));
+    index.setCommitPolicy({64, 20});
+    REQUIRE(index.beginBatch());
+    REQUIRE(index.set(root, QStringLiteral("a.txt"), 1, 1, FileStatus::DOWNLOADING));
+    REQUIRE(readIndexState(dbPath).totalEntries == 0);
+
+    QEventLoop loop;
+    QTimer::singleShot(200, &loop, &QEventLoop::quit);
+    loop.exec();
+    REQUIRE(readIndexState(dbPath).totalEntries == 1);
+
+    REQUIRE(index.setStatus(root, QStringLiteral("a.txt"), FileStatus::SYNCED));
+    REQUIRE(index.flushBatched());
+    REQUIRE(index.rollback());
+    REQUIRE(index.get(root, QStringLiteral("a.txt"))->status == FileStatus::SYNCED);
+    index.close();
+}
+
+TEST_CASE("SyncIndex migrates text statuses to integer codes") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+    const QString legacyName = QStringLiteral("sync_index_legacy");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), legacyName);
+        db.setDatabaseName(dbPath);
+        REQUIRE(db.open());
+        QSqlQuery q(db);
+        REQUIRE(q.exec(QStringLiteral(
+            "CREATE TABLE sync_state (sync_root TEXT NOT NULL, relative_path TEXT NOT NULL,"
+            "mtime_sec INTEGER NOT NULL, size INTEGER NOT NULL, updated_at INTEGER,"
+            "status TEXT NOT NULL DEFAULT 'SYNCED', retries INTEGER NOT NULL DEFAULT 0,"
+            "PRIMARY KEY (sync_root, relative_path))")));
+        REQUIRE(q.exec(QStringLiteral(
+            "INSERT INTO sync_state (sync_root, relative_path, mtime_sec, size, updated_at, status, retries) VALUES "
+            "('/root', 'a.txt', 1, 10, 5, 'TO_DOWNLOAD', 2), ('/root', 'b.txt', 2, 20, 5, 'CLOUD_DELETED', 0),"
+            "('/root', 'c.txt', 3, 30, 5, 'SYNCED', 0), ('/root', 'd.txt', 4, 40, 5, 'bogus', 0)")));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(legacyName);
+
+    SyncIndex index;
+    REQUIRE(index.open(dbPath));
+    auto a = index.get(QStringLiteral("/root"), QStringLiteral("a.txt"));
+    REQUIRE(a.has_value());
+    REQUIRE(a->status == FileStatus::TO_DOWNLOAD);
+    REQUIRE(a->retries == 2);
+    REQUIRE(a->size == 10);
+    REQUIRE(a->part_offset == 0);
+    REQUIRE(index.get(QStringLiteral("/root"), QStringLiteral("b.txt"))->status == FileStatus::CLOUD_DELETED);
+    REQUIRE(index.get(QStringLiteral("/root"), QStringLiteral("d.txt"))->status == FileStatus::SYNCED);
+    REQUIRE(index.getRelativePathsWithStatus(QStringLiteral("/root"), FileStatus::TO_DOWNLOAD) == QStringList{QStringLiteral("a.txt")});
+    index.close();
+
+    const IndexState state = readIndexState(dbPath, QStringLiteral("/root"));
+    REQUIRE(state.totalEntries == 4);
+    REQUIRE(state.toDownloadCount == 1);
+    REQUIRE(state.cloudDeletedCount == 1);
+    REQUIRE(state.toDeleteCount == 0);
+
+    const QString checkName = QStringLiteral("sync_index_schema_check");
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), checkName);
+        db.setDatabaseName(dbPath);
+        REQUIRE(db.open());
+        QSqlQuery q(db);
+        REQUIRE(q.exec(QStringLiteral("SELECT type FROM pragma_table_info('sync_state') WHERE name = 'status'")));
+        REQUIRE(q.next());
+        REQUIRE(q.value(0).toString() == QLatin1String("INTEGER"));
+        REQUIRE(q.exec(QStringLiteral("EXPLAIN QUERY PLAN SELECT relative_path FROM sync_state WHERE sync_root = '/root' AND status = 2")));
+        REQUIRE(q.next());
+        REQUIRE(q.value(3).toString().contains(QLatin1String("idx_sync_state_status")));
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(checkName);
+}
+
+TEST_CASE("SyncIndex prefix queries match whole path components literally") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString root = QStringLiteral("/root");
+    SyncIndex index;
+    REQUIRE(index.open(dir.filePath(QStringLiteral("sync_index.db"))));
+    for (const char* rel : {"50%_off", "50%_off/a.txt", "50xyoff/b.txt", "Dir/c.txt", "dir-x/d.txt", "dir.txt",
+                            "dir/e.txt", "dir/sub/f.txt", "dirt/g.txt"})
+        REQUIRE(index.set(root, QString::fromUtf8(rel), 1, 1));
+
+    REQUIRE(index.hasAnyWithPrefix(root, QStringLiteral("50%_off")));
+    REQUIRE_FALSE(index.hasAnyWithPrefix(root, QStringLiteral("50%")));
+    REQUIRE_FALSE(index.hasAnyWithPrefix(root, QStringLiteral("di")));
+    REQUIRE_FALSE(index.hasAnyWithPrefix(root, QStringLiteral("DIR/sub")));
+    REQUIRE(index.hasAnyWithPrefix(root, QStringLiteral("dir/sub")));
+
+    QStringList under = index.getRelativePathsUnderPrefixExcept(root, QStringLiteral("dir"), {QStringLiteral("dir/sub")});
+    REQUIRE(under == QStringList{QStringLiteral("dir/e.txt")});
+    under = index.getRelativePathsUnderPrefixExcept(root, QStringLiteral("50%_off"), {});
+    under.sort();
+    REQUIRE(under == QStringList({QStringLiteral("50%_off"), QStringLiteral("50%_off/a.txt")}));
+
+    REQUIRE(index.setStatusPrefix(root, QStringLiteral("dir/"), FileStatus::TO_DELETE));
+    REQUIRE(index.hasAnyUnderPrefixWithStatus(root, QStringLiteral("dir"), {FileStatus::TO_DELETE}));
+    REQUIRE_FALSE(index.hasAnyUnderPrefixWithStatus(root, QStringLiteral("Dir"), {FileStatus::TO_DELETE}));
+    REQUIRE(index.get(root, QStringLiteral("dir.txt"))->status == FileStatus::SYNCED);
+
+    REQUIRE(index.removePrefix(root, QStringLiteral("50%_off")));
+    REQUIRE(index.get(root, QStringLiteral("50xyoff/b.txt")).has_value());
+    REQUIRE_FALSE(index.hasAnyWithPrefix(root, QStringLiteral("50%_off")));
+    REQUIRE(index.removePrefix(root, QStringLiteral("dir")));
+    REQUIRE(index.get(root, QStringLiteral("dir-x/d.txt")).has_value());
+    REQUIRE(index.get(root, QStringLiteral("dirt/g.txt")).has_value());
+    REQUIRE(index.get(root, QStringLiteral("Dir/c.txt")).has_value());
+    REQUIRE_FALSE(index.get(root, QStringLiteral("dir/sub/f.txt")).has_value());
+    index.close();
+}
+
+TEST_CASE("SyncIndex readers and a writer share the WAL index concurrently") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+    const QString root = QStringLiteral("/root");
+    const int rowCount = 2000;
+    {
+        SyncIndex setup;
+        REQUIRE(setup.open(dbPath));
+    }
+    {
+        const QString checkName = QStringLiteral("sync_index_wal_check");
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), checkName);
+            db.setDatabaseName(dbPath);
+            REQUIRE(db.open());
+            QSqlQuery q(db);
+            REQUIRE(q.exec(QStringLiteral("PRAGMA journal_mode")));
+            REQUIRE(q.next());
+            REQUIRE(q.value(0).toString() == QLatin1String("wal"));
+        }
+        QSqlDatabase::removeDatabase(checkName);
+    }
+
+    std::atomic<bool> writerDone{false};
+    std::atomic<int> writeFailures{0};
+    std::atomic<int> readFailures{0};
+    std::atomic<int> reads{0};
+
+    std::thread writer([&] {
+        SyncIndex index;
+        index.setCommitPolicy({16, 50});
+        if (!index.open(dbPath) || !index.beginBatch()) {
+            ++writeFailures;
+            writerDone = true;
+            return;
+        }
+        for (int i = 0; i < rowCount; ++i) {
+            const QString rel = QStringLiteral("dir%1/file%2").arg(i % 20).arg(i);
+            if (!index.set(root, rel, i, i, FileStatus::TO_DOWNLOAD)
+                || !index.setStatus(root, rel, FileStatus::SYNCED)
+                || !index.flushBatched())
+                ++writeFailures;
+        }
+        if (!index.commit()) ++writeFailures;
+        index.close();
+        writerDone = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&, t] {
+            SyncIndex index;
+            if (!index.open(dbPath)) {
+                ++readFailures;
+                return;
+            }
+            int lastTotal = 0;
+            while (!writerDone) {
+                if (t % 2 == 0) {
+                    const IndexState state = readIndexState(dbPath, root);
+                    if (state.totalEntries < lastTotal || state.summary.startsWith(QLatin1Char('(')))
+                        ++readFailures;
+                    lastTotal = state.totalEntries;
+                } else {
+                    auto e = index.get(root, QStringLiteral("dir0/file0"));
+                    if (e && e->status != FileStatus::SYNCED) ++readFailures;
+                    index.hasAnyWithPrefix(root, QStringLiteral("dir1"));
+                }
+                ++reads;
+            }
+            index.close();
+        });
+    }
+
+    writer.join();
+    for (std::thread& r : readers)
+        r.join();
+
+    REQUIRE(writeFailures == 0);
+    REQUIRE(readFailures == 0);
+    REQUIRE(reads > 0);
+    const IndexState state = readIndexState(dbPath, root);
+    REQUIRE(state.totalEntries == rowCount);
+    REQUIRE(state.toDownloadCount == 0);
+}
+
+TEST_CASE("SyncIndex operations on a 1M-row index", "[.][benchmark]") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+    const QString root = QStringLiteral("/root");
+    const int rowCount = 1000000;
+    const int opsPerRun = 1000;
+    auto pathFor = [](int i) {
+        return QStringLiteral("dir%1/file%2.jpg").arg(i / 1000).arg(i);
+    };
+
+    SyncIndex index;
+    REQUIRE(index.open(dbPath));
+    REQUIRE(index.beginTransaction());
+    QVector<SyncIndexRow> rows;
+    for (int i = 0; i < rowCount; ++i) {
+        rows.append({pathFor(i), i, i});
+        if (rows.size() == 10000) {
+            REQUIRE(index.insertMissing(root, rows, FileStatus::SYNCED));
+            rows.clear();
+        }
+    }
+    REQUIRE(index.commit());
+
+    QVector<QString> keys;
+    quint32 seed = 12345;
+    for (int i = 0; i < opsPerRun; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        keys.append(pathFor(static_cast<int>(seed % rowCount)));
+    }
+
+    const QString baselineName = QStringLiteral("sync_index_bench_baseline");
+    {
+        QSqlDatabase baseline = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), baselineName);
+        baseline.setDatabaseName(dbPath);
+        REQUIRE(baseline.open());
+
+        BENCHMARK("get, prepare per call (1000 ops)") {
+            int found = 0;
+            for (const QString& key : keys) {
+                QSqlQuery q(baseline);
+                q.prepare(QStringLiteral("SELECT mtime_sec, size, status, retries, updated_at, part_offset, part_remote_size FROM sync_state WHERE sync_root = ? AND relative_path = ?"));
+                q.addBindValue(root);
+                q.addBindValue(key);
+                if (q.exec() && q.next()) ++found;
+            }
+            return found;
+        };
+        BENCHMARK("get, cached statement (1000 ops)") {
+            int found = 0;
+            for (const QString& key : keys)
+                if (index.get(root, key)) ++found;
+            return found;
+        };
+        BENCHMARK("setStatus, prepare per call (1000 ops)") {
+            baseline.transaction();
+            for (const QString& key : keys) {
+                QSqlQuery q(baseline);
+                q.prepare(QStringLiteral("UPDATE sync_state SET status = ?, updated_at = ? WHERE sync_root = ? AND relative_path = ?"));
+                q.addBindValue(static_cast<int>(FileStatus::UPLOADING));
+                q.addBindValue(1);
+                q.addBindValue(root);
+                q.addBindValue(key);
+                q.exec();
+            }
+            return baseline.commit();
+        };
+        BENCHMARK("setStatus, cached statement (1000 ops)") {
+            index.beginTransaction();
+            for (const QString& key : keys)
+                index.setStatus(root, key, FileStatus::UPLOADING);
+            return index.commit();
+        };
+        BENCHMARK("hasAnyWithPrefix, cached statement (1000 ops)") {
+            int found = 0;
+            for (const QString& key : keys)
+                if (index.hasAnyWithPrefix(root, key.section(QLatin1Char('/'), 0, 0))) ++found;
+            return found;
+        };
+        baseline.close();
+    }
+    QSqlDatabase::removeDatabase(baselineName);
+    index.close();
+}
+
+TEST_CASE("SyncIndex prefix lookups as the index grows", "[.][benchmark]") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    const QString root = QStringLiteral("/root");
+
+    for (int rowCount : {10000, 100000, 1000000}) {
+        QTemporaryDir dir;
+        REQUIRE(dir.isValid());
+        const QString dbPath = dir.filePath(QStringLiteral("sync_index.db"));
+        SyncIndex index;
+        REQUIRE(index.open(dbPath));
+        REQUIRE(index.beginTransaction());
+        QVector<SyncIndexRow> rows;
+        for (int i = 0; i < rowCount; ++i) {
+            rows.append({QStringLiteral("dir%1/file%2.jpg").arg(i / 100).arg(i), i, i});
+            if (rows.size() == 10000) {
+                REQUIRE(index.insertMissing(root, rows, FileStatus::SYNCED));
+                rows.clear();
+            }
+        }
+        REQUIRE(index.insertMissing(root, rows, FileStatus::SYNCED));
+        REQUIRE(index.commit());
+
+        QStringList prefixes;
+        for (int i = 0; i < 100; ++i)
+            prefixes.append(QStringLiteral("dir%1").arg((i * 7919) % (rowCount / 100) + (i % 2 ? rowCount : 0)));
+
+        const QString baselineName = QStringLiteral("sync_index_prefix_baseline");
+        {
+            QSqlDatabase baseline = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), baselineName);
+            baseline.setDatabaseName(dbPath);
+            REQUIRE(baseline.open());
+            QSqlQuery like(baseline);
+            REQUIRE(like.prepare(QStringLiteral("SELECT 1 FROM sync_state WHERE sync_root = ? AND (relative_path = ? OR relative_path LIKE ?) LIMIT 1")));
+
+            BENCHMARK("LIKE prefix, " + std::to_string(rowCount) + " rows (100 ops)") {
+                int found = 0;
+                for (const QString& prefix : prefixes) {
+                    like.bindValue(0, root);
+                    like.bindValue(1, prefix);
+                    like.bindValue(2, prefix + QStringLiteral("/%"));
+                    if (like.exec() && like.next()) ++found;
+                    like.finish();
+                }
+                return found;
+            };
+            BENCHMARK("range prefix, " + std::to_string(rowCount) + " rows (100 ops)") {
+                int found = 0;
+                for (const QString& prefix : prefixes)
+                    if (index.hasAnyWithPrefix(root, prefix)) ++found;
+                return found;
+            };
+            like.clear();
+            baseline.close();
+        }
+        QSqlDatabase::removeDatabase(baselineName);
+        index.close();
+    }
+}
@@ -14,3 +14,24 @@ TEST_CASE("localPathToRelative strips sync root prefix") {
     REQUIRE(localPathToRelative(QStringLiteral("/other/path"), syncRoot).isEmpty());
     REQUIRE(localPathToRelative(QStringLiteral("/home/user/syncx"), syncRoot).isEmpty());
 }
+
+TEST_CASE("partialDownloadPath round-trips through isPartialDownloadPath") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    QString part = partialDownloadPath(QStringLiteral("/home/user/sync/video.mkv"));
+    REQUIRE(part != QStringLiteral("/home/user/sync/video.mkv"));
+    REQUIRE(part.startsWith(QStringLiteral("/home/user/sync/video.mkv")));
+    REQUIRE(isPartialDownloadPath(part));
+    REQUIRE(partialDownloadTarget(part) == QStringLiteral("/home/user/sync/video.mkv"));
+    REQUIRE(partialDownloadTarget(QStringLiteral("plain.txt")) == QStringLiteral("plain.txt"));
+    REQUIRE_FALSE(isPartialDownloadPath(QStringLiteral("/home/user/sync/video.mkv")));
+    REQUIRE_FALSE(isPartialDownloadPath(QStringLiteral("/home/user/sync/archive.part")));
+}
+
+TEST_CASE("tempUploadPath is recognised by isTempUploadPath") {
+    const std::string tmp = tempUploadPath("/Docs/report.pdf");
+    REQUIRE(tmp.rfind("/Docs/report.pdf", 0) == 0);
+    REQUIRE(isTempUploadPath(QString::fromStdString(tmp)));
+    REQUIRE(isTempUploadPath(QStringLiteral("disk:/Docs/report.pdf.tmp-upload")));
+    REQUIRE_FALSE(isTempUploadPath(QStringLiteral("disk:/Docs/report.pdf")));
+}
@@ -0,0 +1,83 @@
+#include <catch2/catch_test_macros.hpp>
+#include "auth/infrastructure/yandex_disk_api_client.hpp"
+#include "sync/application/temp_upload_janitor.hpp"
+#include "local_http_server.hpp"
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QSet>
+#include <QUrl>
+#include <QUrlQuery>
+
+using namespace ydisquette;
+
+namespace {
+
+struct StaticTokenProvider : auth::ITokenProvider {
+    std::optional<std::string> getAccessToken() const override { return std::string("test-token"); }
+};
+
+struct FakeDisk {
+    QList<QByteArray> files;
+    QSet<QByteArray> deleted;
+
+    test::LocalHttpServer::Response serve(const test::LocalHttpServer::Request& req) {
+        const QUrl url(QString::fromUtf8(req.target));
+        const QUrlQuery q(url);
+        test::LocalHttpServer::Response r;
+        if (req.method == "DELETE") {
+            QByteArray path = q.queryItemValue(QStringLiteral("path"), QUrl::FullyDecoded).toUtf8();
+            if (!path.startsWith("disk:")) path = "disk:" + path;
+            if (!files.contains(path) || deleted.contains(path)) {
+                r.status = 404;
+                r.body = "{}";
+                return r;
+            }
+            deleted.insert(path);
+            r.status = 204;
+            return r;
+        }
+        const int limit = q.queryItemValue(QStringLiteral("limit")).toInt();
+        const int offset = q.queryItemValue(QStringLiteral("offset")).toInt();
+        QByteArray items;
+        for (const QByteArray& f : files.mid(offset, limit)) {
+            if (!items.isEmpty()) items += ',';
+            items += R"({"path":")" + f + R"("})";
+        }
+        r.body = R"({"items":[)" + items + "]}";
+        return r;
+    }
+};
+
+}  // namespace
+
+TEST_CASE("Temp upload sweep only deletes orphans under the sync roots") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    FakeDisk disk;
+    disk.files = {"disk:/Docs/a.txt",
+                  "disk:/Docs/a.txt.tmp-upload",
+                  "disk:/Docs/sub/b.bin.tmp-upload",
+                  "disk:/Docs2/c.txt.tmp-upload",
+                  "disk:/Other/d.txt.tmp-upload",
+                  "disk:/e.txt.tmp-upload"};
+    test::LocalHttpServer server([&disk](const test::LocalHttpServer::Request& req) { return disk.serve(req); });
+    REQUIRE(server.isListening());
+
+    StaticTokenProvider tokens;
+    QNetworkAccessManager nam;
+    auth::YandexDiskApiClient api(tokens, &nam);
+    api.setBaseUrl(server.baseUrl());
+    sync::DiskResourceClient client(api);
+
+    sync::TempUploadSweep sweep = sync::TempUploadJanitor::run(client, {"disk:/Docs"}, std::function<bool()>(), 2);
+    REQUIRE(sweep.complete);
+    REQUIRE(sweep.scanned == disk.files.size());
+    REQUIRE(sweep.removed == 2);
+    REQUIRE(sweep.failed == 0);
+    REQUIRE(disk.deleted.contains("disk:/Docs/a.txt.tmp-upload"));
+    REQUIRE(disk.deleted.contains("disk:/Docs/sub/b.bin.tmp-upload"));
+    REQUIRE_FALSE(disk.deleted.contains("disk:/Docs2/c.txt.tmp-upload"));
+    REQUIRE_FALSE(disk.deleted.contains("disk:/Other/d.txt.tmp-upload"));
+    REQUIRE_FALSE(disk.deleted.contains("disk:/e.txt.tmp-upload"));
+    REQUIRE_FALSE(disk.deleted.contains("disk:/Docs/a.txt"));
+}
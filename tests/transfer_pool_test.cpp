@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+#include "sync/infrastructure/transfer_pool.hpp"
+#include <QCoreApplication>
+#include <QTimer>
+#include <algorithm>
+#include <vector>
+
+using namespace ydisquette::sync;
+
+TEST_CASE("TransferPool keeps at most maxParallel jobs in flight") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    TransferPool pool(3);
+    int inFlight = 0;
+    int peak = 0;
+    int finished = 0;
+    for (int i = 0; i < 10; ++i) {
+        pool.enqueue([&](TransferPool::Done done) {
+            ++inFlight;
+            peak = std::max(peak, inFlight);
+            QTimer::singleShot(5, [&, done]() {
+                --inFlight;
+                ++finished;
+                done();
+            });
+        });
+    }
+    REQUIRE(pool.waitForIdle([]() { return false; }));
+    REQUIRE(finished == 10);
+    REQUIRE(peak == 3);
+    REQUIRE(pool.isIdle());
+}
+
+TEST_CASE("TransferPool drops pending jobs when stop is requested") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    TransferPool pool(1);
+    int started = 0;
+    bool stop = false;
+    for (int i = 0; i < 5; ++i) {
+        pool.enqueue([&](TransferPool::Done done) {
+            ++started;
+            stop = true;
+            QTimer::singleShot(5, [done]() { done(); });
+        });
+    }
+    REQUIRE_FALSE(pool.waitForIdle([&stop]() { return stop; }));
+    REQUIRE(started == 1);
+    REQUIRE(pool.isIdle());
+}
+
+TEST_CASE("TransferPool ignores a second done() from the same job") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    TransferPool pool(1);
+    int started = 0;
+    for (int i = 0; i < 2; ++i) {
+        pool.enqueue([&](TransferPool::Done done) {
+            ++started;
+            done();
+            done();
+        });
+    }
+    REQUIRE(pool.waitForIdle([]() { return false; }));
+    REQUIRE(started == 2);
+}
+
+TEST_CASE("TransferPool prefetches queued jobs up to the prefetch depth") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+
+    TransferPool pool(1);
+    pool.setPrefetchDepth(2);
+    std::vector<int> prefetched;
+    std::vector<TransferPool::Done> held;
+    for (int i = 0; i < 5; ++i) {
+        pool.enqueue([&held](TransferPool::Done done) { held.push_back(done); },
+                     [&prefetched, i]() { prefetched.push_back(i); });
+    }
+    REQUIRE(held.size() == 1);
+    REQUIRE(prefetched == std::vector<int>{1, 2});
+    held.back()();
+    REQUIRE(held.size() == 2);
+    REQUIRE(prefetched == std::vector<int>{1, 2, 3});
+    while (!pool.isIdle())
+        held.back()();
+    REQUIRE(prefetched == std::vector<int>{1, 2, 3, 4});
+}
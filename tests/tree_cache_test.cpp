@@ -0,0 +1,158 @@
+#include <catch2/catch_test_macros.hpp>
+#include "disk_tree/infrastructure/caching_tree_repository.hpp"
+#include "disk_tree/infrastructure/tree_cache_store.hpp"
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QVariant>
+#include <map>
+
+using namespace ydisquette;
+using disk_tree::CachingTreeRepository;
+using disk_tree::ChildrenPage;
+using disk_tree::Node;
+using disk_tree::TreeCacheStore;
+
+namespace {
+
+struct CountingTree : disk_tree::ITreeRepository {
+    std::map<std::string, std::vector<std::shared_ptr<Node>>> dirs;
+    int calls = 0;
+    bool fail = false;
+
+    std::shared_ptr<Node> getRoot() override { return Node::makeDir("/", ""); }
+    disk_tree::NodeList getChildren(const std::string& path) override { return disk_tree::NodeList::fromNodes(dirs[path]); }
+    void getChildrenAsync(const std::string& path, std::function<void(disk_tree::NodeList)> cb) override {
+        cb(getChildren(path));
+    }
+    void getChildrenPagedAsync(const std::string& path, std::function<void(ChildrenPage)> onPage) override {
+        ++calls;
+        const bool ok = !fail;
+        disk_tree::NodeList items = ok ? disk_tree::NodeList::fromNodes(dirs[path]) : disk_tree::NodeList();
+        QTimer::singleShot(1, [onPage, items, ok]() { onPage({items, true, ok}); });
+    }
+};
+
+disk_tree::NodeList list(disk_tree::ITreeRepository& repo, const std::string& path) {
+    disk_tree::NodeList out;
+    QEventLoop loop;
+    repo.getChildrenAsync(path, [&](disk_tree::NodeList children) {
+        out = std::move(children);
+        loop.quit();
+    });
+    loop.exec();
+    return out;
+}
+
+void drain() {
+    QEventLoop loop;
+    QTimer::singleShot(20, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+}  // namespace
+
+TEST_CASE("Repeat listings are served from the tree cache") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    CountingTree tree;
+    tree.dirs["/a"] = {Node::makeFile("/a/f.txt", "f.txt", 3)};
+    CachingTreeRepository repo(tree, nullptr);
+
+    REQUIRE(list(repo, "/a").size() == 1);
+    REQUIRE(list(repo, "disk:/a/").size() == 1);
+    REQUIRE(repo.getChildren("/a").size() == 1);
+    REQUIRE(tree.calls == 1);
+    REQUIRE(repo.hitCount() == 2);
+    REQUIRE(repo.missCount() == 1);
+}
+
+TEST_CASE("Stale listings are served at once and revalidated in the background") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    CountingTree tree;
+    tree.dirs["/a"] = {Node::makeFile("/a/f.txt", "f.txt", 3)};
+    CachingTreeRepository repo(tree, nullptr);
+    std::vector<std::string> revalidated;
+    repo.setOnRevalidated([&](const std::string& path) { revalidated.push_back(path); });
+
+    REQUIRE(list(repo, "/a").size() == 1);
+    tree.dirs["/a"].push_back(Node::makeFile("/a/g.txt", "g.txt", 4));
+    drain();
+    repo.markAllStale();
+
+    std::vector<size_t> served;
+    repo.getChildrenAsync("/a", [&](disk_tree::NodeList c) { served.push_back(c.size()); });
+    repo.getChildrenAsync("/a", [&](disk_tree::NodeList c) { served.push_back(c.size()); });
+    drain();
+    REQUIRE(served == std::vector<size_t>{1, 1});
+    REQUIRE(tree.calls == 2);
+    REQUIRE(repo.revalidationCount() == 1);
+    REQUIRE(revalidated == std::vector<std::string>{"/a"});
+    REQUIRE(list(repo, "/a").size() == 2);
+    REQUIRE(tree.calls == 2);
+}
+
+TEST_CASE("Failed listings are not cached and invalidate drops the parent listing") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    CountingTree tree;
+    tree.dirs["/"] = {Node::makeDir("/a", "a")};
+    CachingTreeRepository repo(tree, nullptr);
+
+    tree.fail = true;
+    REQUIRE(list(repo, "/").empty());
+    tree.fail = false;
+    REQUIRE(list(repo, "/").size() == 1);
+    REQUIRE(tree.calls == 2);
+
+    tree.dirs["/"].push_back(Node::makeDir("/b", "b"));
+    repo.invalidate("/b");
+    REQUIRE(list(repo, "/").size() == 2);
+    REQUIRE(tree.calls == 3);
+}
+
+TEST_CASE("Tree cache persists across instances and is filled by write-through listings") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString dbPath = TreeCacheStore::pathNextTo(dir.filePath(QStringLiteral("sync_index.db")));
+    CountingTree tree;
+    tree.dirs["/a"] = {Node::makeDir("/a/sub", "sub"), Node::makeFile("/a/f.txt", "f.txt", 42, "2024-01-02T03:04:05+00:00")};
+
+    {
+        TreeCacheStore store;
+        REQUIRE(store.open(dbPath));
+        CachingTreeRepository syncSide(tree, &store, 0);
+        REQUIRE(list(syncSide, "/a").size() == 2);
+        REQUIRE(list(syncSide, "/a").size() == 2);
+        REQUIRE(tree.calls == 2);
+    }
+
+    TreeCacheStore store;
+    REQUIRE(store.open(dbPath));
+    CachingTreeRepository uiSide(tree, &store);
+    auto children = list(uiSide, "/a");
+    REQUIRE(tree.calls == 2);
+    REQUIRE(children.size() == 2);
+    REQUIRE(children[0]->isDir());
+    REQUIRE(children[0]->path == "/a/sub");
+    REQUIRE(children[1]->isFile());
+    REQUIRE(children[1]->size == 42);
+    REQUIRE(children[1]->modified == "2024-01-02T03:04:05+00:00");
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase(QStringLiteral("QSQLITE"), QStringLiteral("tree_cache_wal_check"));
+        db.setDatabaseName(dbPath);
+        REQUIRE(db.open());
+        QSqlQuery q(db);
+        REQUIRE(q.exec(QStringLiteral("PRAGMA journal_mode")));
+        REQUIRE(q.next());
+        REQUIRE(q.value(0).toString() == QLatin1String("wal"));
+    }
+    QSqlDatabase::removeDatabase(QStringLiteral("tree_cache_wal_check"));
+}
@@ -0,0 +1,149 @@
+#include <catch2/catch_test_macros.hpp>
+#include "sync/infrastructure/tree_walker.hpp"
+#include <QCoreApplication>
+#include <QTimer>
+#include <algorithm>
+#include <map>
+#include <set>
+
+using namespace ydisquette;
+using ydisquette::sync::TreeWalker;
+
+namespace {
+
+struct FakeTree : disk_tree::ITreeRepository {
+    std::map<std::string, std::vector<std::shared_ptr<disk_tree::Node>>> dirs;
+    bool async = true;
+    int inFlight = 0;
+    int peak = 0;
+
+    FakeTree(int fanout, int depth) { build("/", fanout, depth); }
+
+    void build(const std::string& path, int fanout, int depth) {
+        auto& children = dirs[path];
+        children.push_back(disk_tree::Node::makeFile(path + "/file", "file", 1));
+        if (depth == 0) return;
+        for (int i = 0; i < fanout; ++i) {
+            const std::string child = (path == "/" ? "" : path) + "/d" + std::to_string(i);
+            children.push_back(disk_tree::Node::makeDir(child, "d" + std::to_string(i)));
+            build(child, fanout, depth - 1);
+        }
+    }
+
+    std::shared_ptr<disk_tree::Node> getRoot() override { return disk_tree::Node::makeDir("/", ""); }
+    disk_tree::NodeList getChildren(const std::string& path) override {
+        return disk_tree::NodeList::fromNodes(dirs[path]);
+    }
+    void getChildrenAsync(const std::string& path, std::function<void(disk_tree::NodeList)> cb) override {
+        if (!async) {
+            cb(getChildren(path));
+            return;
+        }
+        ++inFlight;
+        peak = std::max(peak, inFlight);
+        QTimer::singleShot(2, [this, path, cb]() {
+            --inFlight;
+            cb(getChildren(path));
+        });
+    }
+};
+
+}  // namespace
+
+TEST_CASE("TreeWalker visits every directory with bounded concurrency") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    FakeTree tree(3, 3);
+
+    TreeWalker walker(tree, 4);
+    walker.add("/");
+    std::set<std::string> visited;
+    REQUIRE(walker.run([&](const std::string& path, const TreeWalker::Children& children, bool ok) {
+        REQUIRE(ok);
+        REQUIRE(children.size() == tree.dirs[path].size());
+        visited.insert(path);
+        return true;
+    }, {}));
+    REQUIRE(visited.size() == tree.dirs.size());
+    REQUIRE(walker.listedCount() == static_cast<int>(tree.dirs.size()));
+    REQUIRE(tree.peak == 4);
+}
+
+TEST_CASE("TreeWalker works with a repository that answers synchronously") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    FakeTree tree(2, 4);
+    tree.async = false;
+
+    TreeWalker walker(tree);
+    walker.add("/");
+    int visits = 0;
+    REQUIRE(walker.run([&](const std::string&, const TreeWalker::Children&, bool) { return ++visits > 0; }, {}));
+    REQUIRE(visits == static_cast<int>(tree.dirs.size()));
+}
+
+TEST_CASE("TreeWalker without auto-descend only lists directories the visitor adds") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    FakeTree tree(3, 2);
+
+    TreeWalker walker(tree, 2);
+    walker.setDescendIntoDirs(false);
+    walker.add("/");
+    std::set<std::string> visited;
+    REQUIRE(walker.run([&](const std::string& path, const TreeWalker::Children& children, bool) {
+        visited.insert(path);
+        for (disk_tree::NodeRef n : children)
+            if (n.isDir() && n.name() == "d0") walker.add(n.path());
+        return true;
+    }, {}));
+    REQUIRE(visited == std::set<std::string>{"/", "/d0", "/d0/d0"});
+}
+
+TEST_CASE("TreeWalker stops when the visitor or the stop flag says so") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    FakeTree tree(4, 3);
+
+    TreeWalker aborting(tree);
+    aborting.add("/");
+    int visits = 0;
+    REQUIRE_FALSE(aborting.run([&](const std::string&, const TreeWalker::Children&, bool) { return ++visits < 3; }, {}));
+    REQUIRE(visits == 3);
+    REQUIRE(tree.inFlight == 0);
+
+    bool stop = false;
+    TreeWalker stopped(tree);
+    stopped.add("/");
+    REQUIRE_FALSE(stopped.run([&](const std::string&, const TreeWalker::Children&, bool) {
+        stop = true;
+        return true;
+    }, [&stop]() { return stop; }));
+    REQUIRE(stopped.listedCount() < static_cast<int>(tree.dirs.size()));
+}
+
+TEST_CASE("TreeWalker addAfter lists a path only once its step proceeds") {
+    int argc = 0;
+    QCoreApplication app(argc, nullptr);
+    FakeTree tree(3, 2);
+
+    TreeWalker walker(tree, 2);
+    walker.setDescendIntoDirs(false);
+    walker.add("/");
+    int steps = 0;
+    std::set<std::string> visited;
+    REQUIRE(walker.run([&](const std::string& path, const TreeWalker::Children& children, bool) {
+        visited.insert(path);
+        for (disk_tree::NodeRef n : children) {
+            if (!n.isDir()) continue;
+            const bool proceed = n.name() == "d1";
+            walker.addAfter(n.path(), [&steps, proceed](std::function<void(bool)> done) {
+                ++steps;
+                QTimer::singleShot(2, [done, proceed]() { done(proceed); });
+            });
+        }
+        return true;
+    }, {}));
+    REQUIRE(visited == std::set<std::string>{"/", "/d1", "/d1/d1"});
+    REQUIRE(steps == 6);
+}